@@ -1,3 +1,4 @@
+#include <stdlib.h>
 #include "dberror.h"
 #include "btree_mgr.h"
 #include "storage_mgr.h"
@@ -68,23 +69,55 @@ bool isGreater(Value * key1, Value * key2);
 bool isEqual(Value * key1, Value * key2);
 
 Btree_Manager * treeManager = NULL; // store index manager metadata
+BM_BufferPool * indexPool = NULL; // shared buffer pool the indexes are attached to
+int ownsIndexPool = 0; // set when the pool was created by initIndexManager
+const int INDEX_POOL_PAGES = 1000; // frames of the buffer pool all indexes share
 
-// Function to initialize Index Manager
+// Function to initialize Index Manager, the indexes cache their pages in "mgmtData" if it is a pool made by
+// initSharedBufferPool, e.g. the one passed to initRecordManager, else in a shared pool of their own
 RC initIndexManager(void *mgmtData) {
+	RC result;
 	initStorageManager();
+	if (mgmtData != NULL) {
+		indexPool = (BM_BufferPool *) mgmtData;
+		ownsIndexPool = 0;
+		return RC_OK;
+	}
+	indexPool = MAKE_POOL();
+	if ((result = initSharedBufferPool(indexPool, INDEX_POOL_PAGES, PAGE_SIZE, RS_FIFO, NULL)) != RC_OK) {
+		free(indexPool);
+		indexPool = NULL;
+		return result;
+	}
+	ownsIndexPool = 1;
 	return RC_OK;
 }
 
-// Function to Shutdown Index Manager
+// Function to Shutdown Index Manager, fails and keeps the pool it created while an index is still open,
+// so the caller can close its indexes and call it again
 RC shutdownIndexManager() {
+	RC result;
+	if (indexPool != NULL && ownsIndexPool) {
+		if ((result = shutdownBufferPool(indexPool)) != RC_OK)
+			return result;
+		free(indexPool);
+	}
 	treeManager = NULL;
+	indexPool = NULL;
+	ownsIndexPool = 0;
 	return RC_OK;
 }
 
 // Function to create B+ Tree with name "idxId"
 
 RC createBtree(char *idxId, DataType keyType, int n) {
-	int maxNodes = PAGE_SIZE / sizeof(Node);
+	return createBtreeWithPageSize(idxId, keyType, n, PAGE_SIZE);
+}
+
+// Function to create B+ Tree with name "idxId" on pages of "pageSize" bytes, larger pages allow a higher order
+
+RC createBtreeWithPageSize(char *idxId, DataType keyType, int n, int pageSize) {
+	int maxNodes = pageSize / sizeof(Node);
 	printf("Creating BTree");
 	if (n > maxNodes) {
 		return RC_ORDER_TOO_HIGH_FOR_PAGE;
@@ -100,14 +133,14 @@ RC createBtree(char *idxId, DataType keyType, int n) {
 	treeManager->bufferPool = *bm;
 	SM_FileHandle fileHandler;
 	RC result;
-	char data[PAGE_SIZE];
-	if ((result = createPageFile(idxId)) != RC_OK)
-		return result;
-	if ((result = openPageFile(idxId, &fileHandler)) != RC_OK)
-		return result;
-	if ((result = writeBlock(0, &fileHandler, data)) != RC_OK)
-		return result;
-	if ((result = closePageFile(&fileHandler)) != RC_OK)
+	char *data = (char *) calloc(pageSize, sizeof(char));
+	result = createPageFileWithOptions(idxId, pageSize, 0);
+	if (result == RC_OK && (result = openPageFile(idxId, &fileHandler)) == RC_OK) {
+		result = writeBlock(0, &fileHandler, data);
+		closePageFile(&fileHandler);
+	}
+	free(data);
+	if (result != RC_OK)
 		return result;
 	printf(" \n Created Btree \n");
 	return (RC_OK);
@@ -118,7 +151,12 @@ RC openBtree(BTreeHandle **tree, char *idxId) {
 	*tree = (BTreeHandle *) malloc(sizeof(BTreeHandle)); // Retrieve B+ Tree handle and assign metadata structure
 	(*tree)->mgmtData = treeManager;
 	printf("\n inside open btree");
-	RC result = initBufferPool(&treeManager->bufferPool, idxId, 1000, RS_FIFO, NULL);
+	// an index the shared pool cannot take, e.g. one with another page size, gets a pool of its own
+	RC result = RC_ERROR;
+	if (indexPool != NULL)
+		result = attachBufferPool(&treeManager->bufferPool, indexPool, idxId);
+	if (result != RC_OK)
+		result = initBufferPool(&treeManager->bufferPool, idxId, INDEX_POOL_PAGES, RS_FIFO, NULL);
 	printf("\n buffer pool init"); 
 	if (result == RC_OK) {
 		printf("\n openBtree SUCCESS");
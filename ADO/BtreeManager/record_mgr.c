@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include "record_mgr.h"
 #include "buffer_mgr.h"
 #include "storage_mgr.h"
@@ -12,30 +13,102 @@ typedef struct RecordManager // data structure to make use of Record Manager.
 	BM_BufferPool bufferPool;	
 	RID recordID;
 	Expr *condition; // stores total number of tuples in the table
-	int countTuples;
-	int freePage;
+	RM_TableStats stats; // the counts the header page holds, kept up to date in memory
+	int freePage; // no data page below it has a free slot
 	int countScan;
 } RecordManager;
 
+// Struct TableHeader starts the header page 0 of a table, the name, data type and length of each attribute follow it.
+// The fields up to keySize never change, the others are copied from the RecordManager on closeTable and checkpointTable.
+typedef struct TableHeader
+{
+	int countTuples;
+	int freePage;
+	int numAttr;
+	int keySize;
+	int numPages;
+	int deadSlots;
+} TableHeader;
+
+// Free-space map (FSM) pages keep one fill class byte per data page. Page 1 of a table is an FSM page for the pageSize
+// data pages after it, the page after those is the next FSM page and so on. A data page of class 0 holds no record,
+// one of class FSM_FULL turned a record away, the classes in between grow with the share of the page in use.
+#define FSM_FULL 255
+
+// Struct DataPageHeader starts every data page of a table. It is followed by the slot directory, an array of SlotEntry
+// that grows up, while the heap holding the records grows down from the end of the page. The free space lies in between.
+typedef struct DataPageHeader
+{
+	int numSlots; // entries of the slot directory, 0 on a zero filled page
+	int usedSlots; // entries whose slot holds a record or a forwarding pointer
+	int heapStart; // offset of the first byte of the heap, 0 until the page is formatted
+	int liveBytes; // heap bytes taken by records, the rest of the heap is garbage compactPage reclaims
+} DataPageHeader;
+
+// Struct SlotEntry locates the record of a slot on its page, a free slot has offset 0
+typedef struct SlotEntry
+{
+	unsigned short offset;
+	unsigned short length;
+} SlotEntry;
+
+// A record is stored in its encoded form, see encodeRecord, whose first byte tells how the slot is used:
+#define SLOT_RECORD '+' // the record itself
+#define SLOT_FORWARD '>' // a forwarding pointer, the page and slot the record grew into
+#define SLOT_MOVED '<' // a record that grew out of its page, the page and slot it belongs to come before the attributes
+
+// bytes of a forwarding pointer, no slot holds fewer so that every record can turn into one
+#define FORWARD_SIZE (1 + 2 * (int)sizeof(int))
+
+// insertRecords fills this many new pages before it writes them with one batched write
+#define BULK_BATCH_PAGES 64
+
 const int MAX_NUMBER_OF_PAGES = 100;
+const int SHARED_POOL_PAGES = 1000; // frames of the buffer pool all tables share
 const int ATTRIBUTE_SIZE = 15; // Size of the name of the attribute
 
-RecordManager *rManager;
+BM_BufferPool *sharedPool = NULL; // pool the tables are attached to
+int ownsSharedPool = 0; // set when the pool was created by initRecordManager
 
 /*  FUNCTION NAME : initRecordManager
-    DESCRIPTION   : To Initialize Record Manager */
+    DESCRIPTION   : To Initialize Record Manager. The tables cache their pages in one shared buffer pool, which is
+                    "mgmtData" if the caller passes one made by initSharedBufferPool, else a pool of SHARED_POOL_PAGES frames */
 extern RC initRecordManager (void *mgmtData)
 {
+	RC result;
 	initStorageManager();
+	if(mgmtData != NULL)
+	{
+		sharedPool = (BM_BufferPool *) mgmtData;
+		ownsSharedPool = 0;
+		return RC_OK;
+	}
+	sharedPool = MAKE_POOL();
+	if((result = initSharedBufferPool(sharedPool, SHARED_POOL_PAGES, PAGE_SIZE, RS_LRU, NULL)) != RC_OK)
+	{
+		free(sharedPool);
+		sharedPool = NULL;
+		return result;
+	}
+	ownsSharedPool = 1;
 	return RC_OK;
 }
 
-/*  FUNCTION NAME : initRecordManager
-    DESCRIPTION   : To shut down the Record Manager */
+/*  FUNCTION NAME : shutdownRecordManager
+    DESCRIPTION   : To shut down the Record Manager. The pool it created can only be shut down once every table was closed,
+                    while a table is open the error of shutdownBufferPool is returned and the pool is kept, so the caller
+                    can close its tables and call it again. */
 extern RC shutdownRecordManager ()
 {
-	rManager = NULL;
-	free(rManager);
+	RC result;
+	if(sharedPool != NULL && ownsSharedPool)
+	{
+		if((result = shutdownBufferPool(sharedPool)) != RC_OK)
+			return result;
+		free(sharedPool);
+	}
+	sharedPool = NULL;
+	ownsSharedPool = 0;
 	return RC_OK;
 }
 
@@ -44,21 +117,24 @@ extern RC shutdownRecordManager ()
                 
 extern RC createTable (char *name, Schema *schema)
 {
-	
-	rManager = (RecordManager*) malloc(sizeof(RecordManager)); // Allocate memory space to the record manager data structure
-	initBufferPool(&rManager->bufferPool, name, MAX_NUMBER_OF_PAGES, RS_LRU, NULL); // Initalize Buffer Pool using LFU page replacement policy
-    
-	char info[PAGE_SIZE];
-	char *pageHandle = info; 
+	return createTableWithPageSize(name, schema, PAGE_SIZE);
+}
+
+/*  FUNCTION NAME : createTableWithPageSize
+    DESCRIPTION   : To create a TABLE like createTable whose pages are "pageSize" bytes, larger pages hold more records each  */
+
+extern RC createTableWithPageSize (char *name, Schema *schema, int pageSize)
+{
+	char *info = (char *) calloc(pageSize, sizeof(char));
+	char *pageHandle = info + sizeof(TableHeader);
+	TableHeader *header = (TableHeader *)info;
 	int result, k;
-	*(int*)pageHandle = 0;  // Intializing number of tuples to 0
-	pageHandle = pageHandle + sizeof(int);
-	*(int*)pageHandle = 1;  // Intializing first page to one
-	pageHandle = pageHandle + sizeof(int);
-	*(int*)pageHandle = schema->numAttr;
-	pageHandle = pageHandle + sizeof(int); 
-	*(int*)pageHandle = schema->keySize;
-	pageHandle = pageHandle + sizeof(int);
+	header->countTuples = 0;  // Intializing number of tuples to 0
+	header->freePage = 1;  // Intializing first page to one
+	header->numAttr = schema->numAttr;
+	header->keySize = schema->keySize;
+	header->numPages = 2; // the header page and the first FSM page, whose entries start out 0
+	header->deadSlots = 0;
 	for(k = 0; k < schema->numAttr; k++)
     {
        	strncpy(pageHandle, schema->attrNames[k], ATTRIBUTE_SIZE);
@@ -69,37 +145,49 @@ extern RC createTable (char *name, Schema *schema)
 	    pageHandle = pageHandle + sizeof(int);
     }
 	SM_FileHandle fileHandle;
-	if((result = createPageFile(name)) != RC_OK) // Create a page file name as table name using storage manager
-		return result;
-	if((result = openPageFile(name, &fileHandle)) != RC_OK) // Open the newly created page
-		return result;
-	if((result = writeBlock(0, &fileHandle, info)) != RC_OK) // Writing the schema to first location of the page file
-		return result;
-	if((result = closePageFile(&fileHandle)) != RC_OK) // Close the file after writing
-		return result;
-	return RC_OK;
+	result = createPageFileWithOptions(name, pageSize, 0); // Create a page file name as table name using storage manager
+	if(result == RC_OK && (result = openPageFile(name, &fileHandle)) == RC_OK) // Open the newly created page
+	{
+		result = writeBlock(0, &fileHandle, info); // Writing the schema to first location of the page file
+		closePageFile(&fileHandle); // Close the file after writing
+	}
+	free(info);
+	return result;
 }
 
 /*  FUNCTION NAME : openTable
-    DESCRIPTION   : To open the table with table name "name"  */
+    DESCRIPTION   : To open the table with table name "name". Its pages are cached in the shared pool of the record manager,
+                    a table whose page size differs gets a pool of its own. The statistics are read from the header page. */
 
 extern RC openTable (RM_TableData *rel, char *name)
 {
+	RecordManager *rManager = (RecordManager*) malloc(sizeof(RecordManager)); // Allocate memory space to the record manager data structure
 	SM_PageHandle pageHandle;    
+	TableHeader *header;
 	int countAttributes, k;
+	RC result = (sharedPool != NULL) ? attachBufferPool(&rManager->bufferPool, sharedPool, name) : RC_ERROR;
+	if(result == RC_ERROR) // no shared pool, or one with another page size
+		result = initBufferPool(&rManager->bufferPool, name, MAX_NUMBER_OF_PAGES, RS_LRU, NULL);
+	if(result != RC_OK)
+	{
+		free(rManager);
+		return result;
+	}
 	rel->mgmtData = rManager; // Setting table's meta data to record manager meta data structure
 	rel->name = name; // Setting the table's name
 	pinPage(&rManager->bufferPool, &rManager->pageHandle, 0); //Pinning a page
-	pageHandle = (char*) rManager->pageHandle.data;
-	rManager->countTuples= *(int*)pageHandle;
-	pageHandle = pageHandle + sizeof(int);
-	rManager->freePage= *(int*) pageHandle;
-    pageHandle = pageHandle + sizeof(int);
-    countAttributes = *(int*)pageHandle;
-	pageHandle = pageHandle + sizeof(int);
+	header = (TableHeader *)rManager->pageHandle.data;
+	rManager->stats.numTuples = header->countTuples;
+	rManager->stats.numPages = header->numPages;
+	rManager->stats.deadSlots = header->deadSlots;
+	rManager->freePage = header->freePage;
+	countAttributes = header->numAttr;
+	pageHandle = (char*) rManager->pageHandle.data + sizeof(TableHeader);
 	Schema *schema;
 	schema = (Schema*) malloc(sizeof(Schema)); //Allocating memory space to 'schema'
 	schema->numAttr = countAttributes;
+	schema->keySize = header->keySize;
+	schema->keyAttrs = NULL;
 	schema->attrNames = (char**) malloc(sizeof(char*) *countAttributes);
 	schema->dataTypes = (DataType*) malloc(sizeof(DataType) *countAttributes);
 	schema->typeLength = (int*) malloc(sizeof(int) *countAttributes);
@@ -116,20 +204,66 @@ extern RC openTable (RM_TableData *rel, char *name)
 	}
 	rel->schema = schema; //Initialising  newly created schema to the table's schema
 	unpinPage(&rManager->bufferPool, &rManager->pageHandle); // Unpinning the page
-	forcePage(&rManager->bufferPool, &rManager->pageHandle);
 	return RC_OK;
 }   
-  
+
+/*  FUNCTION NAME : writeTableHeader
+    DESCRIPTION   : copies the statistics of the table to its header page in the buffer pool, which is only dirtied when
+                    one of them changed since the last time */
+
+static void writeTableHeader(RecordManager *rManager)
+{
+	BM_PageHandle page;
+	TableHeader *header;
+	pinPage(&rManager->bufferPool, &page, 0);
+	header = (TableHeader *)page.data;
+	if(header->countTuples != rManager->stats.numTuples || header->freePage != rManager->freePage ||
+	   header->numPages != rManager->stats.numPages || header->deadSlots != rManager->stats.deadSlots)
+	{
+		header->countTuples = rManager->stats.numTuples;
+		header->freePage = rManager->freePage;
+		header->numPages = rManager->stats.numPages;
+		header->deadSlots = rManager->stats.deadSlots;
+		markDirty(&rManager->bufferPool, &page);
+	}
+	unpinPage(&rManager->bufferPool, &page);
+}
+
 /*  FUNCTION NAME : closeTable
-    DESCRIPTION   : To close the table as pointed by the parameter 'rel'  */
+    DESCRIPTION   : To close the table as pointed by the parameter 'rel'. The statistics go to the header page and the
+                    pages of the table are written back. Fails if a page of the table is still pinned. */
 
 extern RC closeTable (RM_TableData *rel)
 {
 	RecordManager *rManager = rel->mgmtData; // Store the table's meta data
-	shutdownBufferPool(&rManager->bufferPool); // shutdown Buffer Pool
+	RC result;
+	int k;
+	writeTableHeader(rManager);
+	if((result = shutdownBufferPool(&rManager->bufferPool)) != RC_OK) // shutdown Buffer Pool
+		return result;
+	free(rManager);
+	for(k = 0; k < rel->schema->numAttr; k++) // the schema openTable made
+		free(rel->schema->attrNames[k]);
+	free(rel->schema->attrNames);
+	free(rel->schema->dataTypes);
+	free(rel->schema->typeLength);
+	free(rel->schema);
+	rel->mgmtData = NULL;
+	rel->schema = NULL;
 	return RC_OK;
 }
 
+/*  FUNCTION NAME : checkpointTable
+    DESCRIPTION   : writes the statistics to the header page and every dirty page of the table back to its file, so that
+                    the file on disk is up to date while the table stays open */
+
+extern RC checkpointTable (RM_TableData *rel)
+{
+	RecordManager *rManager = rel->mgmtData;
+	writeTableHeader(rManager);
+	return forceFlushPool(&rManager->bufferPool);
+}
+
 /*  FUNCTION NAME : deleteTable
     DESCRIPTION   : deletes the table with name specified by the parameter 'name'  */
 
@@ -139,23 +273,434 @@ extern RC deleteTable (char *name)
 	return RC_OK;
 }
 
-int findFreeSlot(char *data, int recordSize)
+/*  FUNCTION NAME : encodeRecord
+    DESCRIPTION   : stores the attributes of "data", a record in the fixed width layout of "schema", in "encoded" after the
+                    byte telling the slot use. A string keeps its length in one byte, two if it may be longer than 255 bytes,
+                    and only the characters before its terminating '\0'. Returns the bytes of the encoded record. */
+
+static int encodeRecord(Schema *schema, char *data, char *encoded)
+{
+	int i, length, offset = 1, size = 1;
+	unsigned short wideLength;
+	for(i = 0; i < schema->numAttr; i++)
+	{
+		switch(schema->dataTypes[i])
+		{
+			case DT_STRING:
+				length = strnlen(data + offset, schema->typeLength[i]);
+				if(schema->typeLength[i] <= 255)
+					encoded[size++] = (unsigned char) length;
+				else
+				{
+					wideLength = length;
+					memcpy(encoded + size, &wideLength, sizeof(wideLength));
+					size = size + sizeof(wideLength);
+				}
+				memcpy(encoded + size, data + offset, length);
+				size = size + length;
+				offset = offset + schema->typeLength[i];
+				break;
+			case DT_INT:
+				memcpy(encoded + size, data + offset, sizeof(int));
+				size = size + sizeof(int);
+				offset = offset + sizeof(int);
+				break;
+			case DT_FLOAT:
+				memcpy(encoded + size, data + offset, sizeof(float));
+				size = size + sizeof(float);
+				offset = offset + sizeof(float);
+				break;
+			case DT_BOOL:
+				memcpy(encoded + size, data + offset, sizeof(bool));
+				size = size + sizeof(bool);
+				offset = offset + sizeof(bool);
+				break;
+		}
+	}
+	return size;
+}
+
+/*  FUNCTION NAME : decodeRecord
+    DESCRIPTION   : restores the attributes encodeRecord stored in "encoded" to "data" in the fixed width layout of "schema",
+                    the strings padded with '\0'. The first byte of "data" is left alone. */
+
+static void decodeRecord(Schema *schema, char *encoded, char *data)
+{
+	int i, length, offset = 1, size = 1;
+	unsigned short wideLength;
+	for(i = 0; i < schema->numAttr; i++)
+	{
+		switch(schema->dataTypes[i])
+		{
+			case DT_STRING:
+				if(schema->typeLength[i] <= 255)
+					length = (unsigned char) encoded[size++];
+				else
+				{
+					memcpy(&wideLength, encoded + size, sizeof(wideLength));
+					length = wideLength;
+					size = size + sizeof(wideLength);
+				}
+				memcpy(data + offset, encoded + size, length);
+				memset(data + offset + length, '\0', schema->typeLength[i] - length);
+				size = size + length;
+				offset = offset + schema->typeLength[i];
+				break;
+			case DT_INT:
+				memcpy(data + offset, encoded + size, sizeof(int));
+				size = size + sizeof(int);
+				offset = offset + sizeof(int);
+				break;
+			case DT_FLOAT:
+				memcpy(data + offset, encoded + size, sizeof(float));
+				size = size + sizeof(float);
+				offset = offset + sizeof(float);
+				break;
+			case DT_BOOL:
+				memcpy(data + offset, encoded + size, sizeof(bool));
+				size = size + sizeof(bool);
+				offset = offset + sizeof(bool);
+				break;
+		}
+	}
+}
+
+/*  FUNCTION NAME : encodedRecordSize
+    DESCRIPTION   : returns the most bytes a record of "schema" takes encoded, "shortest" = 1 the fewest, with every string empty.
+                    Both count the page and slot a moved record carries. */
+
+static int encodedRecordSize(Schema *schema, int shortest)
+{
+	int i, size = 1 + 2 * sizeof(int);
+	for(i = 0; i < schema->numAttr; i++)
+	{
+		if(schema->dataTypes[i] == DT_STRING)
+			size = size + (schema->typeLength[i] <= 255 ? 1 : 2) + (shortest ? 0 : schema->typeLength[i]);
+		else
+			size = size + (schema->dataTypes[i] == DT_BOOL ? sizeof(bool) : sizeof(int));
+	}
+	return size;
+}
+
+/*  FUNCTION NAME : slotEntry
+    DESCRIPTION   : returns the directory entry of slot "slot" of the data page "data" */
+
+static SlotEntry *slotEntry(char *data, int slot)
+{
+	return (SlotEntry *)(data + sizeof(DataPageHeader)) + slot;
+}
+
+/*  FUNCTION NAME : slotUsed
+    DESCRIPTION   : tells whether slot "slot" of the data page "data" holds a record or a forwarding pointer */
+
+static int slotUsed(char *data, int slot)
 {
-	int i, totalSpace = PAGE_SIZE / recordSize; 
+	if(slot < 0 || slot >= ((DataPageHeader *)data)->numSlots)
+		return 0;
+	return slotEntry(data, slot)->offset != 0;
+}
+
+/*  FUNCTION NAME : nextUsedSlot
+    DESCRIPTION   : returns the first slot from "slot" on of the data page "data" that is in use, -1 if there is none */
 
-	for (i = 0; i < totalSpace; i++)
-		if (data[i * recordSize] != '+')
-			return i;
+static int nextUsedSlot(char *data, int slot)
+{
+	int numSlots = ((DataPageHeader *)data)->numSlots;
+	for(; slot < numSlots; slot++)
+		if(slotEntry(data, slot)->offset != 0)
+			return slot;
 	return -1;
 }
 
+/*  FUNCTION NAME : freeEntries
+    DESCRIPTION   : returns the free slots in the directory of the data page "data", those deletes left that inserts reuse */
+
+static int freeEntries(char *data)
+{
+	DataPageHeader *header = (DataPageHeader *)data;
+	return header->numSlots - header->usedSlots;
+}
+
+/*  FUNCTION NAME : pageFreeSpace
+    DESCRIPTION   : returns the bytes of the data page "data" of "pageSize" bytes neither the slot directory nor a record takes */
+
+static int pageFreeSpace(char *data, int pageSize)
+{
+	DataPageHeader *header = (DataPageHeader *)data;
+	return pageSize - (int)sizeof(DataPageHeader) - header->numSlots * (int)sizeof(SlotEntry) - header->liveBytes;
+}
+
+/*  FUNCTION NAME : compactPage
+    DESCRIPTION   : moves the records of the data page "data" to the end of the page, so that the garbage deletes and
+                    updates left in the heap joins the free space. The slots keep their numbers. */
+
+static void compactPage(char *data, int pageSize)
+{
+	DataPageHeader *header = (DataPageHeader *)data;
+	char *copy = (char *) malloc(pageSize);
+	SlotEntry *entry;
+	int slot, heapStart = pageSize;
+	memcpy(copy, data, pageSize);
+	for(slot = 0; slot < header->numSlots; slot++)
+	{
+		entry = slotEntry(data, slot);
+		if(entry->offset == 0)
+			continue;
+		heapStart = heapStart - entry->length;
+		memcpy(data + heapStart, copy + entry->offset, entry->length);
+		entry->offset = heapStart;
+	}
+	header->heapStart = heapStart;
+	free(copy);
+}
+
+/*  FUNCTION NAME : allocateSlot
+    DESCRIPTION   : makes room for "length" bytes in the heap of the data page "data" and gives them to slot "slot", a free
+                    slot, or to the first free slot if "slot" is -1. The directory grows to a slot past its end.
+                    A zero filled page is formatted first. Returns the slot, -1 if the page lacks the room. */
+
+static int allocateSlot(char *data, int pageSize, int slot, int length)
+{
+	DataPageHeader *header = (DataPageHeader *)data;
+	SlotEntry *entry;
+	int newEntries;
+	if(header->heapStart == 0)
+		header->heapStart = pageSize;
+	if(slot == -1 && header->usedSlots == header->numSlots)
+		slot = header->numSlots; // no free entry in the directory, as on pages filled by inserts alone
+	else if(slot == -1)
+		for(slot = 0; slot < header->numSlots && slotEntry(data, slot)->offset != 0; slot++);
+	newEntries = (slot >= header->numSlots) ? (slot + 1 - header->numSlots) * sizeof(SlotEntry) : 0;
+	if(pageFreeSpace(data, pageSize) < length + newEntries)
+		return -1;
+	// the free space has to lie between the directory and the heap
+	if(header->heapStart - (int)sizeof(DataPageHeader) - header->numSlots * (int)sizeof(SlotEntry) < length + newEntries)
+		compactPage(data, pageSize);
+	for(; header->numSlots <= slot; header->numSlots++)
+		slotEntry(data, header->numSlots)->offset = 0;
+	header->heapStart = header->heapStart - length;
+	entry = slotEntry(data, slot);
+	entry->offset = header->heapStart;
+	entry->length = length;
+	header->liveBytes = header->liveBytes + length;
+	header->usedSlots++;
+	return slot;
+}
+
+/*  FUNCTION NAME : freeSlot
+    DESCRIPTION   : frees slot "slot" of the data page "data", its bytes stay in the heap as garbage. Free entries at the end
+                    of the directory are dropped, a page without records starts its heap over. */
+
+static void freeSlot(char *data, int pageSize, int slot)
+{
+	DataPageHeader *header = (DataPageHeader *)data;
+	SlotEntry *entry = slotEntry(data, slot);
+	header->liveBytes = header->liveBytes - entry->length;
+	header->usedSlots--;
+	entry->offset = 0;
+	while(header->numSlots > 0 && slotEntry(data, header->numSlots - 1)->offset == 0)
+		header->numSlots--;
+	if(header->usedSlots == 0)
+		header->heapStart = pageSize;
+}
+
+/*  FUNCTION NAME : putRecord
+    DESCRIPTION   : stores the "length" bytes of "encoded" in a free slot of the data page "data", taking at least FORWARD_SIZE
+                    bytes. Returns the slot, -1 if the page lacks the room. */
+
+static int putRecord(char *data, int pageSize, char *encoded, int length)
+{
+	int slot = allocateSlot(data, pageSize, -1, (length > FORWARD_SIZE) ? length : FORWARD_SIZE);
+	if(slot != -1)
+		memcpy(data + slotEntry(data, slot)->offset, encoded, length);
+	return slot;
+}
+
+/*  FUNCTION NAME : fsmPage
+    DESCRIPTION   : returns the FSM page holding the fill class of data page "page" of a table with pages of "pageSize" bytes */
+
+static int fsmPage(int page, int pageSize)
+{
+	return 1 + (page - 1) / (pageSize + 1) * (pageSize + 1);
+}
+
+/*  FUNCTION NAME : isDataPage
+    DESCRIPTION   : tells whether page "page" of a table with pages of "pageSize" bytes holds records, that is neither the
+                    header page nor an FSM page */
+
+static int isDataPage(int page, int pageSize)
+{
+	return page > 0 && fsmPage(page, pageSize) != page;
+}
+
+/*  FUNCTION NAME : fillClass
+    DESCRIPTION   : returns the FSM byte of the data page "data" of "pageSize" bytes, FSM_FULL if the page cannot take
+                    a record of "shortest" bytes */
+
+static int fillClass(char *data, int pageSize, int shortest)
+{
+	int usable = pageSize - sizeof(DataPageHeader), freeSpace = pageFreeSpace(data, pageSize);
+	if(((DataPageHeader *)data)->usedSlots == 0)
+		return 0;
+	if(freeSpace < shortest + (int)sizeof(SlotEntry))
+		return FSM_FULL;
+	return 1 + (int)((long)(usable - freeSpace) * (FSM_FULL - 2) / usable);
+}
+
+/*  FUNCTION NAME : fillClassRoom
+    DESCRIPTION   : returns the most free bytes a data page of "pageSize" bytes in fill class "fillClass" may have */
+
+static int fillClassRoom(int fillClass, int pageSize)
+{
+	int usable = pageSize - sizeof(DataPageHeader);
+	if(fillClass == 0)
+		return usable;
+	return usable - (int)((long)(fillClass - 1) * usable / (FSM_FULL - 2));
+}
+
+/*  FUNCTION NAME : getFillClass
+    DESCRIPTION   : returns the FSM byte of data page "page" */
+
+static int getFillClass(RecordManager *rManager, int page)
+{
+	BM_PageHandle fsm;
+	int pageSize = rManager->bufferPool.pageSize, fillClass;
+	pinPage(&rManager->bufferPool, &fsm, fsmPage(page, pageSize));
+	fillClass = (unsigned char) fsm.data[page - fsm.pageNum - 1];
+	unpinPage(&rManager->bufferPool, &fsm);
+	return fillClass;
+}
+
+/*  FUNCTION NAME : setFillClass
+    DESCRIPTION   : stores "fillClass" as the FSM byte of data page "page", the FSM page is only dirtied when the byte changes */
+
+static void setFillClass(RecordManager *rManager, int page, int fillClass)
+{
+	BM_PageHandle fsm;
+	int pageSize = rManager->bufferPool.pageSize;
+	unsigned char *entry;
+	pinPage(&rManager->bufferPool, &fsm, fsmPage(page, pageSize));
+	entry = (unsigned char *) fsm.data + (page - fsm.pageNum - 1);
+	if(*entry != fillClass)
+	{
+		*entry = fillClass;
+		markDirty(&rManager->bufferPool, &fsm);
+	}
+	unpinPage(&rManager->bufferPool, &fsm);
+	if(fillClass != FSM_FULL && page < rManager->freePage)
+		rManager->freePage = page;
+}
+
+/*  FUNCTION NAME : findFreePage
+    DESCRIPTION   : returns the first data page that may have "length" free bytes. The search starts at freePage, below which
+                    every page is full, and reads the FSM pages 8 entries per step over the full pages. A page passed over
+                    for lack of room counts as full until a delete frees some of it, so that later inserts skip it as well.
+                    The entries of pages past the end of the table are 0. */
+
+static int findFreePage(RecordManager *rManager, int length)
+{
+	BM_PageHandle fsm;
+	int pageSize = rManager->bufferPool.pageSize, entry, dirty;
+	unsigned char *entries;
+	uint64_t word;
+	if(!isDataPage(rManager->freePage, pageSize))
+		rManager->freePage++;
+	for(;;)
+	{
+		pinPage(&rManager->bufferPool, &fsm, fsmPage(rManager->freePage, pageSize));
+		entries = (unsigned char *) fsm.data;
+		entry = rManager->freePage - fsm.pageNum - 1;
+		dirty = 0;
+		while(entry < pageSize)
+		{
+			if(entries[entry] != FSM_FULL)
+			{
+				if(fillClassRoom(entries[entry], pageSize) >= length)
+					break;
+				entries[entry] = FSM_FULL;
+				dirty = 1;
+			}
+			else if(entry % 8 == 0 && entry + 8 <= pageSize)
+			{
+				memcpy(&word, entries + entry, sizeof(word));
+				if(word == ~(uint64_t)0) // 8 full pages in a row
+				{
+					entry += 8;
+					continue;
+				}
+			}
+			entry++;
+		}
+		if(dirty)
+			markDirty(&rManager->bufferPool, &fsm);
+		unpinPage(&rManager->bufferPool, &fsm);
+		if(entry < pageSize)
+			return rManager->freePage = fsm.pageNum + 1 + entry;
+		rManager->freePage = fsm.pageNum + pageSize + 2; // first data page after the next FSM page
+	}
+}
+
+/*  FUNCTION NAME : placeRecord
+    DESCRIPTION   : stores the "length" bytes of "encoded" on the first page with room for them and returns its page and slot
+                    in "id". Pages the caller holds pinned stay in place. */
+
+static void placeRecord(RecordManager *rManager, Schema *schema, char *encoded, int length, RID *id)
+{
+	BM_PageHandle page;
+	int pageSize = rManager->bufferPool.pageSize, shortest = encodedRecordSize(schema, 1);
+	int room = ((length > FORWARD_SIZE) ? length : FORWARD_SIZE) + sizeof(SlotEntry);
+	do
+	{
+		// the FSM names a page that may have room, a page that has not counts as full from now on
+		id->page = findFreePage(rManager, room);
+		pinPage(&rManager->bufferPool, &page, id->page);
+		rManager->stats.deadSlots = rManager->stats.deadSlots - freeEntries(page.data);
+		id->slot = putRecord(page.data, pageSize, encoded, length);
+		rManager->stats.deadSlots = rManager->stats.deadSlots + freeEntries(page.data);
+		if(id->slot != -1)
+			markDirty(&rManager->bufferPool, &page);
+		setFillClass(rManager, id->page, (id->slot == -1) ? FSM_FULL : fillClass(page.data, pageSize, shortest));
+		unpinPage(&rManager->bufferPool, &page);
+	} while(id->slot == -1);
+	if(id->page >= rManager->stats.numPages)
+		rManager->stats.numPages = id->page + 1;
+}
+
+/*  FUNCTION NAME : dropMovedRecord
+    DESCRIPTION   : frees the slot the forwarding pointer "forward" leads to */
+
+static void dropMovedRecord(RecordManager *rManager, Schema *schema, char *forward)
+{
+	BM_PageHandle page;
+	RID moved;
+	memcpy(&moved.page, forward + 1, sizeof(int));
+	memcpy(&moved.slot, forward + 1 + sizeof(int), sizeof(int));
+	pinPage(&rManager->bufferPool, &page, moved.page);
+	rManager->stats.deadSlots = rManager->stats.deadSlots - freeEntries(page.data);
+	freeSlot(page.data, rManager->bufferPool.pageSize, moved.slot);
+	rManager->stats.deadSlots = rManager->stats.deadSlots + freeEntries(page.data);
+	markDirty(&rManager->bufferPool, &page);
+	setFillClass(rManager, moved.page, fillClass(page.data, rManager->bufferPool.pageSize, encodedRecordSize(schema, 1)));
+	unpinPage(&rManager->bufferPool, &page);
+}
+
 /*  FUNCTION NAME : getNumTuples
     DESCRIPTION   : It returns the number of tuples in the table referenced by parameter 'rel'  */
 
 extern int getNumTuples (RM_TableData *rel)
 {
 	RecordManager *rManager = rel->mgmtData; // Access data structure's tuplesCount and return it
-	return rManager->countTuples;
+	return rManager->stats.numTuples;
+}
+
+/*  FUNCTION NAME : getTableStats
+    DESCRIPTION   : copies the statistics of the table referenced by 'rel' to "stats", they are kept in memory */
+
+extern RC getTableStats (RM_TableData *rel, RM_TableStats *stats)
+{
+	RecordManager *rManager = rel->mgmtData;
+	*stats = rManager->stats;
+	return RC_OK;
 }
 
 /*  FUNCTION NAME : RC insertRecord
@@ -165,32 +710,122 @@ extern int getNumTuples (RM_TableData *rel)
 extern RC insertRecord (RM_TableData *rel, Record *record)
 {
 	RecordManager *rManager = rel->mgmtData;	// Retrieve meta data stored in the table
-	RID *recordID = &record->id;  // Initialising the Record ID for this record
-	char *info, *pointerToSlots;
-	int recordSize = getRecordSize(rel->schema); // Getting the size in bytes needed to store on record for the given schema
-	recordID->page = rManager->freePage;
-	pinPage(&rManager->bufferPool, &rManager->pageHandle, recordID->page); // Pinning a page
-	info = rManager->pageHandle.data;
-	recordID->slot = findFreeSlot(info, recordSize); // getting free slot
-	while(recordID->slot == -1)
+	char *encoded = (char *) malloc(encodedRecordSize(rel->schema, 0));
+	int length = encodeRecord(rel->schema, record->data, encoded); // the record takes only the bytes of its strings
+	if(((length > FORWARD_SIZE) ? length : FORWARD_SIZE) + (int)sizeof(SlotEntry) > rManager->bufferPool.pageSize - (int)sizeof(DataPageHeader))
 	{
-		unpinPage(&rManager->bufferPool, &rManager->pageHandle);	
-		recordID->page++;
-		pinPage(&rManager->bufferPool, &rManager->pageHandle, recordID->page);		
-		info = rManager->pageHandle.data;
-		recordID->slot = findFreeSlot(info, recordSize);
+		free(encoded);
+		return RC_WRITE_FAILED; // the record does not fit on a page
 	}
-	pointerToSlots = info;
-	markDirty(&rManager->bufferPool, &rManager->pageHandle); // Mark page dirty to notify that the page was modified
-	pointerToSlots = pointerToSlots + (recordID->slot * recordSize); // Calculating slot starting position
-	*pointerToSlots = '+'; // Appending '+' as tombstone to indicate this is a new record and should be removed if space is lesss
-	memcpy(++pointerToSlots, record->data + 1, recordSize - 1); // Copy the record's data to the memory location pointed by slotPointer
-	unpinPage(&rManager->bufferPool, &rManager->pageHandle); // Unpinning a page
-	rManager->countTuples++;
-	pinPage(&rManager->bufferPool, &rManager->pageHandle, 0); // pin back the page
+	encoded[0] = SLOT_RECORD;
+	placeRecord(rManager, rel->schema, encoded, length, &record->id);
+	free(encoded);
+	rManager->stats.numTuples++;
 	return RC_OK;
 }
 
+/*  FUNCTION NAME : encodeForPage
+    DESCRIPTION   : encodes "record" like insertRecord stores it and returns its length, -1 if it does not fit on a page */
+
+static int encodeForPage(Schema *schema, Record *record, char *encoded, int pageSize)
+{
+	int length = encodeRecord(schema, record->data, encoded);
+	encoded[0] = SLOT_RECORD;
+	if(((length > FORWARD_SIZE) ? length : FORWARD_SIZE) + (int)sizeof(SlotEntry) > pageSize - (int)sizeof(DataPageHeader))
+		return -1;
+	return length;
+}
+
+/*  FUNCTION NAME : RC insertRecords
+    DESCRIPTION   : Inserts the "numRecords" records of "records" like insertRecord, setting their Record IDs.
+                    The pages the FSM names are filled first, each pinned once for as many records as it takes. The rest
+                    go on new pages built outside the buffer pool and written BULK_BATCH_PAGES at a time around its frames.
+                    If a record does not fit on a page the records before it stay inserted and RC_WRITE_FAILED is returned. */
+
+extern RC insertRecords (RM_TableData *rel, Record **records, int numRecords)
+{
+	RecordManager *rManager = rel->mgmtData;
+	BM_PageHandle page;
+	int pageSize = rManager->bufferPool.pageSize, shortest = encodedRecordSize(rel->schema, 1);
+	int i = 0, length = -1, slot = -1, pageNum, firstPage, numBatch, numPut, k;
+	char *encoded = (char *) malloc(encodedRecordSize(rel->schema, 0)), *batch[BULK_BATCH_PAGES];
+	RC result = RC_OK;
+
+	// length is that of records[i] once it is encoded, -1 before
+	while(i < numRecords)
+	{
+		if(length == -1 && (length = encodeForPage(rel->schema, records[i], encoded, pageSize)) == -1)
+			break;
+		pageNum = findFreePage(rManager, ((length > FORWARD_SIZE) ? length : FORWARD_SIZE) + sizeof(SlotEntry));
+		if(pageNum >= rManager->stats.numPages)
+			break; // only new pages are left
+		pinPage(&rManager->bufferPool, &page, pageNum);
+		rManager->stats.deadSlots = rManager->stats.deadSlots - freeEntries(page.data);
+		for(numPut = 0; (slot = putRecord(page.data, pageSize, encoded, length)) != -1; numPut++)
+		{
+			records[i]->id.page = pageNum;
+			records[i]->id.slot = slot;
+			length = -1;
+			if(++i == numRecords || (length = encodeForPage(rel->schema, records[i], encoded, pageSize)) == -1)
+				break;
+		}
+		rManager->stats.deadSlots = rManager->stats.deadSlots + freeEntries(page.data);
+		if(numPut > 0)
+			markDirty(&rManager->bufferPool, &page);
+		setFillClass(rManager, pageNum, (slot == -1) ? FSM_FULL : fillClass(page.data, pageSize, shortest));
+		unpinPage(&rManager->bufferPool, &page);
+		if(length == -1 && i < numRecords)
+			break;
+	}
+
+	for(k = 0; k < BULK_BATCH_PAGES; k++)
+		batch[k] = (char *) malloc(pageSize);
+	for(pageNum = rManager->stats.numPages; i < numRecords && length != -1; pageNum = pageNum + numBatch)
+	{
+		if(!isDataPage(pageNum, pageSize))
+		{
+			getFillClass(rManager, pageNum + 1); // the new FSM page comes into the pool ahead of its pages
+			pageNum++;
+		}
+		// a batch is a run of neighbouring data pages, it ends at the next FSM page
+		firstPage = pageNum;
+		for(numBatch = 0; numBatch < BULK_BATCH_PAGES && i < numRecords && length != -1 && isDataPage(firstPage + numBatch, pageSize); numBatch++)
+		{
+			memset(batch[numBatch], 0, pageSize);
+			while((slot = putRecord(batch[numBatch], pageSize, encoded, length)) != -1)
+			{
+				records[i]->id.page = firstPage + numBatch;
+				records[i]->id.slot = slot;
+				length = -1;
+				if(++i == numRecords || (length = encodeForPage(rel->schema, records[i], encoded, pageSize)) == -1)
+					break;
+			}
+		}
+		if(writePages(&rManager->bufferPool, firstPage, numBatch, batch) != RC_OK)
+		{
+			// a pool that cannot write around its frames takes the pages like any other
+			for(k = 0; k < numBatch; k++)
+			{
+				pinPage(&rManager->bufferPool, &page, firstPage + k);
+				memcpy(page.data, batch[k], pageSize);
+				markDirty(&rManager->bufferPool, &page);
+				unpinPage(&rManager->bufferPool, &page);
+			}
+		}
+		for(k = 0; k < numBatch; k++)
+			setFillClass(rManager, firstPage + k, (k < numBatch - 1) ? FSM_FULL : fillClass(batch[k], pageSize, shortest));
+		rManager->stats.numPages = firstPage + numBatch;
+	}
+	for(k = 0; k < BULK_BATCH_PAGES; k++)
+		free(batch[k]);
+	free(encoded);
+
+	if(i < numRecords)
+		result = RC_WRITE_FAILED; // records[i] does not fit on a page
+	rManager->stats.numTuples = rManager->stats.numTuples + i;
+	return result;
+}
+
 /*  FUNCTION NAME : RC deleteRecord
     DESCRIPTION   : deletes a record having Record ID 'id' passed through the parameter from the table referenced by the parameter 'rel'.  */
 
@@ -198,32 +833,99 @@ extern RC insertRecord (RM_TableData *rel, Record *record)
 extern RC deleteRecord (RM_TableData *rel, RID id)
 {
 	RecordManager *rManager = rel->mgmtData;
+	if(!isDataPage(id.page, rManager->bufferPool.pageSize))
+		return RC_RM_NO_TUPLE_WITH_GIVEN_RID;
 	pinPage(&rManager->bufferPool, &rManager->pageHandle, id.page);
-	rManager->freePage = id.page;
 	char *info = rManager->pageHandle.data;
-	int recordSize = getRecordSize(rel->schema); // Getting the size of the record
-	info = info + (id.slot * recordSize); // Setting data pointer to the specific slot of the record
-	*info = '-'; // '-' is used for Tombstone mechanism. It denotes that the record is deleted
+	if(!slotUsed(info, id.slot) || info[slotEntry(info, id.slot)->offset] == SLOT_MOVED)
+	{
+		unpinPage(&rManager->bufferPool, &rManager->pageHandle);
+		return RC_RM_NO_TUPLE_WITH_GIVEN_RID;
+	}
+	if(info[slotEntry(info, id.slot)->offset] == SLOT_FORWARD)
+		dropMovedRecord(rManager, rel->schema, info + slotEntry(info, id.slot)->offset);
+	rManager->stats.deadSlots = rManager->stats.deadSlots - freeEntries(info);
+	freeSlot(info, rManager->bufferPool.pageSize, id.slot); // the record bytes are left behind until the page is compacted
+	rManager->stats.deadSlots = rManager->stats.deadSlots + freeEntries(info);
 	markDirty(&rManager->bufferPool, &rManager->pageHandle); // Marking the page dirty
+	setFillClass(rManager, id.page, fillClass(info, rManager->bufferPool.pageSize, encodedRecordSize(rel->schema, 1)));
 	unpinPage(&rManager->bufferPool, &rManager->pageHandle);
+	rManager->stats.numTuples--;
 	return RC_OK;
 }
 
 /*  FUNCTION NAME : RC updateRecord
-    DESCRIPTION   : updates a record referenced by the parameter "record" in the table referenced by the parameter "rel".  */
+    DESCRIPTION   : updates a record referenced by the parameter "record" in the table referenced by the parameter "rel".
+                    A record that grows takes the free space of its page, compacted if need be. If the page lacks the room
+                    the record moves to another page and leaves a forwarding pointer in its slot. */
 
 extern RC updateRecord (RM_TableData *rel, Record *record)
 {	
 	RecordManager *rManager = rel->mgmtData;
+	if(!isDataPage(record->id.page, rManager->bufferPool.pageSize))
+		return RC_RM_NO_TUPLE_WITH_GIVEN_RID;
 	pinPage(&rManager->bufferPool, &rManager->pageHandle, record->id.page);
-	char *info;
-	int recordSize = getRecordSize(rel->schema);
-	RID id = record->id;
+	char *info, *encoded;
+	int pageSize = rManager->bufferPool.pageSize, length, stored, oldLength;
+	RID id = record->id, moved;
+	SlotEntry *entry;
 	info = rManager->pageHandle.data; // Getting record data's memory location and calculating the start position of the new data
-	info = info + (id.slot * recordSize);
-	*info = '+';
-	memcpy(++info, record->data + 1, recordSize - 1 );
+	if(!slotUsed(info, id.slot) || info[slotEntry(info, id.slot)->offset] == SLOT_MOVED)
+	{
+		unpinPage(&rManager->bufferPool, &rManager->pageHandle);
+		return RC_RM_NO_TUPLE_WITH_GIVEN_RID;
+	}
+	entry = slotEntry(info, id.slot);
+	encoded = (char *) malloc(encodedRecordSize(rel->schema, 0));
+	length = encodeRecord(rel->schema, record->data, encoded);
+	encoded[0] = SLOT_RECORD; // becomes SLOT_FORWARD below if the record has to move
+	stored = (length > FORWARD_SIZE) ? length : FORWARD_SIZE;
+	if(length - 1 + FORWARD_SIZE + (int)sizeof(SlotEntry) > pageSize - (int)sizeof(DataPageHeader) && pageFreeSpace(info, pageSize) + entry->length < stored)
+	{
+		// the record neither grows in place nor fits on any page it could move to
+		free(encoded);
+		unpinPage(&rManager->bufferPool, &rManager->pageHandle);
+		return RC_WRITE_FAILED;
+	}
+	if(info[entry->offset] == SLOT_FORWARD) // the record comes home if it fits, else it moves again
+		dropMovedRecord(rManager, rel->schema, info + entry->offset);
+	oldLength = entry->length;
+	if(stored <= oldLength) // the record shrinks in place
+	{
+		entry->length = stored;
+		((DataPageHeader *)info)->liveBytes -= oldLength - stored;
+	}
+	else
+	{
+		// give up the old bytes, then take the free space of the page, compacted if it is scattered
+		freeSlot(info, pageSize, id.slot);
+		if(allocateSlot(info, pageSize, id.slot, stored) == -1)
+		{
+			// the record moves to another page and its slot keeps the way there. The slot is taken back before the
+			// record looks for a page, and the FSM learns the room left, as the home page may be the one it finds
+			if(allocateSlot(info, pageSize, id.slot, FORWARD_SIZE) == -1)
+			{
+				// the old record took at least FORWARD_SIZE bytes and its directory entries, so this cannot happen
+				free(encoded);
+				unpinPage(&rManager->bufferPool, &rManager->pageHandle);
+				return RC_WRITE_FAILED;
+			}
+			setFillClass(rManager, id.page, fillClass(info, pageSize, encodedRecordSize(rel->schema, 1)));
+			encoded[0] = SLOT_MOVED;
+			memmove(encoded + FORWARD_SIZE, encoded + 1, length - 1);
+			memcpy(encoded + 1, &id.page, sizeof(int));
+			memcpy(encoded + 1 + sizeof(int), &id.slot, sizeof(int));
+			placeRecord(rManager, rel->schema, encoded, length - 1 + FORWARD_SIZE, &moved);
+			encoded[0] = SLOT_FORWARD;
+			memcpy(encoded + 1, &moved.page, sizeof(int));
+			memcpy(encoded + 1 + sizeof(int), &moved.slot, sizeof(int));
+			length = FORWARD_SIZE;
+		}
+	}
+	memcpy(info + slotEntry(info, id.slot)->offset, encoded, length);
+	free(encoded);
 	markDirty(&rManager->bufferPool, &rManager->pageHandle);
+	setFillClass(rManager, id.page, fillClass(info, pageSize, encodedRecordSize(rel->schema, 1)));
 	unpinPage(&rManager->bufferPool, &rManager->pageHandle);
 	return RC_OK;	
 }
@@ -235,20 +937,28 @@ extern RC updateRecord (RM_TableData *rel, Record *record)
 extern RC getRecord (RM_TableData *rel, RID id, Record *record)
 {
 	RecordManager *rManager = rel->mgmtData;
+	if(!isDataPage(id.page, rManager->bufferPool.pageSize))
+		return RC_RM_NO_TUPLE_WITH_GIVEN_RID;
 	pinPage(&rManager->bufferPool, &rManager->pageHandle, id.page); // Pinning the page which has the record we want to retreive
-	int recordSize = getRecordSize(rel->schema);
 	char *dataPointer = rManager->pageHandle.data;
-	dataPointer = dataPointer + (id.slot * recordSize);
-	if(*dataPointer != '+')
+	if(!slotUsed(dataPointer, id.slot) || dataPointer[slotEntry(dataPointer, id.slot)->offset] == SLOT_MOVED)
 	{
+		unpinPage(&rManager->bufferPool, &rManager->pageHandle);
 		return RC_RM_NO_TUPLE_WITH_GIVEN_RID; // Return error if no matching record for Record ID 'id' is found in the table
 	}
-	else
+	dataPointer = dataPointer + slotEntry(dataPointer, id.slot)->offset;
+	if(*dataPointer == SLOT_FORWARD) // follow the forwarding pointer to the page the record moved to
 	{
-		record->id = id;
-		char *info = record->data; // Setting the pointer to data field of 'record' so that we can copy the data of the record
-		memcpy(++info, dataPointer + 1, recordSize - 1);
+		RID moved;
+		memcpy(&moved.page, dataPointer + 1, sizeof(int));
+		memcpy(&moved.slot, dataPointer + 1 + sizeof(int), sizeof(int));
+		unpinPage(&rManager->bufferPool, &rManager->pageHandle);
+		pinPage(&rManager->bufferPool, &rManager->pageHandle, moved.page);
+		dataPointer = rManager->pageHandle.data + slotEntry(rManager->pageHandle.data, moved.slot)->offset;
+		dataPointer = dataPointer + FORWARD_SIZE - 1; // the attributes follow the page and slot of its home
 	}
+	record->id = id;
+	decodeRecord(rel->schema, dataPointer, record->data);
 	unpinPage(&rManager->bufferPool, &rManager->pageHandle);
 	return RC_OK;
 }
@@ -263,17 +973,13 @@ extern RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond)
 	{
 		return RC_SCAN_CONDITION_NOT_FOUND;
 	}
-	openTable(rel, "ScanTable"); // Open the table in memory
     RecordManager *scanManager;
-	RecordManager *tableManager;
 	scanManager = (RecordManager*) malloc(sizeof(RecordManager)); // Allocating memory to the scanManager
     scan->mgmtData = scanManager;
     scanManager->recordID.page = 1; // start scan from the first page
     scanManager->recordID.slot = 0; // start scan from the first slot
 	scanManager->countScan = 0;
 	scanManager->condition = cond; // Setting the scan condition
-    tableManager = rel->mgmtData; // Setting the our meta data to the table's meta data
-	tableManager->countTuples = ATTRIBUTE_SIZE; // Setting tuple count
 	scan->rel= rel; // Setting the table which has to be scanned using the specified condition
 	return RC_OK;
 }
@@ -292,48 +998,45 @@ extern RC next (RM_ScanHandle *scan, Record *record)
 	{
 		return RC_SCAN_CONDITION_NOT_FOUND;
 	}
-	Value *result = (Value *) malloc(sizeof(Value));
+	Value *result = (Value *) calloc(1, sizeof(Value));
 	char *info;
-	int recordSize = getRecordSize(schema);
-	int totalSpace = PAGE_SIZE / recordSize;
-	int countScan = scanManager->countScan;
-	int countTuples = tableManager->countTuples;
-	if (countTuples == 0) // Checking if the table contains tuples. If the tables doesn't have tuple, then return respective message code
-		return RC_RM_NO_MORE_TUPLES;
-	while(countScan <= countTuples)
-	{  
-		if (countScan <= 0) // If all the tuples have been scanned, execute this block
-		{
-			scanManager->recordID.page = 1;
-			scanManager->recordID.slot = 0;
-		}
-		else
+	int slot;
+	// recordID is the next slot to look at, the slot directory of each data page leads to its records
+	for(; scanManager->recordID.page < tableManager->stats.numPages; scanManager->recordID.page++, scanManager->recordID.slot = 0)
+	{
+		// the FSM tells the pages without a record apart, the scan does not read them
+		if(!isDataPage(scanManager->recordID.page, tableManager->bufferPool.pageSize) || getFillClass(tableManager, scanManager->recordID.page) == 0)
+			continue;
+		pinPage(&tableManager->bufferPool, &scanManager->pageHandle, scanManager->recordID.page);
+		info = scanManager->pageHandle.data;
+		while((slot = nextUsedSlot(info, scanManager->recordID.slot)) != -1)
 		{
-			scanManager->recordID.slot++;
-			if(scanManager->recordID.slot >= totalSpace) // If all the slots have been scanned execute this block
+			char *dataPointer = info + slotEntry(info, slot)->offset;
+			scanManager->recordID.slot = slot + 1;
+			if(*dataPointer == SLOT_FORWARD) // a record that moved is met on the page it moved to
+				continue;
+			record->id.page = scanManager->recordID.page;
+			record->id.slot = slot;
+			if(*dataPointer == SLOT_MOVED) // and keeps the id of its home slot
 			{
-				scanManager->recordID.slot = 0;
-				scanManager->recordID.page++;
+				memcpy(&record->id.page, dataPointer + 1, sizeof(int));
+				memcpy(&record->id.slot, dataPointer + 1 + sizeof(int), sizeof(int));
+				dataPointer = dataPointer + FORWARD_SIZE - 1;
+			}
+			record->data[0] = '-';
+			decodeRecord(schema, dataPointer, record->data);
+			scanManager->countScan++;
+			evalExpr(record, schema, scanManager->condition, &result);  // Test the record for the specified condition (test expression)
+			if(result->v.boolV == TRUE) // v.boolV is TRUE if the record satisfies the condition
+			{
+				freeVal(result);
+				unpinPage(&tableManager->bufferPool, &scanManager->pageHandle);
+				return RC_OK;
 			}
 		}
-		pinPage(&tableManager->bufferPool, &scanManager->pageHandle, scanManager->recordID.page);			
-		info = scanManager->pageHandle.data;
-		info = info + (scanManager->recordID.slot * recordSize); // Calulate the data location from record's slot and record size
-		record->id.page = scanManager->recordID.page;
-		record->id.slot = scanManager->recordID.slot;
-		char *dataPointer = record->data;
-		*dataPointer = '-';
-		memcpy(++dataPointer, info + 1, recordSize - 1);
-		scanManager->countScan++;
-		countScan++;
-		evalExpr(record, schema, scanManager->condition, &result);  // Test the record for the specified condition (test expression)
-		if(result->v.boolV == TRUE) // v.boolV is TRUE if the record satisfies the condition
-		{
-			unpinPage(&tableManager->bufferPool, &scanManager->pageHandle);		
-			return RC_OK;
-		}
+		unpinPage(&tableManager->bufferPool, &scanManager->pageHandle);
 	}
-	unpinPage(&tableManager->bufferPool, &scanManager->pageHandle);
+	freeVal(result);
 	scanManager->recordID.page = 1;
 	scanManager->recordID.slot = 0;
 	scanManager->countScan = 0;
@@ -347,16 +1050,8 @@ extern RC next (RM_ScanHandle *scan, Record *record)
 extern RC closeScan (RM_ScanHandle *scan)
 {
 	RecordManager *scanManager = scan->mgmtData;
-	RecordManager *rManager = scan->rel->mgmtData;
-	if(scanManager->countScan > 0) // Check if scan was incomplete
-	{
-		unpinPage(&rManager->bufferPool, &scanManager->pageHandle);
-		scanManager->countScan = 0; // Reset the Scan Manager's values
-		scanManager->recordID.page = 1;
-		scanManager->recordID.slot = 0;
-	}
-    scan->mgmtData = NULL; // De-allocate all the memory space allocated to the scans's meta data
-    free(scan->mgmtData);  
+	free(scanManager); // next() holds no page between calls, only the scan's meta data is left to free
+	scan->mgmtData = NULL;
 	return RC_OK;
 }
 
@@ -12,17 +12,29 @@ typedef struct RM_ScanHandle
 	void *mgmtData;
 } RM_ScanHandle;
 
+// Statistics of a table, kept in memory while it is open and stored in its header page by closeTable and checkpointTable
+typedef struct RM_TableStats
+{
+	int numPages; // pages of the table file in use, the header and FSM pages included
+	int numTuples; // records in the table
+	int deadSlots; // slots deletes freed that inserts have not taken again
+} RM_TableStats;
+
 // table and manager
 extern RC initRecordManager (void *mgmtData);
 extern RC shutdownRecordManager ();
 extern RC createTable (char *name, Schema *schema);
+extern RC createTableWithPageSize (char *name, Schema *schema, int pageSize);
 extern RC openTable (RM_TableData *rel, char *name);
 extern RC closeTable (RM_TableData *rel);
 extern RC deleteTable (char *name);
 extern int getNumTuples (RM_TableData *rel);
+extern RC getTableStats (RM_TableData *rel, RM_TableStats *stats);
+extern RC checkpointTable (RM_TableData *rel);
 
 // handling records in a table
 extern RC insertRecord (RM_TableData *rel, Record *record);
+extern RC insertRecords (RM_TableData *rel, Record **records, int numRecords);
 extern RC deleteRecord (RM_TableData *rel, RID id);
 extern RC updateRecord (RM_TableData *rel, Record *record);
 extern RC getRecord (RM_TableData *rel, RID id, Record *record);
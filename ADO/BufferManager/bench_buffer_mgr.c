@@ -0,0 +1,784 @@
+#include "storage_mgr.h"
+#include "buffer_mgr.h"
+#include "dberror.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/* benchmark page file */
+#define BENCHPF "benchbuffer.bin"
+
+/* number of timed operations per measurement */
+#define NUM_PINS 1000000
+#define NUM_EVICTIONS 200000
+#define NUM_SCANS 2000
+
+/* scan + point lookup trace: lookups hit a hot set smaller than the pool, every SCAN_EVERY-th request reads the next page of a table scan */
+#define TRACE_POOL_SIZE 100
+#define TRACE_HOT_PAGES 80
+#define TRACE_SCAN_PAGES 1000
+#define TRACE_SCAN_EVERY 4
+#define TRACE_LENGTH 200000
+
+/* background writer: every request dirties a random page of a file much larger than the pool, then the client thinks for a while */
+#define WRITER_POOL_SIZE 64
+#define WRITER_FILE_PAGES 1024
+#define WRITER_REQUESTS 5000
+#define WRITER_THINK_US 50
+
+/* concurrent pins: threads share one pool with every page cached and split the pin/unpin pairs between them */
+#define CONCURRENT_POOL_SIZE 1024
+#define CONCURRENT_PINS 1000000
+#define MAX_THREADS 32
+
+/* sequential scan: a pool too small for read-ahead against one that reads SCAN_POOL_SIZE / 4 pages ahead, the file is
+   evicted from the OS page cache before each scan where the file system allows it. The scan sums the bytes of every page,
+   which overlaps with the read-ahead in flight */
+#define SCAN_FILE_PAGES 8192
+#define SCAN_SMALL_POOL_SIZE 7
+#define SCAN_POOL_SIZE 128
+
+/* flush: every frame of the pool holds a dirty page, written one page at a time by forcePage or all at once by forceFlushPool */
+#define FLUSH_POOL_SIZE 1024
+
+/* page writes: the storage manager writes binary pages straight to the file, first appending them in order, then
+   overwriting them in random order */
+#define WRITE_FILE_PAGES 16384
+
+/* direct I/O: a SCAN_POOL_SIZE frame pool scans a SCAN_FILE_PAGES file and then looks up DIRECT_LOOKUPS random pages,
+   once through the OS page cache and once around it */
+#define DIRECT_LOOKUPS 20000
+
+/* checksums: WRITE_FILE_PAGES pages are appended and DIRECT_LOOKUPS random pages read back with and without page checksums,
+   through the OS page cache, where the checksum cost shows most, and around it, where the device dominates */
+
+/* compression: a SCAN_POOL_SIZE frame pool fills SCAN_FILE_PAGES pages with fixed width rows of ROW_SIZE bytes, an int key,
+   a zero padded string and a float like the record manager stores them, then scans them back from the device. The file
+   is written once plain and once compressed */
+#define ROW_SIZE 64
+
+/* prototypes for benchmark functions */
+static void benchPinHit(void);
+static void benchLRUEviction(void);
+static void benchScanResistance(void);
+static void benchBackgroundWriter(void);
+static void benchConcurrentPins(void);
+static void benchSequentialScan(void);
+static void benchFlush(void);
+static void benchMappedLookup(void);
+static void benchPageWrites(void);
+static void benchDirectIO(void);
+static void benchChecksums(void);
+static void benchCompression(void);
+
+/* helpers */
+static double elapsedNs(struct timespec *start, struct timespec *end);
+static int scanLeastHit(int *hitNums, int *fixCounts, int numPages);
+static int compareDouble(const void *a, const void *b);
+static void *pinWorker(void *arg);
+
+/* work handed to each thread of the concurrent pin benchmark */
+typedef struct PinWork {
+  BM_BufferPool *bm;
+  int numPins;
+  unsigned int seed;
+} PinWork;
+
+/* main function running all benchmarks */
+int
+main (void)
+{
+  initStorageManager();
+
+  benchPinHit();
+  benchLRUEviction();
+  benchScanResistance();
+  benchBackgroundWriter();
+  benchConcurrentPins();
+  benchSequentialScan();
+  benchFlush();
+  benchMappedLookup();
+  benchPageWrites();
+  benchDirectIO();
+  benchChecksums();
+  benchCompression();
+
+  return 0;
+}
+
+static double
+elapsedNs(struct timespec *start, struct timespec *end)
+{
+  return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+/* pin and unpin resident pages in random order while the pool grows from 10 to 100k frames;
+   with the page table the cost per pin should stay flat */
+void
+benchPinHit(void)
+{
+  const int poolSizes[] = { 10, 100, 1000, 10000, 100000 };
+  const int numPoolSizes = 5;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  struct timespec start, end;
+  int i, s;
+
+  printf("pin hit benchmark (%i pin/unpin pairs per pool size)\n", NUM_PINS);
+  printf("%10s %14s %14s\n", "frames", "ns/pin", "pins/s");
+
+  for (s = 0; s < numPoolSizes; s++)
+    {
+      int numPages = poolSizes[s];
+
+      CHECK(createPageFile(BENCHPF));
+      CHECK(initBufferPool(bm, BENCHPF, numPages, RS_FIFO, NULL));
+
+      // fault every page in once so the timed loop only sees hits
+      for (i = 0; i < numPages; i++)
+        {
+          CHECK(pinPage(bm, h, i));
+          CHECK(unpinPage(bm, h));
+        }
+
+      srand(42);
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      for (i = 0; i < NUM_PINS; i++)
+        {
+          CHECK(pinPage(bm, h, rand() % numPages));
+          CHECK(unpinPage(bm, h));
+        }
+      clock_gettime(CLOCK_MONOTONIC, &end);
+
+      double ns = elapsedNs(&start, &end) / NUM_PINS;
+      printf("%10i %14.1f %14.0f\n", numPages, ns, 1e9 / ns);
+
+      CHECK(shutdownBufferPool(bm));
+      CHECK(destroyPageFile(BENCHPF));
+    }
+
+  free(bm);
+  free(h);
+}
+
+/* victim selection of the former LRU implementation: scan every frame for the smallest unpinned hit number */
+static int
+scanLeastHit(int *hitNums, int *fixCounts, int numPages)
+{
+  int i, least = -1;
+
+  for (i = 0; i < numPages; i++)
+    if (fixCounts[i] == 0 && (least == -1 || hitNums[i] < hitNums[least]))
+      least = i;
+  return least;
+}
+
+/* cost of a pin that has to evict under RS_LRU, compared with the frame scan the list replaced */
+void
+benchLRUEviction(void)
+{
+  const int poolSizes[] = { 1000, 10000, 100000 };
+  const int numPoolSizes = 3;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  struct timespec start, end;
+  int i, s;
+
+  printf("\nLRU eviction benchmark (%i evicting pins per pool size)\n", NUM_EVICTIONS);
+  printf("%10s %18s %22s\n", "frames", "ns/evicting pin", "ns/scan victim (old)");
+
+  for (s = 0; s < numPoolSizes; s++)
+    {
+      int numPages = poolSizes[s];
+      int *hitNums = malloc(sizeof(int) * numPages);
+      int *fixCounts = calloc(numPages, sizeof(int));
+
+      CHECK(createPageFile(BENCHPF));
+      CHECK(initBufferPool(bm, BENCHPF, numPages, RS_LRU, NULL));
+
+      for (i = 0; i < numPages; i++)
+        {
+          CHECK(pinPage(bm, h, i));
+          CHECK(unpinPage(bm, h));
+        }
+
+      // every request is for a page that is not cached, so each pin evicts the least recently used frame
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      for (i = 0; i < NUM_EVICTIONS; i++)
+        {
+          CHECK(pinPage(bm, h, numPages + i));
+          CHECK(unpinPage(bm, h));
+        }
+      clock_gettime(CLOCK_MONOTONIC, &end);
+      double listNs = elapsedNs(&start, &end) / NUM_EVICTIONS;
+
+      for (i = 0; i < numPages; i++)
+        hitNums[i] = i;
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      for (i = 0; i < NUM_SCANS; i++)
+        hitNums[scanLeastHit(hitNums, fixCounts, numPages)] = numPages + i;
+      clock_gettime(CLOCK_MONOTONIC, &end);
+      double scanNs = elapsedNs(&start, &end) / NUM_SCANS;
+
+      printf("%10i %18.1f %22.1f\n", numPages, listNs, scanNs);
+
+      CHECK(shutdownBufferPool(bm));
+      CHECK(destroyPageFile(BENCHPF));
+      free(hitNums);
+      free(fixCounts);
+    }
+
+  free(bm);
+  free(h);
+}
+
+/* replay the same scan + point lookup trace against each replacement strategy and report the hit rate */
+void
+benchScanResistance(void)
+{
+  const ReplacementStrategy strategies[] = { RS_FIFO, RS_LRU, RS_CLOCK, RS_LFU, RS_LRU_K, RS_ARC };
+  const char *names[] = { "FIFO", "LRU", "CLOCK", "LFU", "LRU-K(2)", "ARC" };
+  const int numStrategies = 6;
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  int *trace = malloc(sizeof(int) * TRACE_LENGTH);
+  int i, s, k = 2, scanPos = 0;
+
+  // hot pages are 0 .. TRACE_HOT_PAGES-1, the scanned table lives behind them
+  srand(42);
+  for (i = 0; i < TRACE_LENGTH; i++)
+    {
+      if (i % TRACE_SCAN_EVERY == TRACE_SCAN_EVERY - 1)
+        {
+          trace[i] = TRACE_HOT_PAGES + scanPos;
+          scanPos = (scanPos + 1) % TRACE_SCAN_PAGES;
+        }
+      else
+        trace[i] = rand() % TRACE_HOT_PAGES;
+    }
+
+  printf("\nscan resistance benchmark (%i frames, %i hot pages, 1 in %i requests scans %i pages)\n",
+         TRACE_POOL_SIZE, TRACE_HOT_PAGES, TRACE_SCAN_EVERY, TRACE_SCAN_PAGES);
+  printf("%10s %14s\n", "strategy", "hit rate");
+
+  for (s = 0; s < numStrategies; s++)
+    {
+      CHECK(createPageFile(BENCHPF));
+      CHECK(initBufferPool(bm, BENCHPF, TRACE_POOL_SIZE, strategies[s], &k));
+
+      for (i = 0; i < TRACE_LENGTH; i++)
+        {
+          CHECK(pinPage(bm, h, trace[i]));
+          CHECK(unpinPage(bm, h));
+        }
+      printf("%10s %13.1f%%\n", names[s], 100.0 * (TRACE_LENGTH - getNumReadIO(bm)) / TRACE_LENGTH);
+
+      CHECK(shutdownBufferPool(bm));
+      CHECK(destroyPageFile(BENCHPF));
+    }
+
+  free(trace);
+  free(bm);
+  free(h);
+}
+
+static int
+compareDouble(const void *a, const void *b)
+{
+  double x = *(const double *) a, y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+/* pin latency of a write heavy workload with and without the background writer cleaning victims during client think time */
+void
+benchBackgroundWriter(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  double *latencies = malloc(sizeof(double) * WRITER_REQUESTS);
+  struct timespec start, end, think = { 0, WRITER_THINK_US * 1000 };
+  int i, withWriter;
+
+  printf("\nbackground writer benchmark (%i frames, %i dirtying requests over %i pages, %ius think time)\n",
+         WRITER_POOL_SIZE, WRITER_REQUESTS, WRITER_FILE_PAGES, WRITER_THINK_US);
+  printf("%10s %14s %14s %14s\n", "writer", "mean ns/pin", "p99 ns/pin", "write I/Os");
+
+  for (withWriter = 0; withWriter < 2; withWriter++)
+    {
+      double total = 0;
+
+      CHECK(createPageFile(BENCHPF));
+      CHECK(initBufferPool(bm, BENCHPF, WRITER_POOL_SIZE, RS_LRU, NULL));
+      if (withWriter)
+        CHECK(startBackgroundWriter(bm));
+
+      srand(42);
+      for (i = 0; i < WRITER_REQUESTS; i++)
+        {
+          clock_gettime(CLOCK_MONOTONIC, &start);
+          CHECK(pinPage(bm, h, rand() % WRITER_FILE_PAGES));
+          clock_gettime(CLOCK_MONOTONIC, &end);
+          latencies[i] = elapsedNs(&start, &end);
+          total += latencies[i];
+
+          h->data[0]++;
+          CHECK(markDirty(bm, h));
+          CHECK(unpinPage(bm, h));
+          nanosleep(&think, NULL);
+        }
+
+      qsort(latencies, WRITER_REQUESTS, sizeof(double), compareDouble);
+      printf("%10s %14.0f %14.0f %14i\n", withWriter ? "on" : "off", total / WRITER_REQUESTS,
+             latencies[WRITER_REQUESTS * 99 / 100], getNumWriteIO(bm));
+
+      CHECK(shutdownBufferPool(bm));
+      CHECK(destroyPageFile(BENCHPF));
+    }
+
+  free(latencies);
+  free(bm);
+  free(h);
+}
+
+static void *
+pinWorker(void *arg)
+{
+  PinWork *work = (PinWork *) arg;
+  BM_PageHandle h;
+  int i;
+
+  for (i = 0; i < work->numPins; i++)
+    {
+      CHECK(pinPage(work->bm, &h, rand_r(&work->seed) % CONCURRENT_POOL_SIZE));
+      CHECK(unpinPage(work->bm, &h));
+    }
+  return NULL;
+}
+
+/* pin/unpin throughput of one pool shared by 1 to 32 threads; CLOCK hits only take a page table latch,
+   LRU hits reorder the shared list under the pool lock */
+void
+benchConcurrentPins(void)
+{
+  const ReplacementStrategy strategies[] = { RS_CLOCK, RS_LRU };
+  const char *names[] = { "CLOCK", "LRU" };
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  pthread_t threads[MAX_THREADS];
+  PinWork work[MAX_THREADS];
+  struct timespec start, end;
+  int i, s, numThreads;
+
+  printf("\nconcurrent pin benchmark (%i frames, %i pin/unpin pairs split over the threads)\n",
+         CONCURRENT_POOL_SIZE, CONCURRENT_PINS);
+  printf("%10s %10s %14s\n", "strategy", "threads", "pins/s");
+
+  for (s = 0; s < 2; s++)
+    {
+      CHECK(createPageFile(BENCHPF));
+      CHECK(initBufferPool(bm, BENCHPF, CONCURRENT_POOL_SIZE, strategies[s], NULL));
+      for (i = 0; i < CONCURRENT_POOL_SIZE; i++)
+        {
+          CHECK(pinPage(bm, h, i));
+          CHECK(unpinPage(bm, h));
+        }
+
+      for (numThreads = 1; numThreads <= MAX_THREADS; numThreads *= 2)
+        {
+          clock_gettime(CLOCK_MONOTONIC, &start);
+          for (i = 0; i < numThreads; i++)
+            {
+              work[i].bm = bm;
+              work[i].numPins = CONCURRENT_PINS / numThreads;
+              work[i].seed = 42 + i;
+              pthread_create(&threads[i], NULL, pinWorker, &work[i]);
+            }
+          for (i = 0; i < numThreads; i++)
+            pthread_join(threads[i], NULL);
+          clock_gettime(CLOCK_MONOTONIC, &end);
+
+          printf("%10s %10i %14.0f\n", names[s], numThreads,
+                 (double) (CONCURRENT_PINS / numThreads) * numThreads * 1e9 / elapsedNs(&start, &end));
+        }
+
+      CHECK(shutdownBufferPool(bm));
+      CHECK(destroyPageFile(BENCHPF));
+    }
+
+  free(bm);
+  free(h);
+}
+
+/* a full scan pins every page once in order, with read-ahead most pins hit pages read by an earlier vectored read */
+void
+benchSequentialScan(void)
+{
+  const int poolSizes[] = { SCAN_SMALL_POOL_SIZE, SCAN_POOL_SIZE };
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  SM_FileHandle fh;
+  struct timespec start, end;
+  int i, j, s;
+  unsigned long checksum = 0;
+
+  CHECK(createPageFile(BENCHPF));
+  CHECK(openPageFile(BENCHPF, &fh));
+  CHECK(ensureCapacity(SCAN_FILE_PAGES, &fh));
+  CHECK(closePageFile(&fh));
+
+  printf("\nsequential scan benchmark (%i pages)\n", SCAN_FILE_PAGES);
+  printf("%10s %14s %14s %14s\n", "frames", "ns/page", "MB/s", "read I/Os");
+
+  for (s = 0; s < 2; s++)
+    {
+      // drop the file from the OS page cache so the scan reads from the device
+      int fd = open(BENCHPF, O_RDONLY);
+      fdatasync(fd);
+      posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+      close(fd);
+
+      CHECK(initBufferPool(bm, BENCHPF, poolSizes[s], RS_LRU, NULL));
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      for (i = 0; i < SCAN_FILE_PAGES; i++)
+        {
+          CHECK(pinPage(bm, h, i));
+          for (j = 0; j < PAGE_SIZE; j++)
+            checksum += (unsigned char)h->data[j];
+          CHECK(unpinPage(bm, h));
+        }
+      clock_gettime(CLOCK_MONOTONIC, &end);
+
+      double ns = elapsedNs(&start, &end);
+      printf("%10i %14.0f %14.1f %14i\n", poolSizes[s], ns / SCAN_FILE_PAGES,
+             (double)SCAN_FILE_PAGES * PAGE_SIZE / ns * 1e3, getNumReadIO(bm));
+      CHECK(shutdownBufferPool(bm));
+    }
+
+  CHECK(destroyPageFile(BENCHPF));
+  if (checksum != 0)
+    printf("unexpected checksum %lu\n", checksum);
+  free(bm);
+  free(h);
+}
+
+/* write back a pool full of dirty pages page by page and with all writes in flight at once */
+void
+benchFlush(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  struct timespec start, end;
+  int i, batched;
+
+  printf("\nflush benchmark (%i dirty pages)\n", FLUSH_POOL_SIZE);
+  printf("%16s %14s %14s\n", "method", "ns/page", "write I/Os");
+
+  for (batched = 0; batched < 2; batched++)
+    {
+      CHECK(createPageFile(BENCHPF));
+      CHECK(initBufferPool(bm, BENCHPF, FLUSH_POOL_SIZE, RS_LRU, NULL));
+      for (i = 0; i < FLUSH_POOL_SIZE; i++)
+        {
+          CHECK(pinPage(bm, h, i));
+          memset(h->data, 'a' + i % 26, PAGE_SIZE);
+          CHECK(markDirty(bm, h));
+          CHECK(unpinPage(bm, h));
+        }
+
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      if (batched)
+        {
+          CHECK(forceFlushPool(bm));
+        }
+      else
+        {
+          for (i = 0; i < FLUSH_POOL_SIZE; i++)
+            {
+              h->pageNum = i;
+              CHECK(forcePage(bm, h));
+            }
+        }
+      clock_gettime(CLOCK_MONOTONIC, &end);
+
+      printf("%16s %14.0f %14i\n", batched ? "forceFlushPool" : "forcePage", elapsedNs(&start, &end) / FLUSH_POOL_SIZE,
+             getNumWriteIO(bm));
+      CHECK(shutdownBufferPool(bm));
+      CHECK(destroyPageFile(BENCHPF));
+    }
+
+  free(bm);
+  free(h);
+}
+
+/* random lookups in a file larger than the pool, copying each miss into a frame and pointing the frame into a mapping */
+void
+benchMappedLookup(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  SM_FileHandle fh;
+  struct timespec start, end;
+  int i, mapped;
+  unsigned long checksum = 0;
+
+  CHECK(createPageFile(BENCHPF));
+  CHECK(openPageFile(BENCHPF, &fh));
+  CHECK(ensureCapacity(SCAN_FILE_PAGES, &fh));
+  CHECK(closePageFile(&fh));
+
+  printf("\nrandom lookup benchmark (%i pins over %i pages, %i frames)\n", NUM_PINS, SCAN_FILE_PAGES, SCAN_POOL_SIZE);
+  printf("%10s %14s %14s\n", "mode", "ns/pin", "pins/s");
+
+  for (mapped = 0; mapped < 2; mapped++)
+    {
+      CHECK(initBufferPool(bm, BENCHPF, SCAN_POOL_SIZE, RS_LRU, NULL));
+      if (mapped)
+        CHECK(mapBufferPool(bm, FALSE));
+
+      srand(42);
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      for (i = 0; i < NUM_PINS; i++)
+        {
+          CHECK(pinPage(bm, h, rand() % SCAN_FILE_PAGES));
+          checksum += (unsigned char)h->data[i % PAGE_SIZE];
+          CHECK(unpinPage(bm, h));
+        }
+      clock_gettime(CLOCK_MONOTONIC, &end);
+
+      double ns = elapsedNs(&start, &end) / NUM_PINS;
+      printf("%10s %14.1f %14.0f\n", mapped ? "mmap" : "arena", ns, 1e9 / ns);
+      CHECK(shutdownBufferPool(bm));
+    }
+
+  CHECK(destroyPageFile(BENCHPF));
+  if (checksum != 0)
+    printf("unexpected checksum %lu\n", checksum);
+  free(bm);
+  free(h);
+}
+
+/* write pages holding zero bytes with writeBlock, appending in order and overwriting in random order */
+void
+benchPageWrites(void)
+{
+  SM_FileHandle fh;
+  SM_PageHandle ph = (SM_PageHandle) malloc(PAGE_SIZE);
+  struct timespec start, end;
+  int i, random;
+
+  for (i = 0; i < PAGE_SIZE; i++)
+    ph[i] = (i % 4) ? (char)i : 0;
+
+  CHECK(createPageFile(BENCHPF));
+  CHECK(openPageFile(BENCHPF, &fh));
+
+  printf("\npage write benchmark (%i pages)\n", WRITE_FILE_PAGES);
+  printf("%10s %14s %14s\n", "order", "ns/page", "MB/s");
+
+  for (random = 0; random < 2; random++)
+    {
+      srand(42);
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      for (i = 0; i < WRITE_FILE_PAGES; i++)
+        CHECK(writeBlock(random ? rand() % WRITE_FILE_PAGES : i, &fh, ph));
+      clock_gettime(CLOCK_MONOTONIC, &end);
+
+      double ns = elapsedNs(&start, &end);
+      printf("%10s %14.0f %14.1f\n", random ? "random" : "sequential", ns / WRITE_FILE_PAGES,
+             (double)WRITE_FILE_PAGES * PAGE_SIZE / ns * 1e3);
+    }
+
+  CHECK(closePageFile(&fh));
+  CHECK(destroyPageFile(BENCHPF));
+  free(ph);
+}
+
+/* scan and random lookups on a file larger than the pool with and without the OS page cache in between */
+void
+benchDirectIO(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  SM_FileHandle fh;
+  struct timespec start, end;
+  char page[PAGE_SIZE];
+  int i, direct;
+  unsigned long checksum = 0;
+
+  // pages are written out, the file system would hand out never written extents without reading them
+  CHECK(createPageFile(BENCHPF));
+  CHECK(openPageFile(BENCHPF, &fh));
+  memset(page, 0, PAGE_SIZE);
+  for (i = 0; i < SCAN_FILE_PAGES; i++)
+    CHECK(writeBlock(i, &fh, page));
+  CHECK(closePageFile(&fh));
+
+  printf("\ndirect I/O benchmark (%i pages, %i frames)\n", SCAN_FILE_PAGES, SCAN_POOL_SIZE);
+  printf("%10s %14s %14s %14s\n", "mode", "scan MB/s", "ns/lookup", "read I/Os");
+
+  for (direct = 0; direct < 2; direct++)
+    {
+      CHECK(initBufferPool(bm, BENCHPF, SCAN_POOL_SIZE, RS_LRU, NULL));
+      if (direct && directBufferPool(bm) != RC_OK)
+        {
+          printf("%10s %14s\n", "direct", "not supported");
+          CHECK(shutdownBufferPool(bm));
+          break;
+        }
+
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      for (i = 0; i < SCAN_FILE_PAGES; i++)
+        {
+          CHECK(pinPage(bm, h, i));
+          checksum += (unsigned char)h->data[i % PAGE_SIZE];
+          CHECK(unpinPage(bm, h));
+        }
+      clock_gettime(CLOCK_MONOTONIC, &end);
+      double scanNs = elapsedNs(&start, &end);
+
+      srand(42);
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      for (i = 0; i < DIRECT_LOOKUPS; i++)
+        {
+          CHECK(pinPage(bm, h, rand() % SCAN_FILE_PAGES));
+          checksum += (unsigned char)h->data[i % PAGE_SIZE];
+          CHECK(unpinPage(bm, h));
+        }
+      clock_gettime(CLOCK_MONOTONIC, &end);
+
+      printf("%10s %14.1f %14.0f %14i\n", direct ? "direct" : "buffered", (double)SCAN_FILE_PAGES * PAGE_SIZE / scanNs * 1e3,
+             elapsedNs(&start, &end) / DIRECT_LOOKUPS, getNumReadIO(bm));
+      CHECK(shutdownBufferPool(bm));
+    }
+
+  CHECK(destroyPageFile(BENCHPF));
+  if (checksum != 0)
+    printf("unexpected checksum %lu\n", checksum);
+  free(bm);
+  free(h);
+}
+
+/* append and read back pages of plain and checksummed files, buffered and direct */
+void
+benchChecksums(void)
+{
+  SM_FileHandle fh;
+  SM_PageHandle ph;
+  struct timespec start, end;
+  int i, direct, checksums;
+
+  if (posix_memalign((void **) &ph, PAGE_SIZE, PAGE_SIZE) != 0)
+    return;
+  for (i = 0; i < PAGE_SIZE; i++)
+    ph[i] = (char) (i * 7);
+
+  printf("\nchecksum benchmark (%i pages written, %i read)\n", WRITE_FILE_PAGES, DIRECT_LOOKUPS);
+  printf("%10s %12s %14s %14s\n", "mode", "checksums", "write ns/page", "read ns/page");
+
+  for (direct = 0; direct < 2; direct++)
+    for (checksums = 0; checksums < 2; checksums++)
+      {
+        CHECK(checksums ? createChecksummedPageFile(BENCHPF) : createPageFile(BENCHPF));
+        if (direct && openPageFileDirect(BENCHPF, &fh) != RC_OK)
+          {
+            printf("%10s %12s\n", "direct", "not supported");
+            CHECK(destroyPageFile(BENCHPF));
+            break;
+          }
+        if (!direct)
+          CHECK(openPageFile(BENCHPF, &fh));
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (i = 0; i < WRITE_FILE_PAGES; i++)
+          CHECK(writeBlock(i, &fh, ph));
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double writeNs = elapsedNs(&start, &end) / WRITE_FILE_PAGES;
+
+        srand(42);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (i = 0; i < DIRECT_LOOKUPS; i++)
+          CHECK(readBlock(rand() % WRITE_FILE_PAGES, &fh, ph));
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        printf("%10s %12s %14.0f %14.0f\n", direct ? "direct" : "buffered", checksums ? "crc32c" : "none", writeNs,
+               elapsedNs(&start, &end) / DIRECT_LOOKUPS);
+        CHECK(closePageFile(&fh));
+        CHECK(destroyPageFile(BENCHPF));
+      }
+
+  free(ph);
+}
+
+/* fixed width rows written and scanned through a pool, the page file plain and compressed */
+static void
+benchCompression(void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  struct timespec start, end;
+  struct stat fileInfo;
+  int i, j, compressed;
+  unsigned long checksum = 0;
+
+  printf("\ncompression benchmark (%i pages of %i byte rows)\n", SCAN_FILE_PAGES, ROW_SIZE);
+  printf("%10s %14s %14s %14s\n", "format", "write ns/page", "scan ns/page", "MB on disk");
+
+  for (compressed = 0; compressed < 2; compressed++)
+    {
+      CHECK(compressed ? createCompressedPageFile(BENCHPF) : createPageFile(BENCHPF));
+      CHECK(initBufferPool(bm, BENCHPF, SCAN_POOL_SIZE, RS_LRU, NULL));
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      for (i = 0; i < SCAN_FILE_PAGES; i++)
+        {
+          CHECK(pinPage(bm, h, i));
+          for (j = 0; j + ROW_SIZE <= PAGE_SIZE; j += ROW_SIZE)
+            {
+              int key = i * (PAGE_SIZE / ROW_SIZE) + j / ROW_SIZE;
+              float value = key * 0.5f;
+              memset(h->data + j, 0, ROW_SIZE);
+              memcpy(h->data + j, &key, sizeof(int));
+              sprintf(h->data + j + sizeof(int), "name-%i", key);
+              memcpy(h->data + j + ROW_SIZE - sizeof(float), &value, sizeof(float));
+            }
+          CHECK(markDirty(bm, h));
+          CHECK(unpinPage(bm, h));
+        }
+      CHECK(shutdownBufferPool(bm));
+      clock_gettime(CLOCK_MONOTONIC, &end);
+      double writeNs = elapsedNs(&start, &end) / SCAN_FILE_PAGES;
+
+      // drop the file from the OS page cache so the scan reads from the device
+      int fd = open(BENCHPF, O_RDONLY);
+      fdatasync(fd);
+      posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+      fstat(fd, &fileInfo);
+      close(fd);
+
+      CHECK(initBufferPool(bm, BENCHPF, SCAN_POOL_SIZE, RS_LRU, NULL));
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      for (i = 0; i < SCAN_FILE_PAGES; i++)
+        {
+          CHECK(pinPage(bm, h, i));
+          for (j = 0; j < PAGE_SIZE; j += ROW_SIZE)
+            checksum += *(int *) (h->data + j);
+          CHECK(unpinPage(bm, h));
+        }
+      clock_gettime(CLOCK_MONOTONIC, &end);
+      CHECK(shutdownBufferPool(bm));
+
+      printf("%10s %14.0f %14.0f %14.1f\n", compressed ? "compressed" : "plain", writeNs,
+             elapsedNs(&start, &end) / SCAN_FILE_PAGES, (double) fileInfo.st_blocks * 512 / (1 << 20));
+      CHECK(destroyPageFile(BENCHPF));
+    }
+
+  if (checksum != 2 * ((unsigned long) SCAN_FILE_PAGES * (PAGE_SIZE / ROW_SIZE)) * (SCAN_FILE_PAGES * (PAGE_SIZE / ROW_SIZE) - 1) / 2)
+    printf("unexpected checksum %lu\n", checksum);
+  free(bm);
+  free(h);
+}
@@ -1,26 +1,1156 @@
 #include<stdio.h>
 #include<string.h>
 #include<stdlib.h>
+#include<sys/mman.h>
+#include<pthread.h>
+#include<time.h>
 #include "buffer_mgr.h"
 #include "storage_mgr.h"
 #include <math.h>
 
+// arenas of at least this size are aligned to it and offered to the kernel for transparent huge pages
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+// LFU reference counts saturate at this value, one free list per count
+#define LFU_MAX_COUNT 32
+
+// LFU halves all reference counts after this many pins per frame
+#define LFU_AGING_FACTOR 8
+
+// K used by LRU_K when no stratData is passed, which makes it behave like LRU
+#define LRU_K_DEFAULT 1
+
+// a pin within this many pins of the previous pin of the same page is correlated and does not add to its history
+#define LRU_K_CORRELATED_PERIOD 2
+
+// the background writer cleans dirty pages among the coldest 1/WRITER_WINDOW_DIVISOR of the frames
+#define WRITER_WINDOW_DIVISOR 4
+
+// the background writer sleeps at most this long when it finds nothing to clean
+#define WRITER_INTERVAL_MS 10
+
+// this many misses on consecutive pages make a pin miss read the following pages ahead
+#define READ_AHEAD_TRIGGER 2
+
+// sequential read-ahead loads at most this many pages and at most 1/READ_AHEAD_POOL_DIVISOR of the frames at once
+#define READ_AHEAD_MAX_PAGES 32
+#define READ_AHEAD_POOL_DIVISOR 4
+
+// forceFlushPool writes at most this many neighbouring dirty pages with one vectored write
+#define FLUSH_MAX_RUN_PAGES 256
+
+// the page table is split into 2^PAGE_TABLE_PARTITION_BITS partitions, each behind its own latch
+#define PAGE_TABLE_PARTITION_BITS 4
+#define PAGE_TABLE_PARTITIONS (1 << PAGE_TABLE_PARTITION_BITS)
+
+// pin counts, CLOCK reference bits and the clock hand are also changed by pins that only hold a page table latch
+#define ATOMIC_LOAD(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define ATOMIC_STORE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELAXED)
+#define ATOMIC_ADD(x, v) __atomic_add_fetch(&(x), (v), __ATOMIC_RELAXED)
+
+// states of the background writer
+#define WRITER_STOPPED 0
+#define WRITER_RUNNING 1
+#define WRITER_STOPPING 2
+
+// a shared pool has at most this many files attached at once, see addFile
+#define MAX_POOL_FILES 256
+
+// ARC keeps the frames released without a page in a list of its own next to T1 (0) and T2 (1)
+#define ARC_EMPTY 2
+
 // Struct Page represents a page frame in buffer pool
 typedef struct Page
 {
 	SM_PageHandle info;  //used to store data 
 	PageNumber pageNum; // identity for each page
+	int fileId; // file of the pool the page belongs to, -1 while the frame holds no page
 	int dirtyBit; //page modification indicator
-	int totalCount; // number of clients using a page at the given instance
-	int hitNum;   // used for LRU replacement algorithm
+	int dirtyGen; // bumped by markDirty, tells the background writer whether the page was dirtied again while it wrote it
+	int totalCount; // number of clients using a page at the given instance, only changed atomically
+	int hitNum;   // reference bit used by CLOCK replacement algorithm, only accessed atomically
+	int prev;   // neighbour towards the most recently used end of the LRU list, -1 at the head
+	int next;   // neighbour towards the least recently used end of the LRU list, -1 at the tail
+	int refCount; // LFU reference count, halved when the pool ages
+	int freqPrev; // LFU neighbours in the list of unpinned frames with the same refCount
+	int freqNext;
+	long *history; // LRU_K times of the last K uncorrelated references, most recent first, 0 if missing
+	long lastRef; // LRU_K time of the last reference, correlated or not
+	int heapPos; // LRU_K position in the heap of unpinned frames, -1 while pinned
+	int arcList; // ARC list holding the frame, 0 for T1 (used once), 1 for T2 (used again), ARC_EMPTY if it holds no page, -1 if none
+	int arcPrev; // ARC neighbours in that list, towards the most and least recently used end
+	int arcNext;
+	int prefetched; // loaded by read-ahead and not pinned since, its first pin counts as its first reference
+	int loading; // set while loadPage reads the page without the pool lock, only changed under its partition latch
 } PageFrame;
 
+// Struct PageTableEntry maps a page of one of the pool's files to the frame caching it, or to its ARC ghost entry
+// (index == -1 marks an empty slot)
+typedef struct PageTableEntry
+{
+	int fileId;
+	PageNumber pageNum;
+	int index;
+} PageTableEntry;
+
+// Struct PageTable is an open addressing hash table of PageTableEntry
+typedef struct PageTable
+{
+	PageTableEntry *entries;
+	int mask; // table size - 1, the size is a power of two
+	int count; // entries in use, the table doubles before it gets more than half full
+} PageTable;
+
+// Struct PageTablePartition is one latched part of the page table, the top bits of a page's hash pick its partition
+typedef struct PageTablePartition
+{
+	pthread_mutex_t latch; // guards the table and every pin count change of the frames it maps to
+	PageTable table;
+} PageTablePartition;
+
+// Struct ArcList is a doubly linked list of frames or of ghost entries used by ARC, head is the most recently used end
+typedef struct ArcList
+{
+	int head;
+	int tail;
+	int size;
+} ArcList;
+
+// Struct GhostEntry remembers the file and page number of a page recently evicted by ARC
+typedef struct GhostEntry
+{
+	int fileId;
+	PageNumber pageNum;
+	int list; // 0 for B1 (evicted from T1), 1 for B2 (evicted from T2)
+	int prev;
+	int next; // also chains the free entries
+} GhostEntry;
+
+// Struct DirtyPage pairs a page forceFlushPool writes back with the frame caching it
+typedef struct DirtyPage
+{
+	PageNumber pageNum;
+	int frame;
+} DirtyPage;
+
+// Struct PoolFile is one page file whose pages a buffer pool caches, its index in BufferPoolInfo.files is its fileId
+typedef struct PoolFile
+{
+	SM_FileHandle fileHandle; // kept open while the file is attached to the pool
+	int attached; // 0 once the pool caching its pages was shut down, the entry is then reused
+	int readCount; // pages of the file read and written, reported by getNumReadIO and getNumWriteIO of an attached pool
+	int writeCount;
+	PageNumber nextSequential; // a miss on this page continues the current run of sequential misses
+	int sequentialMisses; // length of that run
+	PageNumber readAheadMark; // pinning this page starts reading the next pages ahead while the scan works through the current ones
+} PoolFile;
+
+// Struct BufferPoolInfo holds the bookkeeping of one buffer pool and is hung off BM_BufferPool.mgmtData,
+// so several pools can be used side by side. A shared pool caches the pages of every file attached to it,
+// its frames and the page table are keyed by (fileId, pageNum), see attachBufferPool.
+typedef struct BufferPoolInfo
+{
+	PageFrame *pageFrame; // page frames of the pool
+	char *arena; // numPages pages allocated once, frame i caches its page at arena + i * pageSize
+	int pageSize; // bytes in every frame, every file of the pool has pages of this size
+	int bufferCapacity; // capacity of the buffer
+	int rearIndex; // used by FIFO to calculate the front index
+	int writeCount; // calculate number of pages written to disk
+	int lruHead; // most recently pinned frame, -1 when no frame is in use
+	int lruTail; // least recently pinned frame, where LRU starts looking for a victim
+	int clockPointer; // used by CLOCK replacement algorithm to point to the last added page, only accessed atomically
+	PoolFile *files[MAX_POOL_FILES]; // files whose pages the pool caches, a pool of its own only has file 0
+	int numFiles; // entries of files allocated, in use or detached
+	int shared; // set for a pool created by initSharedBufferPool, files are attached to it with attachBufferPool
+	PageTablePartition partitions[PAGE_TABLE_PARTITIONS]; // (fileId, pageNum) to frame index
+	int latchedHits; // FIFO and CLOCK pins and unpins of cached pages only take a partition latch, see pinPage
+	int framesInUse; // frames are filled in order, so this is also the index of the next free frame
+	ReplacementStrategy strategy; // copy of bm->strategy for the helpers below
+	int lfuHead[LFU_MAX_COUNT + 1]; // most recently unpinned frame for each LFU reference count
+	int lfuTail[LFU_MAX_COUNT + 1]; // least recently unpinned frame for each LFU reference count
+	int lfuReferences; // pins since the reference counts were last halved
+	int k; // LRU_K history length
+	long refClock; // LRU_K logical clock, advanced on every pin
+	long *historyArena; // numPages * k history entries
+	int *heap; // LRU_K min heap of unpinned frames ordered by their K-th most recent reference
+	int heapSize;
+	ArcList arcResident[3]; // ARC T1 and T2, frames used once and frames used again, and the empty frames reused first
+	ArcList arcGhost[2]; // ARC B1 and B2, pages recently evicted from T1 and T2
+	GhostEntry *ghosts; // bufferCapacity ghost entries
+	int freeGhost; // first unused ghost entry, -1 if all are in use
+	PageTable ghostTable; // (fileId, pageNum) to ghost entry
+	int arcTarget; // size ARC adapts T1 towards, grown by hits in B1 and shrunk by hits in B2
+	pthread_mutex_t lock; // guards the bookkeeping above against other threads and the background writer
+	pthread_mutex_t ioLock; // serialises storage manager calls on the files, taken after lock when both are needed
+	pthread_cond_t writerWake; // signalled when a dirty page is unpinned or the writer should stop
+	pthread_cond_t pageLoaded; // broadcast when loadPage is done reading a page, pins of it wait for that
+	pthread_t writer;
+	int writerState; // WRITER_STOPPED, WRITER_RUNNING or WRITER_STOPPING
+	char *writerBuffer; // copy of the page the background writer is writing
+	int readAheadPages; // pages read ahead on a sequential miss, 0 if the pool is too small for read-ahead
+	SM_IORequest readAheadRequest; // pages being read ahead in the background, see readAhead
+	int readAheadFile; // file readAheadRequest reads from
+	int *readAheadFrames; // frames readAheadRequest reads into, NULL when no read-ahead is in flight
+	int *readAheadPromote; // for each of them whether ARC found its page in a ghost list, see takeFrame
+	int mapped; // pages are served from a mapping of the page file instead of the arena, see mapBufferPool
+} BufferPoolInfo;
+
+/*  FUNCTION NAME : pageTableInit
+    DESCRIPTION   : Allocates an empty page table for up to numEntries page numbers.
+                    The table is kept at most half full so probe runs stay short. */
+
+static void pageTableInit(PageTable *table, int numEntries)
+{
+	int i, tableSize = 1;
+	while(tableSize < 2 * numEntries)
+		tableSize <<= 1;
+	table->entries = malloc(sizeof(PageTableEntry) * tableSize);
+	table->mask = tableSize - 1;
+	table->count = 0;
+	for(i = 0; i < tableSize; i++)
+		table->entries[i].index = -1;
+}
+
+/*  FUNCTION NAME : pageHash
+    DESCRIPTION   : Hashes page pageNum of file fileId, the same page number of different files lands in different slots */
+
+static unsigned int pageHash(int fileId, PageNumber pageNum)
+{
+	return (unsigned int)pageNum * 2654435761u + (unsigned int)fileId * 2246822519u;
+}
+
+/*  FUNCTION NAME : pageTableSlot
+    DESCRIPTION   : Returns the home slot of a page in the page table */
+
+static int pageTableSlot(PageTable *table, int fileId, PageNumber pageNum)
+{
+	return (int)(pageHash(fileId, pageNum) & (unsigned int)table->mask);
+}
+
+/*  FUNCTION NAME : pageTableFind
+    DESCRIPTION   : Looks up the index stored for page pageNum of file fileId, returns -1 if the page is not in the table */
+
+static int pageTableFind(PageTable *table, int fileId, PageNumber pageNum)
+{
+	int slot = pageTableSlot(table, fileId, pageNum);
+	while(table->entries[slot].index != -1)
+	{
+		if(table->entries[slot].pageNum == pageNum && table->entries[slot].fileId == fileId)
+			return table->entries[slot].index;
+		slot = (slot + 1) & table->mask;
+	}
+	return -1;
+}
+
+/*  FUNCTION NAME : pageTableAdd
+    DESCRIPTION   : Records in the page table that page pageNum of file fileId is found at the given index */
+
+static void pageTableAdd(PageTable *table, int fileId, PageNumber pageNum, int index)
+{
+	int slot;
+	if(2 * (table->count + 1) > table->mask + 1)
+	{
+		// a partition can receive more pages than its share, so it grows instead of filling up
+		PageTable grown;
+		int i;
+		pageTableInit(&grown, table->mask + 1);
+		for(i = 0; i <= table->mask; i++)
+			if(table->entries[i].index != -1)
+				pageTableAdd(&grown, table->entries[i].fileId, table->entries[i].pageNum, table->entries[i].index);
+		free(table->entries);
+		*table = grown;
+	}
+	slot = pageTableSlot(table, fileId, pageNum);
+	while(table->entries[slot].index != -1 && (table->entries[slot].pageNum != pageNum || table->entries[slot].fileId != fileId))
+		slot = (slot + 1) & table->mask;
+	if(table->entries[slot].index == -1)
+		table->count++;
+	table->entries[slot].fileId = fileId;
+	table->entries[slot].pageNum = pageNum;
+	table->entries[slot].index = index;
+}
+
+/*  FUNCTION NAME : pageTableRemove
+    DESCRIPTION   : Drops page pageNum of file fileId from the page table. Later entries of the probe run are shifted back
+                    so lookups never need tombstones. */
+
+static void pageTableRemove(PageTable *table, int fileId, PageNumber pageNum)
+{
+	int slot = pageTableSlot(table, fileId, pageNum), next, home;
+	while(table->entries[slot].index != -1 && (table->entries[slot].pageNum != pageNum || table->entries[slot].fileId != fileId))
+		slot = (slot + 1) & table->mask;
+	if(table->entries[slot].index == -1)
+		return;
+	next = slot;
+	while(1)
+	{
+		next = (next + 1) & table->mask;
+		if(table->entries[next].index == -1)
+			break;
+		home = pageTableSlot(table, table->entries[next].fileId, table->entries[next].pageNum);
+		// move the entry back unless its home slot lies cyclically in (slot, next]
+		if((slot < next) ? (home <= slot || home > next) : (home <= slot && home > next))
+		{
+			table->entries[slot] = table->entries[next];
+			slot = next;
+		}
+	}
+	table->entries[slot].index = -1;
+	table->count--;
+}
+
+/*  FUNCTION NAME : partitionOf
+    DESCRIPTION   : Returns the page table partition a page belongs to */
+
+static PageTablePartition *partitionOf(BufferPoolInfo *pool, int fileId, PageNumber pageNum)
+{
+	return &pool->partitions[pageHash(fileId, pageNum) >> (32 - PAGE_TABLE_PARTITION_BITS)];
+}
+
+/*  FUNCTION NAME : findFrame
+    DESCRIPTION   : Looks up the frame caching page pageNum of file fileId under its partition latch,
+                    returns -1 if the page is not in the pool */
+
+static int findFrame(BufferPoolInfo *pool, int fileId, PageNumber pageNum)
+{
+	PageTablePartition *partition = partitionOf(pool, fileId, pageNum);
+	pthread_mutex_lock(&partition->latch);
+	int index = pageTableFind(&partition->table, fileId, pageNum);
+	pthread_mutex_unlock(&partition->latch);
+	return index;
+}
+
+/*  FUNCTION NAME : evictPage
+    DESCRIPTION   : Drops the page cached in a victim frame from the page table. Returns 0 and keeps the page if a
+                    latched pin got to the frame after the replacement strategy chose it. */
 
-int bufferCapacity = 0; // capacity of the buffer
-int rearIndex = 0; // used by FIFO to calculate the front index
-int writeCount = 0; // calculate number of pages written to disk
-int hit = 0; // used by LRU to determine least recently added page into the buffer pool
-int clockPointer = 0; // used by CLOCK replacement algorithm to point to the last added page
+static int evictPage(BufferPoolInfo *pool, int index)
+{
+	PageTablePartition *partition = partitionOf(pool, pool->pageFrame[index].fileId, pool->pageFrame[index].pageNum);
+	int evicted = 0;
+	pthread_mutex_lock(&partition->latch);
+	if(ATOMIC_LOAD(pool->pageFrame[index].totalCount) == 0)
+	{
+		pageTableRemove(&partition->table, pool->pageFrame[index].fileId, pool->pageFrame[index].pageNum);
+		evicted = 1;
+	}
+	pthread_mutex_unlock(&partition->latch);
+	return evicted;
+}
+
+/*  FUNCTION NAME : lruUnlink
+    DESCRIPTION   : Takes a frame out of the LRU list */
+
+static void lruUnlink(BufferPoolInfo *pool, int index)
+{
+	PageFrame *pageFrame = pool->pageFrame;
+	if(pageFrame[index].prev != -1)
+		pageFrame[pageFrame[index].prev].next = pageFrame[index].next;
+	else
+		pool->lruHead = pageFrame[index].next;
+	if(pageFrame[index].next != -1)
+		pageFrame[pageFrame[index].next].prev = pageFrame[index].prev;
+	else
+		pool->lruTail = pageFrame[index].prev;
+	pageFrame[index].prev = pageFrame[index].next = -1;
+}
+
+/*  FUNCTION NAME : lruPushFront
+    DESCRIPTION   : Puts a frame that is not in the LRU list at its most recently used end */
+
+static void lruPushFront(BufferPoolInfo *pool, int index)
+{
+	PageFrame *pageFrame = pool->pageFrame;
+	pageFrame[index].prev = -1;
+	pageFrame[index].next = pool->lruHead;
+	if(pool->lruHead != -1)
+		pageFrame[pool->lruHead].prev = index;
+	else
+		pool->lruTail = index;
+	pool->lruHead = index;
+}
+
+/*  FUNCTION NAME : lfuUnlink
+    DESCRIPTION   : Takes an unpinned frame out of the LFU list of its reference count */
+
+static void lfuUnlink(BufferPoolInfo *pool, int index)
+{
+	PageFrame *pageFrame = pool->pageFrame;
+	int count = pageFrame[index].refCount;
+	if(pageFrame[index].freqPrev != -1)
+		pageFrame[pageFrame[index].freqPrev].freqNext = pageFrame[index].freqNext;
+	else
+		pool->lfuHead[count] = pageFrame[index].freqNext;
+	if(pageFrame[index].freqNext != -1)
+		pageFrame[pageFrame[index].freqNext].freqPrev = pageFrame[index].freqPrev;
+	else
+		pool->lfuTail[count] = pageFrame[index].freqPrev;
+	pageFrame[index].freqPrev = pageFrame[index].freqNext = -1;
+}
+
+/*  FUNCTION NAME : lfuPushFront
+    DESCRIPTION   : Puts an unpinned frame at the front of the LFU list of its reference count */
+
+static void lfuPushFront(BufferPoolInfo *pool, int index)
+{
+	PageFrame *pageFrame = pool->pageFrame;
+	int count = pageFrame[index].refCount;
+	pageFrame[index].freqPrev = -1;
+	pageFrame[index].freqNext = pool->lfuHead[count];
+	if(pool->lfuHead[count] != -1)
+		pageFrame[pool->lfuHead[count]].freqPrev = index;
+	else
+		pool->lfuTail[count] = index;
+	pool->lfuHead[count] = index;
+}
+
+/*  FUNCTION NAME : lfuAge
+    DESCRIPTION   : Halves every reference count so pages that were hot long ago can be evicted again.
+                    The lists are rebuilt from the LRU list, which keeps each of them in recency order. */
+
+static void lfuAge(BufferPoolInfo *pool)
+{
+	PageFrame *pageFrame = pool->pageFrame;
+	int i;
+	for(i = 0; i <= LFU_MAX_COUNT; i++)
+		pool->lfuHead[i] = pool->lfuTail[i] = -1;
+	for(i = pool->lruTail; i != -1; i = pageFrame[i].prev)
+	{
+		pageFrame[i].refCount = (pageFrame[i].refCount + 1) / 2;
+		if(ATOMIC_LOAD(pageFrame[i].totalCount) == 0)
+			lfuPushFront(pool, i);
+	}
+	pool->lfuReferences = 0;
+}
+
+/*  FUNCTION NAME : heapBefore
+    DESCRIPTION   : LRU_K order: the frame whose K-th most recent reference is older comes first.
+                    Frames with fewer than K references have no such reference and come before all others,
+                    ties are broken by the last reference. */
+
+static int heapBefore(BufferPoolInfo *pool, int a, int b)
+{
+	PageFrame *pageFrame = pool->pageFrame;
+	long kthA = pageFrame[a].history[pool->k - 1], kthB = pageFrame[b].history[pool->k - 1];
+	if(kthA != kthB)
+		return kthA < kthB;
+	return pageFrame[a].lastRef < pageFrame[b].lastRef;
+}
+
+/*  FUNCTION NAME : heapSet
+    DESCRIPTION   : Stores a frame at a heap position and remembers the position in the frame */
+
+static void heapSet(BufferPoolInfo *pool, int pos, int index)
+{
+	pool->heap[pos] = index;
+	pool->pageFrame[index].heapPos = pos;
+}
+
+/*  FUNCTION NAME : heapSiftUp
+    DESCRIPTION   : Moves the frame at pos towards the root until its parent comes before it */
+
+static void heapSiftUp(BufferPoolInfo *pool, int pos)
+{
+	int index = pool->heap[pos];
+	while(pos > 0 && heapBefore(pool, index, pool->heap[(pos - 1) / 2]))
+	{
+		heapSet(pool, pos, pool->heap[(pos - 1) / 2]);
+		pos = (pos - 1) / 2;
+	}
+	heapSet(pool, pos, index);
+}
+
+/*  FUNCTION NAME : heapSiftDown
+    DESCRIPTION   : Moves the frame at pos towards the leaves until it comes before both children */
+
+static void heapSiftDown(BufferPoolInfo *pool, int pos)
+{
+	int index = pool->heap[pos], child;
+	while((child = 2 * pos + 1) < pool->heapSize)
+	{
+		if(child + 1 < pool->heapSize && heapBefore(pool, pool->heap[child + 1], pool->heap[child]))
+			child++;
+		if(!heapBefore(pool, pool->heap[child], index))
+			break;
+		heapSet(pool, pos, pool->heap[child]);
+		pos = child;
+	}
+	heapSet(pool, pos, index);
+}
+
+/*  FUNCTION NAME : heapRemove
+    DESCRIPTION   : Takes a frame out of the LRU_K heap */
+
+static void heapRemove(BufferPoolInfo *pool, int index)
+{
+	int pos = pool->pageFrame[index].heapPos;
+	pool->pageFrame[index].heapPos = -1;
+	if(--pool->heapSize == pos)
+		return;
+	// the last frame fills the hole and moves whichever way restores the order
+	int moved = pool->heap[pool->heapSize];
+	heapSet(pool, pos, moved);
+	heapSiftUp(pool, pos);
+	heapSiftDown(pool, pool->pageFrame[moved].heapPos);
+}
+
+/*  FUNCTION NAME : frameUnpinned
+    DESCRIPTION   : Called when the fix count of a frame drops to 0, the frame becomes a candidate for LFU and LRU_K */
+
+static void frameUnpinned(BufferPoolInfo *pool, int index)
+{
+	if(pool->strategy == RS_LFU)
+		lfuPushFront(pool, index);
+	else if(pool->strategy == RS_LRU_K)
+	{
+		heapSet(pool, pool->heapSize++, index);
+		heapSiftUp(pool, pool->heapSize - 1);
+	}
+}
+
+/*  FUNCTION NAME : framePinned
+    DESCRIPTION   : Called when an unpinned frame is pinned again, it stops being a candidate for LFU and LRU_K */
+
+static void framePinned(BufferPoolInfo *pool, int index)
+{
+	if(pool->strategy == RS_LFU)
+		lfuUnlink(pool, index);
+	else if(pool->strategy == RS_LRU_K)
+		heapRemove(pool, index);
+}
+
+/*  FUNCTION NAME : arcUnlink
+    DESCRIPTION   : Takes a frame out of the ARC resident list it is in */
+
+static void arcUnlink(BufferPoolInfo *pool, int index)
+{
+	PageFrame *pageFrame = pool->pageFrame;
+	ArcList *list = &pool->arcResident[pageFrame[index].arcList];
+	if(pageFrame[index].arcPrev != -1)
+		pageFrame[pageFrame[index].arcPrev].arcNext = pageFrame[index].arcNext;
+	else
+		list->head = pageFrame[index].arcNext;
+	if(pageFrame[index].arcNext != -1)
+		pageFrame[pageFrame[index].arcNext].arcPrev = pageFrame[index].arcPrev;
+	else
+		list->tail = pageFrame[index].arcPrev;
+	list->size--;
+	pageFrame[index].arcList = -1;
+	pageFrame[index].arcPrev = pageFrame[index].arcNext = -1;
+}
+
+/*  FUNCTION NAME : arcPushFront
+    DESCRIPTION   : Puts a frame at the most recently used end of ARC resident list T1 (0), T2 (1) or ARC_EMPTY */
+
+static void arcPushFront(BufferPoolInfo *pool, int index, int which)
+{
+	PageFrame *pageFrame = pool->pageFrame;
+	ArcList *list = &pool->arcResident[which];
+	pageFrame[index].arcList = which;
+	pageFrame[index].arcPrev = -1;
+	pageFrame[index].arcNext = list->head;
+	if(list->head != -1)
+		pageFrame[list->head].arcPrev = index;
+	else
+		list->tail = index;
+	list->head = index;
+	list->size++;
+}
+
+/*  FUNCTION NAME : ghostRemove
+    DESCRIPTION   : Forgets a ghost entry and returns it to the free entries */
+
+static void ghostRemove(BufferPoolInfo *pool, int ghost)
+{
+	GhostEntry *ghosts = pool->ghosts;
+	ArcList *list = &pool->arcGhost[ghosts[ghost].list];
+	if(ghosts[ghost].prev != -1)
+		ghosts[ghosts[ghost].prev].next = ghosts[ghost].next;
+	else
+		list->head = ghosts[ghost].next;
+	if(ghosts[ghost].next != -1)
+		ghosts[ghosts[ghost].next].prev = ghosts[ghost].prev;
+	else
+		list->tail = ghosts[ghost].prev;
+	list->size--;
+	pageTableRemove(&pool->ghostTable, ghosts[ghost].fileId, ghosts[ghost].pageNum);
+	ghosts[ghost].next = pool->freeGhost;
+	pool->freeGhost = ghost;
+}
+
+/*  FUNCTION NAME : ghostAdd
+    DESCRIPTION   : Remembers an evicted page at the most recently used end of ghost list B1 (0) or B2 (1).
+                    If every entry is in use the oldest ghost of the longer list is dropped first. */
+
+static void ghostAdd(BufferPoolInfo *pool, int fileId, PageNumber pageNum, int which)
+{
+	GhostEntry *ghosts = pool->ghosts;
+	ArcList *list = &pool->arcGhost[which];
+	int ghost;
+	if(pool->freeGhost == -1)
+		ghostRemove(pool, pool->arcGhost[(pool->arcGhost[0].size >= pool->arcGhost[1].size) ? 0 : 1].tail);
+	ghost = pool->freeGhost;
+	pool->freeGhost = ghosts[ghost].next;
+	ghosts[ghost].fileId = fileId;
+	ghosts[ghost].pageNum = pageNum;
+	ghosts[ghost].list = which;
+	ghosts[ghost].prev = -1;
+	ghosts[ghost].next = list->head;
+	if(list->head != -1)
+		ghosts[list->head].prev = ghost;
+	else
+		list->tail = ghost;
+	list->head = ghost;
+	list->size++;
+	pageTableAdd(&pool->ghostTable, fileId, pageNum, ghost);
+}
+
+/*  FUNCTION NAME : recordReference
+    DESCRIPTION   : Updates the LFU count, the LRU_K history or the ARC list of a frame that is being pinned.
+                    newPage is set when the frame was just loaded, which starts a fresh history.
+                    promote puts a new page straight into ARC's T2, it is set when the page was found in a ghost list. */
+
+static void recordReference(BufferPoolInfo *pool, int index, int newPage, int promote)
+{
+	PageFrame *pageFrame = pool->pageFrame;
+	if(pool->strategy == RS_LFU)
+	{
+		if(newPage)
+			pageFrame[index].refCount = 1;
+		else if(pageFrame[index].refCount < LFU_MAX_COUNT)
+			pageFrame[index].refCount++;
+		// aging touches every frame, doing it once every LFU_AGING_FACTOR pins per frame keeps the cost per pin constant
+		if(++pool->lfuReferences >= LFU_AGING_FACTOR * pool->bufferCapacity)
+			lfuAge(pool);
+	}
+	else if(pool->strategy == RS_LRU_K)
+	{
+		long now = ++pool->refClock, *history = pageFrame[index].history;
+		int j;
+		if(newPage)
+		{
+			for(j = 1; j < pool->k; j++)
+				history[j] = 0;
+			history[0] = now;
+		}
+		else if(now - pageFrame[index].lastRef > LRU_K_CORRELATED_PERIOD)
+		{
+			for(j = pool->k - 1; j > 0; j--)
+				history[j] = history[j - 1];
+			history[0] = now;
+		}
+		pageFrame[index].lastRef = now;
+	}
+	else if(pool->strategy == RS_ARC)
+	{
+		// a page loaded on a ghost hit has been used before, as has a page pinned again while resident.
+		// A page read ahead was put on its list when it was installed, its first pin leaves it there
+		int which = 1;
+		if(pageFrame[index].fileId == -1)
+			which = ARC_EMPTY; // never evicted, so it never becomes a ghost
+		else if(newPage)
+			which = (pageFrame[index].arcList != -1) ? pageFrame[index].arcList : promote;
+		if(pageFrame[index].arcList != -1)
+			arcUnlink(pool, index);
+		arcPushFront(pool, index, which);
+	}
+}
+
+/*  FUNCTION NAME : writeBackFrame
+    DESCRIPTION   : Writes the page cached in the given frame to the page file and marks the frame clean.
+                    If the write fails the frame stays dirty and the error is returned, the page is written again later. */
+
+static RC writeBackFrame(BufferPoolInfo *pool, int index)
+{
+	PageFrame *pageFrame = pool->pageFrame;
+	PoolFile *file = pool->files[pageFrame[index].fileId];
+	RC result;
+	pthread_mutex_lock(&pool->ioLock);
+	if(pool->mapped)
+	{
+		// a mapped page was changed in place, it only has to reach the disk
+		result = flushMappedBlocks(pageFrame[index].pageNum, 1, &file->fileHandle);
+	}
+	else
+	{
+		// pages past the end of the file are handed out zero filled, the file grows when they are written
+		if((result = ensureCapacity(pageFrame[index].pageNum + 1, &file->fileHandle)) == RC_OK)
+			result = writeBlock(pageFrame[index].pageNum, &file->fileHandle, pageFrame[index].info);
+	}
+	pthread_mutex_unlock(&pool->ioLock);
+	if(result != RC_OK)
+		return result;
+	pageFrame[index].dirtyBit = 0;
+	pool->writeCount++;
+	file->writeCount++;
+	return RC_OK;
+}
+
+/*  FUNCTION NAME : installPage
+    DESCRIPTION   : Makes the frame holding the freshly read page pageNum of file fileId known to the page table and
+                    the replacement strategy, pinned once. NO_PAGE leaves the frame out of the page table.
+                    promote comes from takeFrame, see recordReference. */
+
+static void installPage(BufferPoolInfo *pool, int index, int fileId, PageNumber pageNum, int promote)
+{
+	PageFrame *pageFrame = pool->pageFrame;
+	pageFrame[index].fileId = (pageNum != NO_PAGE) ? fileId : -1;
+	pageFrame[index].pageNum = pageNum;
+	pageFrame[index].dirtyBit = 0;
+	pageFrame[index].prefetched = 0;
+	ATOMIC_STORE(pageFrame[index].totalCount, 1);
+	// the page only becomes visible to latched pins once its data is in place
+	if(pageNum != NO_PAGE)
+	{
+		PageTablePartition *partition = partitionOf(pool, fileId, pageNum);
+		pthread_mutex_lock(&partition->latch);
+		pageTableAdd(&partition->table, fileId, pageNum, index);
+		pthread_mutex_unlock(&partition->latch);
+	}
+	lruPushFront(pool, index);
+	recordReference(pool, index, 1, promote);
+}
+
+/*  FUNCTION NAME : releaseFrame
+    DESCRIPTION   : Hands back a frame a page could not be read into, empty and unpinned, the replacement strategy
+                    reuses it like any other unpinned frame */
+
+static void releaseFrame(BufferPoolInfo *pool, int index)
+{
+	installPage(pool, index, -1, NO_PAGE, 0);
+	ATOMIC_STORE(pool->pageFrame[index].hitNum, 0);
+	ATOMIC_STORE(pool->pageFrame[index].totalCount, 0);
+	frameUnpinned(pool, index);
+}
+
+/*  FUNCTION NAME : mapPage
+    DESCRIPTION   : Returns the address of pageNum in the mapping of page file fileId of a mapped pool, NULL if it cannot be mapped.
+                    The file grows to hold pages past its end. */
+
+static SM_PageHandle mapPage(BufferPoolInfo *pool, int fileId, PageNumber pageNum)
+{
+	SM_FileHandle *fileHandle = &pool->files[fileId]->fileHandle;
+	SM_PageHandle mapped = NULL;
+	pthread_mutex_lock(&pool->ioLock);
+	if(pageNum >= 0 && ensureCapacity(pageNum + 1, fileHandle) == RC_OK)
+		mapped = getMappedBlock(pageNum, fileHandle);
+	pthread_mutex_unlock(&pool->ioLock);
+	return mapped;
+}
+
+/*  FUNCTION NAME : loadPage
+    DESCRIPTION   : Reads page pageNum of file fileId into the arena slot of the given frame and pins it once.
+                    Pages past the end of the file are handed out zero filled. A page inside the file that cannot be read,
+                    fails its checksum or does not decompress is not cached, the frame is released and the error returned,
+                    so that a damaged page is never served as an empty one and written back over the data.
+                    A mapped pool passes the address from mapPage instead, the frame then points at it and nothing is read.
+                    promote comes from takeFrame, see recordReference.
+                    The caller holds the pool lock, which is released while the page is read. The frame is pinned and in the
+                    page table as loading meanwhile, so it is not evicted and other pins of the page wait for it, see pinFrame. */
+
+static RC loadPage(BufferPoolInfo *pool, int index, int fileId, PageNumber pageNum, SM_PageHandle mapped, int promote)
+{
+	PageFrame *pageFrame = pool->pageFrame;
+	PageTablePartition *partition = partitionOf(pool, fileId, pageNum);
+	RC result = RC_OK;
+	pool->files[fileId]->readCount++;
+	if(mapped != NULL)
+	{
+		pageFrame[index].info = mapped;
+		installPage(pool, index, fileId, pageNum, promote);
+		return RC_OK;
+	}
+	pageFrame[index].fileId = fileId;
+	pageFrame[index].pageNum = pageNum;
+	pageFrame[index].dirtyBit = 0;
+	ATOMIC_STORE(pageFrame[index].totalCount, 1);
+	pthread_mutex_lock(&partition->latch);
+	pageFrame[index].loading = 1;
+	pageTableAdd(&partition->table, fileId, pageNum, index);
+	pthread_mutex_unlock(&partition->latch);
+	pthread_mutex_unlock(&pool->lock);
+
+	pthread_mutex_lock(&pool->ioLock);
+	if((result = readBlock(pageNum, &pool->files[fileId]->fileHandle, pageFrame[index].info)) != RC_OK &&
+	   pageNum >= pool->files[fileId]->fileHandle.totalNumPages)
+	{
+		memset(pageFrame[index].info, 0, pool->pageSize);
+		result = RC_OK;
+	}
+	pthread_mutex_unlock(&pool->ioLock);
+
+	// installPage puts the page back into the page table, the pool lock keeps pins from seeing the gap
+	pthread_mutex_lock(&pool->lock);
+	pthread_mutex_lock(&partition->latch);
+	pageTableRemove(&partition->table, fileId, pageNum);
+	pageFrame[index].loading = 0;
+	pthread_mutex_unlock(&partition->latch);
+	pthread_cond_broadcast(&pool->pageLoaded);
+	if(result != RC_OK)
+		releaseFrame(pool, index);
+	else
+		installPage(pool, index, fileId, pageNum, promote);
+	return result;
+}
+
+/*  FUNCTION NAME : finishReadAhead
+    DESCRIPTION   : Waits for the read-ahead in flight, if any, and makes its pages available unpinned.
+                    Their frames stay pinned and out of the page table while the read is in flight.
+                    If the read failed, e.g. on a page failing its checksum, the frames are released and the pages
+                    are read again when pinned. */
+
+static void finishReadAhead(BufferPoolInfo *pool)
+{
+	PageFrame *pageFrame = pool->pageFrame;
+	SM_IORequest *request = &pool->readAheadRequest, *completed;
+	int n, numCompleted;
+
+	if(pool->readAheadFrames == NULL)
+		return;
+	pthread_mutex_lock(&pool->ioLock);
+	if(request->result != RC_OK || completeBlocks(&pool->files[pool->readAheadFile]->fileHandle, &completed, 1, 1, &numCompleted) != RC_OK)
+		request->result = RC_READ_NON_EXISTING_PAGE;
+	pthread_mutex_unlock(&pool->ioLock);
+
+	for(n = 0; n < request->numPages; n++)
+	{
+		int index = pool->readAheadFrames[n];
+		pool->rearIndex++;
+		pool->files[pool->readAheadFile]->readCount++;
+		if(request->result != RC_OK)
+		{
+			releaseFrame(pool, index);
+			continue;
+		}
+		installPage(pool, index, pool->readAheadFile, request->pageNum + n, pool->readAheadPromote[n]);
+		pageFrame[index].prefetched = 1;
+		ATOMIC_STORE(pageFrame[index].hitNum, 0); // CLOCK may take it back unless the scan gets to it
+		if(ATOMIC_ADD(pageFrame[index].totalCount, -1) == 0)
+			frameUnpinned(pool, index);
+	}
+	free(pool->readAheadFrames);
+	free(pool->readAheadPromote);
+	free(request->memPages);
+	pool->readAheadFrames = NULL;
+	pool->readAheadPromote = NULL;
+}
+
+/*  FUNCTION NAME : coldDirtyFrame
+    DESCRIPTION   : Walks the unpinned frames in the order the replacement strategy would evict them and returns the first
+                    dirty one, or -1 once the next 1/WRITER_WINDOW_DIVISOR of the frames are known to be clean.
+                    FIFO and CLOCK evict in frame order from their front index or clock hand, the other strategies are
+                    approximated by the least recently used end of the LRU list. */
+
+static int coldDirtyFrame(BufferPoolInfo *pool)
+{
+	PageFrame *pageFrame = pool->pageFrame;
+	int window = (pool->bufferCapacity + WRITER_WINDOW_DIVISOR - 1) / WRITER_WINDOW_DIVISOR;
+	int clean = 0, step, index;
+
+	if(pool->strategy == RS_FIFO || pool->strategy == RS_CLOCK)
+		index = ((pool->strategy == RS_CLOCK) ? ATOMIC_LOAD(pool->clockPointer) : pool->rearIndex + 1) % pool->bufferCapacity;
+	else
+		index = pool->lruTail;
+
+	for(step = 0; step < pool->bufferCapacity && index != -1; step++)
+	{
+		if(ATOMIC_LOAD(pageFrame[index].totalCount) == 0)
+		{
+			if(pageFrame[index].dirtyBit == 1)
+				return index;
+			if(++clean >= window)
+				break;
+		}
+		if(pool->strategy == RS_FIFO || pool->strategy == RS_CLOCK)
+			index = (index + 1) % pool->bufferCapacity;
+		else
+			index = pageFrame[index].prev;
+	}
+	return -1;
+}
+
+/*  FUNCTION NAME : backgroundWriter
+    DESCRIPTION   : Body of the background writer thread. It writes back cold dirty unpinned frames so the replacement
+                    strategy finds clean victims and a pin miss only has to read. The page is copied while the pool lock
+                    is held and written after it is released. ioLock is taken before releasing the pool lock, so a newer
+                    version of the page written by an eviction always lands after this copy. A page that cannot be written
+                    stays dirty, an eviction or flush tries again and reports the error, and the writer pauses before the
+                    next attempt. */
+
+static void *backgroundWriter(void *arg)
+{
+	BufferPoolInfo *pool = (BufferPoolInfo *)arg;
+	PageFrame *pageFrame = pool->pageFrame;
+	RC result = RC_OK;
+
+	pthread_mutex_lock(&pool->lock);
+	while(pool->writerState == WRITER_RUNNING)
+	{
+		int index = (result == RC_OK) ? coldDirtyFrame(pool) : -1;
+		if(index == -1)
+		{
+			struct timespec wake;
+			clock_gettime(CLOCK_REALTIME, &wake);
+			wake.tv_nsec += WRITER_INTERVAL_MS * 1000000L;
+			wake.tv_sec += wake.tv_nsec / 1000000000L;
+			wake.tv_nsec %= 1000000000L;
+			pthread_cond_timedwait(&pool->writerWake, &pool->lock, &wake);
+			result = RC_OK;
+			continue;
+		}
+
+		// the file cannot be detached while ioLock is held, see shutdownBufferPool
+		int fileId = pageFrame[index].fileId;
+		PageNumber pageNum = pageFrame[index].pageNum;
+		int dirtyGen = pageFrame[index].dirtyGen;
+		memcpy(pool->writerBuffer, pageFrame[index].info, pool->pageSize);
+		pthread_mutex_lock(&pool->ioLock);
+		pthread_mutex_unlock(&pool->lock);
+		if((result = ensureCapacity(pageNum + 1, &pool->files[fileId]->fileHandle)) == RC_OK)
+			result = writeBlock(pageNum, &pool->files[fileId]->fileHandle, pool->writerBuffer);
+		pthread_mutex_unlock(&pool->ioLock);
+
+		pthread_mutex_lock(&pool->lock);
+		if(result != RC_OK)
+			continue;
+		pool->writeCount++;
+		pool->files[fileId]->writeCount++;
+		// the frame stays dirty if it was dirtied again or now holds another page
+		if(pageFrame[index].fileId == fileId && pageFrame[index].pageNum == pageNum && pageFrame[index].dirtyGen == dirtyGen)
+			pageFrame[index].dirtyBit = 0;
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return NULL;
+}
+
+/*  FUNCTION NAME : startBackgroundWriter
+    DESCRIPTION   : Starts a thread that keeps writing back cold dirty pages of the pool until stopBackgroundWriter
+                    or shutdownBufferPool is called. Pages it writes count towards getNumWriteIO. */
+
+extern RC startBackgroundWriter(BM_BufferPool *const bm)
+{
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
+	RC result = RC_OK;
+
+	pthread_mutex_lock(&pool->lock);
+	if(pool->mapped)
+	{
+		// the kernel writes the pages of a mapped pool back by itself
+		result = RC_ERROR;
+	}
+	else if(pool->writerState == WRITER_STOPPED)
+	{
+		// aligned like the arena, so a direct pool writes the copy without bouncing it
+		void *buffer;
+		if(pool->writerBuffer == NULL && posix_memalign(&buffer, PAGE_SIZE, pool->pageSize) == 0)
+			pool->writerBuffer = (char *)buffer;
+		pool->writerState = WRITER_RUNNING;
+		if(pthread_create(&pool->writer, NULL, backgroundWriter, pool) != 0)
+		{
+			pool->writerState = WRITER_STOPPED;
+			result = RC_ERROR;
+		}
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return result;
+}
+
+/*  FUNCTION NAME : stopBackgroundWriter
+    DESCRIPTION   : Stops the background writer of the pool and waits for it to finish the page it is writing */
+
+extern RC stopBackgroundWriter(BM_BufferPool *const bm)
+{
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
+
+	pthread_mutex_lock(&pool->lock);
+	if(pool->writerState != WRITER_RUNNING)
+	{
+		pthread_mutex_unlock(&pool->lock);
+		return RC_OK;
+	}
+	pool->writerState = WRITER_STOPPING;
+	pthread_cond_signal(&pool->writerWake);
+	pthread_mutex_unlock(&pool->lock);
+
+	pthread_join(pool->writer, NULL);
+	pthread_mutex_lock(&pool->lock);
+	pool->writerState = WRITER_STOPPED;
+	pthread_mutex_unlock(&pool->lock);
+	return RC_OK;
+}
+
+/*  FUNCTION NAME : newPool
+    DESCRIPTION   : Allocates the frames and the bookkeeping of a pool of numPages frames of pageSize bytes with no file yet.
+                    Returns NULL if the arena cannot be allocated. */
+
+static BufferPoolInfo *newPool(const int numPages, const int pageSize, ReplacementStrategy strategy, const int k)
+{
+	BufferPoolInfo *pool = (BufferPoolInfo *)malloc(sizeof(BufferPoolInfo));
+	PageFrame *page = malloc(sizeof(PageFrame) * numPages);
+	pool->bufferCapacity = numPages;	//total number of pages in bufferpool
+	pool->pageSize = pageSize;
+
+	// one page aligned arena backs every frame, so pinning never allocates and memory stays bounded by the pool size
+	size_t arenaSize = (size_t)numPages * pageSize;
+	size_t alignment = (arenaSize >= HUGE_PAGE_SIZE) ? HUGE_PAGE_SIZE : PAGE_SIZE;
+	void *arena;
+	if(posix_memalign(&arena, alignment, arenaSize) != 0)
+	{
+		free(page);
+		free(pool);
+		return NULL;
+	}
+#ifdef MADV_HUGEPAGE
+	if(alignment == HUGE_PAGE_SIZE)
+		madvise(arena, arenaSize, MADV_HUGEPAGE);
+#endif
+	pool->arena = (char *)arena;
+
+	int i;
+	pool->strategy = strategy;
+	pool->k = k;
+	pool->historyArena = NULL;
+	pool->heap = NULL;
+	if(strategy == RS_LRU_K)
+	{
+		pool->historyArena = calloc((size_t)numPages * k, sizeof(long));
+		pool->heap = malloc(sizeof(int) * numPages);
+	}
+	pool->ghosts = NULL;
+	pool->ghostTable.entries = NULL;
+	pool->freeGhost = -1;
+	if(strategy == RS_ARC)
+	{
+		// the ghost lists never hold more pages than the pool has frames
+		pool->ghosts = malloc(sizeof(GhostEntry) * numPages);
+		for(i = 0; i < numPages; i++)
+			pool->ghosts[i].next = (i + 1 < numPages) ? i + 1 : -1;
+		pool->freeGhost = 0;
+		pageTableInit(&pool->ghostTable, numPages);
+	}
+	for(i = 0; i < 3; i++)
+	{
+		pool->arcResident[i].head = pool->arcResident[i].tail = -1;
+		pool->arcResident[i].size = 0;
+	}
+	for(i = 0; i < 2; i++)
+	{
+		pool->arcGhost[i].head = pool->arcGhost[i].tail = -1;
+		pool->arcGhost[i].size = 0;
+	}
+	pool->arcTarget = 0;
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_mutex_init(&pool->ioLock, NULL);
+	pthread_cond_init(&pool->writerWake, NULL);
+	pthread_cond_init(&pool->pageLoaded, NULL);
+	pool->writerState = WRITER_STOPPED;
+	pool->writerBuffer = NULL;
+	pool->heapSize = 0;
+	pool->refClock = 0;
+	pool->lfuReferences = 0;
+
+	for(i = 0; i <= LFU_MAX_COUNT; i++)
+		pool->lfuHead[i] = pool->lfuTail[i] = -1;
+	for(i = 0; i < pool->bufferCapacity; i++)
+	{
+		page[i].info = pool->arena + (size_t)i * pageSize;
+		page[i].pageNum = -1; 
+		page[i].fileId = -1;
+		page[i].dirtyBit = 0;
+		page[i].dirtyGen = 0;
+		page[i].totalCount = 0;
+		page[i].hitNum = 0;
+		page[i].prev = page[i].next = -1;
+		page[i].refCount = 0;
+		page[i].freqPrev = page[i].freqNext = -1;
+		page[i].history = (pool->historyArena != NULL) ? pool->historyArena + (size_t)i * k : NULL;
+		page[i].lastRef = 0;
+		page[i].heapPos = -1;
+		page[i].arcList = -1;
+		page[i].arcPrev = page[i].arcNext = -1;
+		page[i].prefetched = 0;
+		page[i].loading = 0;
+	}
+
+	for(i = 0; i < PAGE_TABLE_PARTITIONS; i++)
+	{
+		pthread_mutex_init(&pool->partitions[i].latch, NULL);
+		pageTableInit(&pool->partitions[i].table, numPages / PAGE_TABLE_PARTITIONS + 1);
+	}
+	pool->latchedHits = (strategy == RS_FIFO || strategy == RS_CLOCK);
+	pool->framesInUse = 0;
+
+	pool->pageFrame = page;
+	pool->rearIndex = -1; // no page read yet
+	pool->lruHead = pool->lruTail = -1;
+	pool->writeCount   = 0; // initialiaze write count
+	pool->clockPointer = 0; // initialize Clock pointer
+	pool->readAheadPages = numPages / READ_AHEAD_POOL_DIVISOR;
+	if(pool->readAheadPages > READ_AHEAD_MAX_PAGES)
+		pool->readAheadPages = READ_AHEAD_MAX_PAGES;
+	if(pool->readAheadPages < 2) // reading a single page ahead saves no round trip
+		pool->readAheadPages = 0;
+	pool->readAheadFile = -1;
+	pool->readAheadFrames = NULL;
+	pool->readAheadPromote = NULL;
+	pool->mapped = 0;
+	pool->numFiles = 0;
+	pool->shared = 0;
+	return pool;
+}
+
+/*  FUNCTION NAME : addFile
+    DESCRIPTION   : Makes an open page file one of the files of the pool and returns its fileId, -1 if MAX_POOL_FILES are attached.
+                    The entry of a detached file is reused, the caller holds lock and ioLock. An entry is never moved or freed
+                    before the pool, so pins of other files read theirs without the pool lock while a file is attached. */
+
+static int addFile(BufferPoolInfo *pool, SM_FileHandle *fileHandle)
+{
+	int fileId;
+	for(fileId = 0; fileId < pool->numFiles && pool->files[fileId]->attached; fileId++)
+		;
+	if(fileId == pool->numFiles)
+	{
+		if(fileId == MAX_POOL_FILES || (pool->files[fileId] = malloc(sizeof(PoolFile))) == NULL)
+			return -1;
+		pool->numFiles++;
+	}
+	pool->files[fileId]->fileHandle = *fileHandle;
+	pool->files[fileId]->attached = 1;
+	pool->files[fileId]->readCount = 0;
+	pool->files[fileId]->writeCount = 0;
+	pool->files[fileId]->nextSequential = -1;
+	pool->files[fileId]->sequentialMisses = 0;
+	ATOMIC_STORE(pool->files[fileId]->readAheadMark, -1);
+	return fileId;
+}
+
+/*  FUNCTION NAME : freePool
+    DESCRIPTION   : Releases the frames and the bookkeeping of a pool whose files are closed */
+
+static void freePool(BufferPoolInfo *pool)
+{
+	int i;
+	for(i = 0; i < PAGE_TABLE_PARTITIONS; i++)
+	{
+		pthread_mutex_destroy(&pool->partitions[i].latch);
+		free(pool->partitions[i].table.entries);
+	}
+	free(pool->heap);
+	free(pool->historyArena);
+	free(pool->ghosts);
+	free(pool->ghostTable.entries);
+	free(pool->writerBuffer);
+	pthread_mutex_destroy(&pool->lock);
+	pthread_mutex_destroy(&pool->ioLock);
+	pthread_cond_destroy(&pool->writerWake);
+	pthread_cond_destroy(&pool->pageLoaded);
+	free(pool->arena);
+	free(pool->pageFrame);
+	for(i = 0; i < pool->numFiles; i++)
+		free(pool->files[i]);
+	free(pool);
+}
 
 /*  FUNCTION NAME : initBufferPool
     DESCRIPTION   : This function creates a new buffer pool in memory. 
@@ -31,77 +1161,316 @@ extern RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName
 		  const int numPages, ReplacementStrategy strategy, 
 		  void *stratinfo)
 {
-    
+	// LRU_K takes K from stratData
+	int k = (strategy == RS_LRU_K && stratinfo != NULL) ? *(int *)stratinfo : LRU_K_DEFAULT;
+	if(k < 1)
+		return RC_ERROR;
+
+	SM_FileHandle fileHandle;
+	// the page file stays open for the lifetime of the pool, so a missing file fails here
+	if(openPageFile((char *)pageFileName, &fileHandle) != RC_OK)
+		return RC_FILE_NOT_FOUND;
+	BufferPoolInfo *pool = newPool(numPages, fileHandle.pageSize, strategy, k);
+	if(pool == NULL || addFile(pool, &fileHandle) != 0)
+	{
+		closePageFile(&fileHandle);
+		if(pool != NULL)
+			freePool(pool);
+		return RC_ERROR;
+	}
+
 	bm->pageFile = (char *)pageFileName;
 	bm->numPages = numPages;
+	bm->pageSize = pool->pageSize;
+	bm->fileId = 0;
 	bm->strategy = strategy;
-    // test to check for initialization of non existing buffer pool
-    if(strcmp(bm->pageFile, "testbuffer.bin") != 0){
-        return RC_NON_EXISTING_PAGE;
-    }
-	PageFrame *page = malloc(sizeof(PageFrame) * numPages);
-	bufferCapacity = numPages;	//total number of pages in bufferpool
-	int i;
-	for(i = 0; i < bufferCapacity; i++)
+	bm->mgmtData = pool;
+	return RC_OK;
+		
+}
+
+/*  FUNCTION NAME : initSharedBufferPool
+    DESCRIPTION   : Creates a buffer pool of numPages frames of pageSize bytes that caches the pages of every page file
+                    attached to it with attachBufferPool. Its frames go to whichever files are used most, instead of
+                    being split among the files up front. The shared pool itself caches no file, pages are pinned through
+                    the attached pools. */
+
+extern RC initSharedBufferPool(BM_BufferPool *const bm, const int numPages, const int pageSize,
+		  ReplacementStrategy strategy, void *stratinfo)
+{
+	int k = (strategy == RS_LRU_K && stratinfo != NULL) ? *(int *)stratinfo : LRU_K_DEFAULT;
+	if(k < 1 || numPages < 1 || pageSize < PAGE_SIZE)
+		return RC_ERROR;
+
+	BufferPoolInfo *pool = newPool(numPages, pageSize, strategy, k);
+	if(pool == NULL)
+		return RC_ERROR;
+	pool->shared = 1;
+
+	bm->pageFile = NULL;
+	bm->numPages = numPages;
+	bm->pageSize = pageSize;
+	bm->fileId = -1;
+	bm->strategy = strategy;
+	bm->mgmtData = pool;
+	return RC_OK;
+}
+
+/*  FUNCTION NAME : attachBufferPool
+    DESCRIPTION   : Opens the page file pageFileName and makes bm a pool caching its pages in the frames of sharedPool.
+                    bm is used like a pool created by initBufferPool, its pages are told apart from those of the other
+                    attached files by a fileId. shutdownBufferPool on bm writes back and drops the pages of the file and
+                    closes it, sharedPool goes on. The file must have the page size of sharedPool.
+                    Fails while MAX_POOL_FILES files are attached. */
+
+extern RC attachBufferPool(BM_BufferPool *const bm, BM_BufferPool *const sharedPool, const char *const pageFileName)
+{
+	BufferPoolInfo *pool = (BufferPoolInfo *)sharedPool->mgmtData;
+	SM_FileHandle fileHandle;
+	int fileId;
+
+	if(pool == NULL || !pool->shared)
+		return RC_ERROR;
+	if(openPageFile((char *)pageFileName, &fileHandle) != RC_OK)
+		return RC_FILE_NOT_FOUND;
+	if(fileHandle.pageSize != pool->pageSize)
 	{
-		page[i].info = NULL;
-		page[i].pageNum = -1; 
-		page[i].dirtyBit = 0;
-		page[i].totalCount = 0;
-		page[i].hitNum = 0;	
+		closePageFile(&fileHandle);
+		return RC_ERROR;
+	}
+	pthread_mutex_lock(&pool->lock);
+	pthread_mutex_lock(&pool->ioLock);
+	fileId = addFile(pool, &fileHandle);
+	pthread_mutex_unlock(&pool->ioLock);
+	pthread_mutex_unlock(&pool->lock);
+	if(fileId == -1)
+	{
+		closePageFile(&fileHandle);
+		return RC_ERROR;
 	}
 
-	bm->mgmtData = page;
-	writeCount   = 0; // initialiaze write count
-    clockPointer = 0; // initialize Clock pointer
+	bm->pageFile = (char *)pageFileName;
+	bm->numPages = sharedPool->numPages;
+	bm->pageSize = pool->pageSize;
+	bm->fileId = fileId;
+	bm->strategy = sharedPool->strategy;
+	bm->mgmtData = pool;
 	return RC_OK;
-		
+}
+
+/*  FUNCTION NAME : isAttached
+    DESCRIPTION   : Tells whether bm was attached to a shared pool and only sees the pages of its own file */
+
+static int isAttached(BM_BufferPool *const bm)
+{
+	return ((BufferPoolInfo *)bm->mgmtData)->shared && bm->fileId >= 0;
+}
+
+/*  FUNCTION NAME : dropFile
+    DESCRIPTION   : Empties the frames and ghost entries holding pages of file fileId, which have been written back,
+                    so they can be reused for other files. The caller holds the pool lock. */
+
+static void dropFile(BufferPoolInfo *pool, int fileId)
+{
+	PageFrame *pageFrame = pool->pageFrame;
+	int i, which, ghost, next;
+
+	for(i = 0; i < pool->framesInUse; i++)
+	{
+		if(pageFrame[i].fileId != fileId || !evictPage(pool, i))
+			continue;
+		// take it out of every list before releaseFrame puts it back as an empty frame
+		lruUnlink(pool, i);
+		framePinned(pool, i);
+		if(pageFrame[i].arcList != -1)
+			arcUnlink(pool, i);
+		releaseFrame(pool, i);
+	}
+	for(which = 0; which < 2 && pool->ghosts != NULL; which++)
+	{
+		for(ghost = pool->arcGhost[which].head; ghost != -1; ghost = next)
+		{
+			next = pool->ghosts[ghost].next;
+			if(pool->ghosts[ghost].fileId == fileId)
+				ghostRemove(pool, ghost);
+		}
+	}
 }
 
 /*  FUNCTION NAME : shutdownBufferPool
     DESCRIPTION   : This function first calls the forceFlushPool() which writes all the dirty pages to the disk.
                     Then it shuts down or close the buffer pool by removing all pages from memory
-                    It releases all the memory allocated by setting the variables curQueueSize and curBufferSize to 0 */
+                    It releases all the memory allocated by setting the variables curQueueSize and curBufferSize to 0.
+                    A pool attached to a shared pool only gives back the frames of its file and closes it.
+                    A shared pool can only be shut down once every pool attached to it was.
+                    If a dirty page cannot be written back the error is returned and the pool kept, so the page is not lost. */
 
 extern RC shutdownBufferPool(BM_BufferPool *const bm)
 {
-	PageFrame *pageFrame = (PageFrame *)bm->mgmtData;
-	forceFlushPool(bm);
-	int i;	
-	for(i = 0; i < bufferCapacity; i++)
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
+	PageFrame *pageFrame = pool->pageFrame;
+	RC result;
+	int i;
+
+	if(isAttached(bm))
+	{
+		if((result = forceFlushPool(bm)) != RC_OK)
+			return result;
+		pthread_mutex_lock(&pool->lock);
+		for(i = 0; i < pool->bufferCapacity; i++)
+		{
+			if(pageFrame[i].fileId == bm->fileId && ATOMIC_LOAD(pageFrame[i].totalCount) != 0)
+			{
+				pthread_mutex_unlock(&pool->lock);
+				return RC_PINNED_PAGES_IN_BUFFER;
+			}
+		}
+		dropFile(pool, bm->fileId);
+		// the background writer holds ioLock while it writes a page of the file
+		pthread_mutex_lock(&pool->ioLock);
+		closePageFile(&pool->files[bm->fileId]->fileHandle);
+		pool->files[bm->fileId]->attached = 0;
+		pthread_mutex_unlock(&pool->ioLock);
+		pthread_mutex_unlock(&pool->lock);
+		bm->mgmtData = NULL;
+		return RC_OK;
+	}
+
+	for(i = 0; pool->shared && i < pool->numFiles; i++)
+		if(pool->files[i]->attached)
+			return RC_ERROR;
+	stopBackgroundWriter(bm);
+	if((result = forceFlushPool(bm)) != RC_OK)
+		return result;
+	for(i = 0; i < pool->bufferCapacity; i++)
 	{
 		
-		if(pageFrame[i].totalCount != 0) // content of page was modified but not written back to disk
+		if(ATOMIC_LOAD(pageFrame[i].totalCount) != 0) // content of page was modified but not written back to disk
 		{
 			return RC_PINNED_PAGES_IN_BUFFER;
 		}
 	}
-	free(pageFrame);
+	for(i = 0; i < pool->numFiles; i++)
+		if(pool->files[i]->attached)
+			closePageFile(&pool->files[i]->fileHandle);
+	freePool(pool);
 	bm->mgmtData = NULL;
 	return RC_OK;
 }
 
+/*  FUNCTION NAME : compareDirtyPages
+    DESCRIPTION   : Orders the pages forceFlushPool writes back by page number */
+
+static int compareDirtyPages(const void *a, const void *b)
+{
+	PageNumber x = ((const DirtyPage *)a)->pageNum;
+	PageNumber y = ((const DirtyPage *)b)->pageNum;
+	return (x > y) - (x < y);
+}
+
+/*  FUNCTION NAME : flushFile
+    DESCRIPTION   : Writes back the dirty unpinned pages of file fileId, see forceFlushPool. The caller holds the pool lock. */
+
+static RC flushFile(BufferPoolInfo *pool, int fileId)
+{
+	PageFrame *pageFrame = pool->pageFrame;
+	SM_FileHandle *fileHandle = &pool->files[fileId]->fileHandle;
+	DirtyPage *dirty = malloc(sizeof(DirtyPage) * pool->bufferCapacity);
+	SM_PageHandle *pages = malloc(sizeof(SM_PageHandle) * pool->bufferCapacity);
+	SM_IORequest *requests = malloc(sizeof(SM_IORequest) * pool->bufferCapacity);
+	SM_IORequest **submitted = malloc(sizeof(SM_IORequest *) * pool->bufferCapacity);
+	int i, j, first, last, numDirty = 0, numRequests = 0, numCompleted, total;
+	RC result = RC_OK;
+	
+	for(i = 0; i < pool->bufferCapacity; i++)
+	{
+		if(pageFrame[i].fileId == fileId && ATOMIC_LOAD(pageFrame[i].totalCount) == 0 && pageFrame[i].dirtyBit == 1)
+		{
+			dirty[numDirty].pageNum = pageFrame[i].pageNum;
+			dirty[numDirty++].frame = i;
+		}
+	}
+	qsort(dirty, numDirty, sizeof(DirtyPage), compareDirtyPages);
+	for(i = 0; i < numDirty; i++)
+		pages[i] = pageFrame[dirty[i].frame].info;
+	
+	for(first = 0; first < numDirty; first = last)
+	{
+		for(last = first + 1; last < numDirty && last - first < FLUSH_MAX_RUN_PAGES && dirty[last].pageNum == dirty[last - 1].pageNum + 1; last++)
+			;
+		requests[numRequests].pageNum = dirty[first].pageNum;
+		requests[numRequests].numPages = last - first;
+		requests[numRequests].memPages = pages + first;
+		requests[numRequests].write = 1;
+		requests[numRequests].result = RC_OK;
+		submitted[numRequests] = &requests[numRequests];
+		numRequests++;
+	}
+
+	// all writes are in flight at once, the pool lock keeps the pages from changing until they are done
+	pthread_mutex_lock(&pool->ioLock);
+	if(pool->mapped)
+	{
+		// mapped pages were changed in place, each run only has to reach the disk
+		for(i = 0; i < numRequests; i++)
+			requests[i].result = flushMappedBlocks(requests[i].pageNum, requests[i].numPages, fileHandle);
+		numCompleted = numRequests;
+	}
+	else if(numRequests > 0 && (result = submitBlocks(fileHandle, submitted, numRequests)) != RC_OK)
+	{
+		numRequests = 0;
+	}
+	for(total = 0; total < numRequests; total += numCompleted)
+	{
+		if(!pool->mapped)
+			completeBlocks(fileHandle, submitted, 1, numRequests, &numCompleted);
+		for(i = 0; i < numCompleted; i++)
+		{
+			if(submitted[i]->result != RC_OK)
+			{
+				result = submitted[i]->result;
+				continue;
+			}
+			for(j = submitted[i]->memPages - pages; j < submitted[i]->memPages - pages + submitted[i]->numPages; j++)
+			{
+				pageFrame[dirty[j].frame].dirtyBit = 0;
+				pool->writeCount++;
+				pool->files[fileId]->writeCount++;
+			}
+		}
+	}
+	pthread_mutex_unlock(&pool->ioLock);
+	free(submitted);
+	free(requests);
+	free(pages);
+	free(dirty);
+	return result;
+}
+
 /*  FUNCTION NAME : forceFlushPool
     DESCRIPTION   : causes all dirty pages (with fix count 0) from the buffer pool to be written to disk.
-                    The written pages are now reset to "not dirty" i.e DirtyBit=0 and writeCount is incremented. */
+                    The pages are sorted by page number and each run of neighbouring pages goes out as one vectored write.
+                    The written pages are now reset to "not dirty" i.e DirtyBit=0 and writeCount is incremented.
+                    A pool attached to a shared pool only writes the pages of its file, the shared pool those of every file. */
 
 extern RC forceFlushPool(BM_BufferPool *const bm)
 {
-	PageFrame *pageFrame = (PageFrame *)bm->mgmtData;
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
+	RC result = RC_OK, fileResult;
+	int i;
 	
-	int i;	
-	for(i = 0; i < bufferCapacity; i++)
+	pthread_mutex_lock(&pool->lock);
+	// a read-ahead in flight would be handed back among the writes
+	finishReadAhead(pool);
+	for(i = 0; i < pool->numFiles; i++)
 	{
-		if(pageFrame[i].totalCount == 0 && pageFrame[i].dirtyBit == 1)
-		{
-			SM_FileHandle fh;
-			openPageFile(bm->pageFile, &fh);
-			writeBlock(pageFrame[i].pageNum, &fh, pageFrame[i].info);
-			pageFrame[i].dirtyBit = 0;
-			writeCount++;
-		}
-	}	
-	return RC_OK;
+		if(!pool->files[i]->attached || (isAttached(bm) && i != bm->fileId))
+			continue;
+		if((fileResult = flushFile(pool, i)) != RC_OK)
+			result = fileResult;
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return result;
 }
 
 /*  FUNCTION NAME : markDirty
@@ -110,136 +1479,256 @@ extern RC forceFlushPool(BM_BufferPool *const bm)
 
 extern RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page)
 {
-	PageFrame *pageFrame = (PageFrame *)bm->mgmtData;
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
+	PageFrame *pageFrame = pool->pageFrame;
 	
-	int i;
-	for(i = 0; i < bufferCapacity; i++)
+	pthread_mutex_lock(&pool->lock);
+	int i = findFrame(pool, bm->fileId, page->pageNum);
+	if(i != -1)
 	{
-		if(pageFrame[i].pageNum == page->pageNum)
-		{
-			pageFrame[i].dirtyBit = 1;
-			return RC_OK;		
-		}	
-	}		
-	return RC_ERROR;
+		pageFrame[i].dirtyBit = 1;
+		pageFrame[i].dirtyGen++;
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return (i == -1) ? RC_ERROR : RC_OK;
 }
 /*  FUNCTION NAME : FIFO
-    DESCRIPTION   : This replacement algorithm removes the first page frames arrived to the buffer pool */
+    DESCRIPTION   : This replacement algorithm removes the first page frames arrived to the buffer pool.
+                    Sets victim to the victim frame after writing it back if dirty, -1 if every frame is pinned.
+                    Returns the error of a failed write back, the frame then keeps its page. */
 
-extern void FIFO(BM_BufferPool *const bm, PageFrame *page)
+extern RC FIFO(BM_BufferPool *const bm, int *victim)
 {
 	
-	PageFrame *pageFrame = (PageFrame *) bm->mgmtData;
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
+	PageFrame *pageFrame = pool->pageFrame;
+	RC result;
 	
 	int i, frontIndex;
-	frontIndex = rearIndex % bufferCapacity; 
-	for(i = 0; i < bufferCapacity; i++)
+	*victim = -1;
+	frontIndex = (pool->rearIndex + 1) % pool->bufferCapacity; 
+	for(i = 0; i < pool->bufferCapacity; i++)
 	{
-		if(pageFrame[frontIndex].totalCount == 0)
+		if(ATOMIC_LOAD(pageFrame[frontIndex].totalCount) == 0)
 		{
 			
-			if(pageFrame[frontIndex].dirtyBit == 1)
-			{
-				SM_FileHandle fh;
-				openPageFile(bm->pageFile, &fh);
-				writeBlock(pageFrame[frontIndex].pageNum, &fh, pageFrame[frontIndex].info);
-				writeCount++;
-			}
-			pageFrame[frontIndex].info = page->info;
-			pageFrame[frontIndex].pageNum = page->pageNum;
-			pageFrame[frontIndex].dirtyBit = page->dirtyBit;
-			pageFrame[frontIndex].totalCount = page->totalCount;
-			break;
+			if(pageFrame[frontIndex].dirtyBit == 1 && (result = writeBackFrame(pool, frontIndex)) != RC_OK)
+				return result;
+			*victim = frontIndex;
+			return RC_OK;
 		}
 		else
 		{
 			frontIndex++;
-			frontIndex = (frontIndex % bufferCapacity == 0) ? 0 : frontIndex;
+			frontIndex = (frontIndex % pool->bufferCapacity == 0) ? 0 : frontIndex;
 		}
 	}
+	return RC_OK;
 }
 
 /*  FUNCTION NAME : LRU
-    DESCRIPTION   : This algorithm replaces the least recently referenced page frames*/
+    DESCRIPTION   : This algorithm replaces the least recently referenced unpinned page frame.
+                    Frames are kept in a list ordered by their last pin, so the victim is the first
+                    unpinned frame walking from the tail and no per frame scan is needed.
+                    Sets victim to the victim frame after writing it back if dirty, -1 if every frame is pinned.
+                    Returns the error of a failed write back, the frame then keeps its page. */
 
-extern void LRU(BM_BufferPool *const bm, PageFrame *page)
+extern RC LRU(BM_BufferPool *const bm, int *victim)
 {	
-	PageFrame *pageFrame = (PageFrame *) bm->mgmtData;
-	int i, least_hit_index=0, least_hit_num;
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
+	PageFrame *pageFrame = pool->pageFrame;
+	int index = pool->lruTail;
+	RC result;
 
+	*victim = -1;
+	while(index != -1 && ATOMIC_LOAD(pageFrame[index].totalCount) != 0)
+		index = pageFrame[index].prev;
 	
-	for(i = 0; i < bufferCapacity; i++)
-	{
-		
-		if(pageFrame[i].totalCount == 0)
-		{
-			least_hit_index = i;
-			least_hit_num = pageFrame[i].hitNum;
-			break;
-		}
-	}	
+	if(index != -1 && pageFrame[index].dirtyBit == 1 && (result = writeBackFrame(pool, index)) != RC_OK)
+		return result;
+	*victim = index;
+	return RC_OK;
+}
+
+/*  FUNCTION NAME : CLOCK
+    DESCRIPTION   : It replaces the first unpinned page the clock hand finds with its reference bit cleared.
+                    Sets victim to the victim frame after writing it back if dirty, -1 if every frame is pinned.
+                    Returns the error of a failed write back, the frame then keeps its page. */
 
+extern RC CLOCK(BM_BufferPool *const bm, int *victim)
+{	
 	
-	for(i = least_hit_index + 1; i < bufferCapacity; i++)
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
+	PageFrame *pageFrame = pool->pageFrame;
+	int hand, scanned;
+	RC result;
+	*victim = -1;
+	// two sweeps clear every reference bit, so an unpinned frame is found by then if one exists
+	for(scanned = 0; scanned < 2 * pool->bufferCapacity; scanned++)
 	{
-		if(pageFrame[i].hitNum < least_hit_num)
+		// hits also advance the hand, so it can be past the end by more than one frame
+		hand = ATOMIC_LOAD(pool->clockPointer) % pool->bufferCapacity;
+		ATOMIC_STORE(pool->clockPointer, hand + 1);
+
+		if(ATOMIC_LOAD(pageFrame[hand].totalCount) != 0)
+			continue;
+		if(ATOMIC_LOAD(pageFrame[hand].hitNum) == 0)
 		{
-			least_hit_index = i;
-			least_hit_num = pageFrame[i].hitNum;
+			if(pageFrame[hand].dirtyBit == 1 && (result = writeBackFrame(pool, hand)) != RC_OK)
+				return result;
+			*victim = hand;
+			return RC_OK;
 		}
+		ATOMIC_STORE(pageFrame[hand].hitNum, 0);
 	}
+	return RC_OK;
+}
 
-	
-	if(pageFrame[least_hit_index].dirtyBit == 1)
-	{
-		SM_FileHandle fh;
-		openPageFile(bm->pageFile, &fh);
-		writeBlock(pageFrame[least_hit_index].pageNum, &fh, pageFrame[least_hit_index].info);
-		writeCount++;
-	}
-	pageFrame[least_hit_index].info = page->info;
-	pageFrame[least_hit_index].pageNum = page->pageNum;
-	pageFrame[least_hit_index].dirtyBit = page->dirtyBit;
-	pageFrame[least_hit_index].totalCount = page->totalCount;
-	pageFrame[least_hit_index].hitNum = page->hitNum;
+/*  FUNCTION NAME : LFU
+    DESCRIPTION   : It replaces the unpinned page with the smallest reference count, the least recently unpinned one on ties.
+                    Only unpinned frames are kept in the per count lists, so the victim is the tail of the first non empty list.
+                    Sets victim to the victim frame after writing it back if dirty, -1 if every frame is pinned.
+                    Returns the error of a failed write back, the frame then keeps its page and its place in the lists. */
+
+extern RC LFU(BM_BufferPool *const bm, int *victim)
+{
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
+	int count, index = -1;
+	RC result;
+
+	*victim = -1;
+	for(count = 0; count <= LFU_MAX_COUNT && index == -1; count++)
+		index = pool->lfuTail[count];
+	if(index == -1)
+		return RC_OK;
+
+	if(pool->pageFrame[index].dirtyBit == 1 && (result = writeBackFrame(pool, index)) != RC_OK)
+		return result;
+	lfuUnlink(pool, index);
+	*victim = index;
+	return RC_OK;
 }
 
-/*  FUNCTION NAME : CLOCK
-    DESCRIPTION   : It replaces the page that has been kept with Dirtybit = 0 for a long time */
+/*  FUNCTION NAME : LRU_K
+    DESCRIPTION   : It replaces the unpinned page whose K-th most recent reference lies furthest back.
+                    Pages referenced fewer than K times go first, so a scan touching pages once does not push out pages in repeated use.
+                    Unpinned frames are kept in a heap, so the victim is found in O(log n).
+                    Sets victim to the victim frame after writing it back if dirty, -1 if every frame is pinned.
+                    Returns the error of a failed write back, the frame then keeps its page and its place in the heap. */
 
-extern void CLOCK(BM_BufferPool *const bm, PageFrame *page)
-{	
-	
-	PageFrame *pageFrame = (PageFrame *) bm->mgmtData;
-	while(1)
-	{
-		clockPointer = (clockPointer % bufferCapacity == 0) ? 0 : clockPointer;
+extern RC LRU_K(BM_BufferPool *const bm, int *victim)
+{
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
+	int index;
+	RC result;
+
+	*victim = -1;
+	if(pool->heapSize == 0)
+		return RC_OK;
+	index = pool->heap[0];
+	if(pool->pageFrame[index].dirtyBit == 1 && (result = writeBackFrame(pool, index)) != RC_OK)
+		return result;
+	heapRemove(pool, index);
+	*victim = index;
+	return RC_OK;
+}
+
+/*  FUNCTION NAME : ARC
+    DESCRIPTION   : Adaptive replacement. T1 holds pages used once since they were loaded and T2 pages used again,
+                    B1 and B2 remember the page numbers recently evicted from each. A request for a page in B1 means
+                    T1 was too small and grows its target size, a request for a page in B2 shrinks it. The victim is
+                    the least recently used unpinned frame of T1 while T1 is above its target, else of T2, so a scan
+                    only cycles through T1 and leaves the pages in T2 alone.
+                    A frame a page could not be read into holds no page and is reused first, it never becomes a ghost.
+                    Sets victim to the victim frame after writing it back if dirty, -1 if every frame is pinned, and
+                    promote when pageNum was found in a ghost list, so the page loaded into the victim goes to T2.
+                    Returns the error of a failed write back, the frame then keeps its page and its place in T1 or T2. */
 
-		if(pageFrame[clockPointer].hitNum == 0)
+extern RC ARC(BM_BufferPool *const bm, const PageNumber pageNum, int *victimFrame, int *promote)
+{
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
+	PageFrame *pageFrame = pool->pageFrame;
+	ArcList *t1 = &pool->arcResident[0], *t2 = &pool->arcResident[1];
+	ArcList *b1 = &pool->arcGhost[0], *b2 = &pool->arcGhost[1];
+	int capacity = pool->bufferCapacity;
+	int ghost = pageTableFind(&pool->ghostTable, bm->fileId, pageNum);
+	int fromT1, keepGhost = 1, which, victim = -1, attempt;
+	RC result;
+
+	*victimFrame = -1;
+	*promote = 0;
+	victim = pool->arcResident[ARC_EMPTY].tail;
+	if(victim != -1 && ATOMIC_LOAD(pageFrame[victim].totalCount) == 0)
+	{
+		// nothing is evicted, so the lists keep their sizes and the target stays where it is
+		if(ghost != -1)
 		{
-			
-			if(pageFrame[clockPointer].dirtyBit == 1)
-			{
-				SM_FileHandle fh;
-				openPageFile(bm->pageFile, &fh);
-				writeBlock(pageFrame[clockPointer].pageNum, &fh, pageFrame[clockPointer].info);
-				writeCount++;
-			}
-			
-			// Setting page frame's content to new page's content
-			pageFrame[clockPointer].info = page->info;
-			pageFrame[clockPointer].pageNum = page->pageNum;
-			pageFrame[clockPointer].dirtyBit = page->dirtyBit;
-			pageFrame[clockPointer].totalCount = page->totalCount;
-			pageFrame[clockPointer].hitNum = page->hitNum;
-			clockPointer++;
-			break;	
+			ghostRemove(pool, ghost);
+			*promote = 1;
+		}
+		arcUnlink(pool, victim);
+		*victimFrame = victim;
+		return RC_OK;
+	}
+	if(ghost != -1)
+	{
+		if(pool->ghosts[ghost].list == 0)
+		{
+			pool->arcTarget += (b2->size / b1->size > 1) ? b2->size / b1->size : 1;
+			if(pool->arcTarget > capacity)
+				pool->arcTarget = capacity;
+			fromT1 = t1->size > 0 && t1->size > pool->arcTarget;
 		}
 		else
 		{
-			pageFrame[clockPointer++].hitNum = 0;		
+			pool->arcTarget -= (b1->size / b2->size > 1) ? b1->size / b2->size : 1;
+			if(pool->arcTarget < 0)
+				pool->arcTarget = 0;
+			fromT1 = t1->size > 0 && t1->size >= pool->arcTarget;
 		}
 	}
+	else
+	{
+		// keep T1 and B1 within the pool size and all four lists within twice the pool size
+		if(t1->size + b1->size >= capacity)
+		{
+			if(b1->size > 0)
+				ghostRemove(pool, b1->tail);
+			else
+				keepGhost = 0; // T1 fills the pool, its victim is dropped without a ghost
+		}
+		else if(t1->size + t2->size + b1->size + b2->size >= 2 * capacity && b2->size > 0)
+			ghostRemove(pool, b2->tail);
+		fromT1 = t1->size > 0 && (t1->size > pool->arcTarget || !keepGhost);
+	}
+
+	// walk the chosen list from its least recently used end past pinned frames, the other list is the fallback
+	which = fromT1 ? 0 : 1;
+	for(attempt = 0; attempt < 2; attempt++)
+	{
+		victim = pool->arcResident[which].tail;
+		while(victim != -1 && ATOMIC_LOAD(pageFrame[victim].totalCount) != 0)
+			victim = pageFrame[victim].arcPrev;
+		if(victim != -1)
+			break;
+		which = 1 - which;
+	}
+	if(victim == -1)
+		return RC_OK;
+
+	// written back before the lists change, so a failed write leaves the page resident where it was
+	if(pageFrame[victim].dirtyBit == 1 && (result = writeBackFrame(pool, victim)) != RC_OK)
+		return result;
+	if(ghost != -1)
+	{
+		ghostRemove(pool, ghost);
+		*promote = 1;
+	}
+	arcUnlink(pool, victim);
+	if(keepGhost)
+		ghostAdd(pool, pageFrame[victim].fileId, pageFrame[victim].pageNum, which);
+	*victimFrame = victim;
+	return RC_OK;
 }
 
 /*  FUNCTION NAME : unpinPage
@@ -249,48 +1738,118 @@ extern void CLOCK(BM_BufferPool *const bm, PageFrame *page)
 
 extern RC unpinPage (BM_BufferPool *const bm, BM_PageHandle *const page)
 {	
-	PageFrame *pageFrame = (PageFrame *)bm->mgmtData;
-	
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
+	PageFrame *pageFrame = pool->pageFrame;
 	int i;
-    
-	for(i = 0; i < bufferCapacity; i++)
+
+	if(pool->latchedHits)
 	{
-		if(pageFrame[i].pageNum == page->pageNum)
-		{
-			pageFrame[i].totalCount--;
-			//break;
-            return RC_OK;		
-		}	
-        
+		// FIFO and CLOCK keep no list of unpinned frames, the partition latch is enough
+		PageTablePartition *partition = partitionOf(pool, bm->fileId, page->pageNum);
+		pthread_mutex_lock(&partition->latch);
+		i = pageTableFind(&partition->table, bm->fileId, page->pageNum);
+		if(i != -1)
+			ATOMIC_ADD(pageFrame[i].totalCount, -1);
+		pthread_mutex_unlock(&partition->latch);
+		return (i == -1) ? RC_ERROR : RC_OK;
+	}
+
+	pthread_mutex_lock(&pool->lock);
+	i = findFrame(pool, bm->fileId, page->pageNum);
+	if(i != -1 && ATOMIC_ADD(pageFrame[i].totalCount, -1) == 0)
+	{
+		frameUnpinned(pool, i);
+		if(pageFrame[i].dirtyBit == 1 && pool->writerState == WRITER_RUNNING)
+			pthread_cond_signal(&pool->writerWake);
 	}
-	return RC_ERROR;
+	pthread_mutex_unlock(&pool->lock);
+	return (i == -1) ? RC_ERROR : RC_OK;
 }
 
 /*  FUNCTION NAME : forcePage
     DESCRIPTION   : This function writes the current content of the page back to the page file on disk.
                     The page file is opened and the contents are written to disk.
-	                Then the write count is incremented and mark the page not dirty after updating the contents */
+	                Then the write count is incremented and mark the page not dirty after updating the contents.
+	                If the write fails the page stays dirty and the error is returned. */
 
 extern RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page)
 {
-	PageFrame *pageFrame = (PageFrame *)bm->mgmtData;
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
 	
-	int i;
-	
-	for(i = 0; i < bufferCapacity; i++)
+	RC result = RC_ERROR;
+	pthread_mutex_lock(&pool->lock);
+	int i = findFrame(pool, bm->fileId, page->pageNum);
+	if(i != -1)
+		result = writeBackFrame(pool, i);
+	pthread_mutex_unlock(&pool->lock);
+	return result;
+}
+
+/*  FUNCTION NAME : writePages
+    DESCRIPTION   : Writes numPages consecutive pages from pageNum on, pages[0] to pages[numPages - 1], straight to the page file
+                    with one batched write. They take no frame and leave the replacement strategy alone, which suits pages
+                    that are written once and not read back soon, like those of a bulk load. A page the pool caches takes the
+                    new contents and is written again when it leaves the pool. If one of them is pinned nothing is written.
+                    The file grows to hold the pages. */
+
+extern RC writePages (BM_BufferPool *const bm, const PageNumber pageNum, const int numPages, char **pages)
+{
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
+	PageFrame *pageFrame = pool->pageFrame;
+	PoolFile *file;
+	int *pageNums, i, index;
+	RC result;
+
+	if(bm->fileId < 0)
+		return RC_FILE_HANDLE_NOT_INIT;
+	if(pool->mapped)
+		return RC_ERROR; // a mapping would go on showing what the kernel has cached
+	file = pool->files[bm->fileId];
+	pthread_mutex_lock(&pool->lock);
+	// a read-ahead in flight could hand back the pages as they were
+	finishReadAhead(pool);
+	for(i = 0; i < numPages; i++)
 	{
-		
-		if(pageFrame[i].pageNum == page->pageNum)
-		{		
-			SM_FileHandle fh;
-			openPageFile(bm->pageFile, &fh);
-			writeBlock(pageFrame[i].pageNum, &fh, pageFrame[i].info);
-			pageFrame[i].dirtyBit = 0;
-			writeCount++;
-            return RC_OK;
+		if((index = findFrame(pool, bm->fileId, pageNum + i)) != -1 && ATOMIC_LOAD(pageFrame[index].totalCount) > 0)
+		{
+			pthread_mutex_unlock(&pool->lock);
+			return RC_ERROR;
 		}
-	}	
-	return RC_ERROR;
+	}
+	pageNums = malloc(sizeof(int) * numPages);
+	for(i = 0; i < numPages; i++)
+		pageNums[i] = pageNum + i;
+	pthread_mutex_lock(&pool->ioLock);
+	// pages the pool handed out past the end of the file are only in the file once they are written back
+	if((result = ensureCapacity(pageNum, &file->fileHandle)) == RC_OK)
+		result = writeBlocks(pageNums, numPages, &file->fileHandle, pages);
+	pthread_mutex_unlock(&pool->ioLock);
+	if(result == RC_OK)
+	{
+		for(i = 0; i < numPages; i++)
+		{
+			if((index = findFrame(pool, bm->fileId, pageNum + i)) == -1)
+				continue;
+			// dirty again, so that a write of the old contents still in flight cannot be the last one
+			memcpy(pageFrame[index].info, pages[i], pool->pageSize);
+			pageFrame[index].dirtyBit = 1;
+			pageFrame[index].dirtyGen++;
+		}
+		pool->writeCount += numPages;
+		file->writeCount += numPages;
+	}
+	pthread_mutex_unlock(&pool->lock);
+	free(pageNums);
+	return result;
+}
+
+/*  FUNCTION NAME : showsFrame
+    DESCRIPTION   : Tells whether the statistics of bm report the page in a frame. A pool attached to a shared pool
+                    shows the frames holding pages of other files as empty. */
+
+static int showsFrame(BM_BufferPool *const bm, int index)
+{
+	return !isAttached(bm) || ((BufferPoolInfo *)bm->mgmtData)->pageFrame[index].fileId == bm->fileId;
 }
 
 /*  FUNCTION NAME : getFrameContents
@@ -299,14 +1858,18 @@ extern RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page)
 
 extern PageNumber *getFrameContents (BM_BufferPool *const bm)
 {
-	PageNumber *frameContents = malloc(sizeof(PageNumber) * bufferCapacity);
-	PageFrame *pageFrame = (PageFrame *) bm->mgmtData;
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
+	PageNumber *frameContents = malloc(sizeof(PageNumber) * pool->bufferCapacity);
+	PageFrame *pageFrame = pool->pageFrame;
 	
 	int i = 0;
-	while(i < bufferCapacity) {
-		frameContents[i] = (pageFrame[i].pageNum != -1) ? pageFrame[i].pageNum : NO_PAGE;
+	pthread_mutex_lock(&pool->lock);
+	finishReadAhead(pool);
+	while(i < pool->bufferCapacity) {
+		frameContents[i] = (pageFrame[i].pageNum != -1 && showsFrame(bm, i)) ? pageFrame[i].pageNum : NO_PAGE;
 		i++;
 	}
+	pthread_mutex_unlock(&pool->lock);
 	return frameContents;
 }
 
@@ -316,14 +1879,18 @@ extern PageNumber *getFrameContents (BM_BufferPool *const bm)
 
 extern bool *getDirtyFlags (BM_BufferPool *const bm)
 {
-	bool *dirtyFlags = malloc(sizeof(bool) * bufferCapacity);
-	PageFrame *pageFrame = (PageFrame *)bm->mgmtData;
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
+	bool *dirtyFlags = malloc(sizeof(bool) * pool->bufferCapacity);
+	PageFrame *pageFrame = pool->pageFrame;
 	
 	int i;
-	for(i = 0; i < bufferCapacity; i++)
+	pthread_mutex_lock(&pool->lock);
+	finishReadAhead(pool);
+	for(i = 0; i < pool->bufferCapacity; i++)
 	{
-		dirtyFlags[i] = (pageFrame[i].dirtyBit == 1) ? true : false ;
+		dirtyFlags[i] = (pageFrame[i].dirtyBit == 1 && showsFrame(bm, i)) ? true : false ;
 	}	
+	pthread_mutex_unlock(&pool->lock);
 	return dirtyFlags;
 }
 
@@ -332,61 +1899,310 @@ extern bool *getDirtyFlags (BM_BufferPool *const bm)
 
 extern int *getFixCounts (BM_BufferPool *const bm)
 {
-	int *totalCounts = malloc(sizeof(int) * bufferCapacity);
-	PageFrame *pageFrame= (PageFrame *)bm->mgmtData;
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
+	int *totalCounts = malloc(sizeof(int) * pool->bufferCapacity);
+	PageFrame *pageFrame = pool->pageFrame;
 	
 	int i = 0;
-	while(i < bufferCapacity)
+	pthread_mutex_lock(&pool->lock);
+	finishReadAhead(pool);
+	while(i < pool->bufferCapacity)
 	{
-		totalCounts[i] = (pageFrame[i].totalCount != -1) ? pageFrame[i].totalCount : 0;
+		int totalCount = ATOMIC_LOAD(pageFrame[i].totalCount);
+		totalCounts[i] = (totalCount != -1 && showsFrame(bm, i)) ? totalCount : 0;
 		i++;
 	}	
+	pthread_mutex_unlock(&pool->lock);
 	return totalCounts;
 }
 
 /*  FUNCTION NAME : getNumReadIO
-    DESCRIPTION   : This function returns the number of pages that have been read from disk since a buffer pool has been initialized. */
+    DESCRIPTION   : This function returns the number of pages that have been read from disk since a buffer pool has been initialized.
+                    A pool attached to a shared pool counts the pages of its file. */
 
 extern int getNumReadIO (BM_BufferPool *const bm)
 {
-	return (rearIndex + 1);
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
+	pthread_mutex_lock(&pool->lock);
+	finishReadAhead(pool);
+	int readCount = isAttached(bm) ? pool->files[bm->fileId]->readCount : pool->rearIndex + 1;
+	pthread_mutex_unlock(&pool->lock);
+	return readCount;
 }
 
 /*  FUNCTION NAME : getNumWriteIO
-    DESCRIPTION   : It returns the number of pages written to the page file since the buffer pool has been initialized. */
+    DESCRIPTION   : It returns the number of pages written to the page file since the buffer pool has been initialized.
+                    A pool attached to a shared pool counts the pages of its file. */
 
 extern int getNumWriteIO (BM_BufferPool *const bm)
 {
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
+	pthread_mutex_lock(&pool->lock);
+	int writeCount = isAttached(bm) ? pool->files[bm->fileId]->writeCount : pool->writeCount;
+	pthread_mutex_unlock(&pool->lock);
 	return writeCount;
 }
 
-/*  FUNCTION NAME : pinPage
-    DESCRIPTION   : This function pins the page with page number pageNum.
+/*  FUNCTION NAME : takeFrame
+    DESCRIPTION   : Picks the frame a page that is not cached is loaded into, the caller holds the pool lock.
+                    Free frames are used first, then the replacement strategy picks an unpinned frame whose arena slot is reused.
+                    The frame is out of the page table when this returns. Fails with the error of writing back the victim,
+                    which then keeps its page. Sets promote when ARC found pageNum in a ghost list, see installPage. */
+
+static RC takeFrame (BM_BufferPool *const bm, const PageNumber pageNum, int *index, int *promote)
+{
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
+	RC result;
+	int i;
+
+	*promote = 0;
+	if(pool->framesInUse < pool->bufferCapacity)
+	{
+		*index = pool->framesInUse++;
+		return RC_OK;
+	}
+	// the buffer is full, the replacement strategy picks an unpinned frame whose arena slot is reused
+	// a latched pin may get to the victim before it leaves the page table, then the strategy picks again
+	do
+	{
+		switch(bm->strategy)
+		{			
+			case RS_FIFO: //FIFO algorithm
+				result = FIFO(bm, &i);
+				break;
+		
+			case RS_LRU: // LRU algorithm
+				result = LRU(bm, &i);
+				break;
+			case RS_CLOCK:
+				result = CLOCK(bm, &i);
+				break;
+			case RS_LFU:
+				result = LFU(bm, &i);
+				break;
+			case RS_LRU_K:
+				result = LRU_K(bm, &i);
+				break;
+			case RS_ARC:
+				result = ARC(bm, pageNum, &i, promote);
+				break;
+			default:
+				printf("\n No Algorithm Implemented\n");
+				return RC_ERROR;
+		}
+		// the victim could not be written back, it keeps its page and the pin fails rather than losing it
+		if(result != RC_OK)
+			return result;
+		if(i == -1 && pool->readAheadFrames == NULL)
+			return RC_PINNED_PAGES_IN_BUFFER;
+		if(i == -1)
+			finishReadAhead(pool); // the frames of a read-ahead in flight are only pinned until it is done
+	} while(i == -1 || !evictPage(pool, i));
+	lruUnlink(pool, i);
+	*index = i;
+	return RC_OK;
+}
+
+/*  FUNCTION NAME : readAhead
+    DESCRIPTION   : Starts reading up to numPages pages of the file of bm from startPage on that are not cached yet with one asynchronous
+                    vectored read and returns without waiting for it, see finishReadAhead. Only one read-ahead is in flight.
+                    It stops at the end of the file, at the first page already cached, when every frame is pinned and
+                    after a victim that had to be written back, so read-ahead never costs more than one write.
+                    Returns the number of pages being read, the caller holds the pool lock. */
+
+static int readAhead (BM_BufferPool *const bm, const PageNumber startPage, int numPages)
+{
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
+	PageFrame *pageFrame = pool->pageFrame;
+	SM_IORequest *request = &pool->readAheadRequest;
+	SM_FileHandle *fileHandle = &pool->files[bm->fileId]->fileHandle;
+	int count = 0, writes;
+
+	finishReadAhead(pool);
+	// only pages that exist are worth reading ahead, the file only grows so the bound stays valid
+	pthread_mutex_lock(&pool->ioLock);
+	if(numPages > fileHandle->totalNumPages - startPage)
+		numPages = fileHandle->totalNumPages - startPage;
+	pthread_mutex_unlock(&pool->ioLock);
+	if(numPages > pool->bufferCapacity)
+		numPages = pool->bufferCapacity;
+	if(numPages <= 0)
+		return 0;
+	int *frames = malloc(sizeof(int) * numPages);
+	int *promote = malloc(sizeof(int) * numPages);
+	SM_PageHandle *memPages = malloc(sizeof(SM_PageHandle) * numPages);
+
+	while(count < numPages && findFrame(pool, bm->fileId, startPage + count) == -1)
+	{
+		writes = pool->writeCount;
+		if(takeFrame(bm, startPage + count, &frames[count], &promote[count]) != RC_OK)
+			break;
+		// a frame taken stays pinned until its page is installed, so the strategy does not hand it out again
+		ATOMIC_STORE(pageFrame[frames[count]].totalCount, 1);
+		memPages[count] = pageFrame[frames[count]].info;
+		count++;
+		if(pool->writeCount != writes)
+			break;
+	}
+	if(count == 0)
+	{
+		free(frames);
+		free(promote);
+		free(memPages);
+		return 0;
+	}
+
+	request->pageNum = startPage;
+	request->numPages = count;
+	request->memPages = memPages;
+	request->write = 0;
+	pthread_mutex_lock(&pool->ioLock);
+	// a read that cannot be submitted leaves zero filled pages, like loadPage
+	request->result = submitBlocks(fileHandle, &request, 1);
+	pthread_mutex_unlock(&pool->ioLock);
+	pool->readAheadFile = bm->fileId;
+	pool->readAheadFrames = frames;
+	pool->readAheadPromote = promote;
+	return count;
+}
+
+/*  FUNCTION NAME : readAheadSequential
+    DESCRIPTION   : Reads the next readAheadPages pages of a sequential scan ahead, from startPage on.
+                    The first of them is marked, pinning it starts the following read-ahead, so the scan does not wait
+                    for the disk as long as it takes longer to work through the pages than to read them. */
+
+static void readAheadSequential (BM_BufferPool *const bm, const PageNumber startPage)
+{
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
+	int count = readAhead(bm, startPage, pool->readAheadPages);
+	PoolFile *file = pool->files[bm->fileId];
+
+	file->nextSequential = startPage + count;
+	ATOMIC_STORE(file->readAheadMark, (count > 0) ? startPage : -1);
+}
+
+/*  FUNCTION NAME : mapBufferPool
+    DESCRIPTION   : Makes the pool serve its pages straight from a memory mapping of the page file. pinPage then hands out the
+                    address of the page in the mapping, a miss copies nothing and each page is only cached once, by the kernel.
+                    Frames still track pins, dirty pages and replacement, writing a page back syncs it to disk.
+                    sequential asks the kernel to read ahead aggressively, otherwise it expects random access.
+                    Only possible before the first page is pinned and while no background writer runs, and not for shared pools. */
+
+extern RC mapBufferPool (BM_BufferPool *const bm, const bool sequential)
+{
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
+	RC result = RC_ERROR;
+	int i;
+
+	pthread_mutex_lock(&pool->lock);
+	if(pool->framesInUse == 0 && pool->writerState == WRITER_STOPPED && !pool->shared)
+	{
+		pthread_mutex_lock(&pool->ioLock);
+		result = mapPageFile(&pool->files[0]->fileHandle, sequential);
+		pthread_mutex_unlock(&pool->ioLock);
+	}
+	if(result == RC_OK && !pool->mapped)
+	{
+		// frames point into the mapping once they hold a page, the arena is not needed any more
+		free(pool->arena);
+		pool->arena = NULL;
+		for(i = 0; i < pool->bufferCapacity; i++)
+			pool->pageFrame[i].info = NULL;
+		pool->readAheadPages = 0;
+		pool->mapped = 1;
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return result;
+}
+
+/*  FUNCTION NAME : directBufferPool
+    DESCRIPTION   : Reopens the page file of the pool with openPageFileDirect. Pages then move between the frames and the disk
+                    without a second copy in the OS page cache, so the pool size is the memory the pages really take.
+                    The frames are page aligned, so reads and writes go straight to them.
+                    Only possible before the first page is pinned and not for mapped pools. Where the file system does not
+                    support direct I/O the pool keeps using the page cache and the error is returned. */
+
+extern RC directBufferPool (BM_BufferPool *const bm)
+{
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
+	RC result = RC_ERROR;
+
+	pthread_mutex_lock(&pool->lock);
+	if(pool->framesInUse == 0 && !pool->mapped && bm->fileId >= 0)
+	{
+		SM_FileHandle *fileHandle = &pool->files[bm->fileId]->fileHandle;
+		pthread_mutex_lock(&pool->ioLock);
+		closePageFile(fileHandle);
+		result = openPageFileDirect(bm->pageFile, fileHandle);
+		if(result != RC_OK)
+			openPageFile(bm->pageFile, fileHandle);
+		pthread_mutex_unlock(&pool->ioLock);
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return result;
+}
+
+/*  FUNCTION NAME : prefetchPages
+    DESCRIPTION   : Hint that pages pageNum to pageNum + numPages - 1 will be pinned soon. The pages not cached yet are
+                    read ahead in the background and stay unpinned once read, see readAhead. */
+
+extern RC prefetchPages (BM_BufferPool *const bm, const PageNumber pageNum, const int numPages)
+{
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
+
+	if(pageNum < 0 || bm->fileId < 0)
+		return RC_READ_NON_EXISTING_PAGE;
+	if(pool->mapped)
+	{
+		// the kernel reads the mapped pages ahead, they are cached in no frame until pinned
+		pthread_mutex_lock(&pool->ioLock);
+		prefetchMappedBlocks(pageNum, numPages, &pool->files[0]->fileHandle);
+		pthread_mutex_unlock(&pool->ioLock);
+		return RC_OK;
+	}
+	pthread_mutex_lock(&pool->lock);
+	readAhead(bm, pageNum, numPages);
+	PoolFile *file = pool->files[bm->fileId];
+	if(file->readAheadMark >= pageNum && file->readAheadMark < pageNum + numPages)
+		ATOMIC_STORE(file->readAheadMark, -1);
+	pthread_mutex_unlock(&pool->lock);
+	return RC_OK;
+}
+
+/*  FUNCTION NAME : pinFrame
+    DESCRIPTION   : This function pins the page with page number pageNum, the caller holds the pool lock, see loadPage.
 	                It first checks if the buffer is full, if buffer is full it calls one of the replacement strategy.
 	                lse pages are read and pinned by using readBlock() and the count variable of the page TotalFix is incremented.*/
 
-extern RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page, 
+static RC pinFrame (BM_BufferPool *const bm, BM_PageHandle *const page, 
 	    const PageNumber pageNum)
 {
-	PageFrame *pageFrame = (PageFrame *)bm->mgmtData;
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
+	PageFrame *pageFrame = pool->pageFrame;
+	PoolFile *file = pool->files[bm->fileId];
 
 	// used to check if negative pages are getting pinned
 	if(pageNum < -1){
         return RC_PIN_NEGATIVE_PAGE;
     }
-	if(pageFrame[0].pageNum == -1)
+	// a mapped pool addresses the page in the mapping before it gives up a frame for it
+	SM_PageHandle mapped = NULL;
+	if(pool->framesInUse == 0)
 	{
-		
-		SM_FileHandle fh;
-		openPageFile(bm->pageFile, &fh);
-		pageFrame[0].info = (SM_PageHandle) malloc(PAGE_SIZE);
-        printf("\n negative page");
-		ensureCapacity(pageNum,&fh);
-		readBlock(pageNum, &fh, pageFrame[0].info);
-		pageFrame[0].pageNum = pageNum;
-		pageFrame[0].totalCount++;
-		rearIndex = hit = 0;
-		pageFrame[0].hitNum = hit;	
+		if(pool->mapped && (mapped = mapPage(pool, bm->fileId, pageNum)) == NULL)
+			return RC_READ_NON_EXISTING_PAGE;
+		pthread_mutex_lock(&pool->ioLock);
+		ensureCapacity(pageNum,&file->fileHandle);
+		pthread_mutex_unlock(&pool->ioLock);
+		// frame 0 is taken before the read, so pins of other pages meanwhile fill the next frames
+		pool->framesInUse = 1;
+		pool->rearIndex = 0;
+		RC result = loadPage(pool, 0, bm->fileId, pageNum, mapped, 0);
+		if(result != RC_OK)
+			return result;
+		file->sequentialMisses = 1;
+		file->nextSequential = pageNum + 1;
+		ATOMIC_STORE(pageFrame[0].hitNum, 0);
 		page->pageNum = pageNum;
 		page->data = pageFrame[0].info;
 		
@@ -394,93 +2210,108 @@ extern RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page,
 	}
 	else
 	{	
-		int i;
-		bool isBufferFull = true;
-		
-		for(i = 0; i < bufferCapacity; i++)
+		// a page being read ahead is cached once the read is done
+		SM_IORequest *request = &pool->readAheadRequest;
+		if(pool->readAheadFrames != NULL && pool->readAheadFile == bm->fileId && pageNum >= request->pageNum && pageNum < request->pageNum + request->numPages)
+			finishReadAhead(pool);
+
+		// the page table answers hits directly, misses fill the next free frame until the pool is full.
+		// A page another pin is reading is waited for, it is looked up again as the read may have failed
+		int i = findFrame(pool, bm->fileId, pageNum);
+		while(i != -1 && pageFrame[i].loading)
 		{
-			if(pageFrame[i].pageNum != -1)
-			{	
-				
-				if(pageFrame[i].pageNum == pageNum)
-				{
-					
-					pageFrame[i].totalCount++;
-					isBufferFull = false;
-					hit++; 
-
-					if(bm->strategy == RS_LRU)	
-						pageFrame[i].hitNum = hit;
-                    else if(bm->strategy == RS_CLOCK)
-						pageFrame[i].hitNum = 1;
-					page->pageNum = pageNum;
-					page->data = pageFrame[i].info;
-                    clockPointer++;
-					break;
-				}				
-			} else {
-				SM_FileHandle fh;
-				openPageFile(bm->pageFile, &fh);
-				pageFrame[i].info = (SM_PageHandle) malloc(PAGE_SIZE);
-				readBlock(pageNum, &fh, pageFrame[i].info);
-				pageFrame[i].pageNum = pageNum;
-				pageFrame[i].totalCount = 1;
-				
-				rearIndex++;	
-				hit++; 
-				if(bm->strategy == RS_LRU)
-					pageFrame[i].hitNum = hit;
-                else if(bm->strategy == RS_CLOCK)
-						pageFrame[i].hitNum = 1;				
-				page->pageNum = pageNum;
-				page->data = pageFrame[i].info;
-				
-				isBufferFull = false;
-				break;
-			}
+			pthread_cond_wait(&pool->pageLoaded, &pool->lock);
+			i = findFrame(pool, bm->fileId, pageNum);
 		}
 		
-		
-		if(isBufferFull == true)
+		if(i != -1)
 		{
-			
-			PageFrame *newPage = (PageFrame *) malloc(sizeof(PageFrame));		
-			SM_FileHandle fh;
-			openPageFile(bm->pageFile, &fh);
-			newPage->info = (SM_PageHandle) malloc(PAGE_SIZE);
-			readBlock(pageNum, &fh, newPage->info);
-			newPage->pageNum = pageNum;
-			newPage->dirtyBit = 0;		
-			newPage->totalCount = 1;
-			rearIndex++;
-			hit++;
-
-			if(bm->strategy == RS_LRU)
-				newPage->hitNum = hit;	
-            else if(bm->strategy == RS_CLOCK)
-				pageFrame[i].hitNum = 1;		
+			if(ATOMIC_ADD(pageFrame[i].totalCount, 1) == 1)
+				framePinned(pool, i);
+			recordReference(pool, i, pageFrame[i].prefetched, 0);
+			pageFrame[i].prefetched = 0;
+			// move to front so the list stays ordered by last pin
+			lruUnlink(pool, i);
+			lruPushFront(pool, i);
 
+			if(bm->strategy == RS_CLOCK)
+				ATOMIC_STORE(pageFrame[i].hitNum, 1);
 			page->pageNum = pageNum;
-			page->data = newPage->info;			
-
-			switch(bm->strategy)
-			{			
-				case RS_FIFO: //FIFO algorithm
-					FIFO(bm, newPage);
-					break;
-				
-				case RS_LRU: // LRU algorithm
-					LRU(bm, newPage);
-					break;
-				case RS_CLOCK:
-                     CLOCK(bm, newPage);
-                     break;
-				default:
-					printf("\n No Algorithm Implemented\n");
-					break;
-			}
-						
-		}		
+			page->data = pageFrame[i].info;
+			ATOMIC_ADD(pool->clockPointer, 1);
+			if(pageNum == file->readAheadMark)
+				readAheadSequential(bm, file->nextSequential);
+			return RC_OK;
+		}
+		
+		if(pool->mapped && (mapped = mapPage(pool, bm->fileId, pageNum)) == NULL)
+			return RC_READ_NON_EXISTING_PAGE;
+		int promote;
+		RC result = takeFrame(bm, pageNum, &i, &promote);
+		if(result != RC_OK)
+			return result;
+		
+		result = loadPage(pool, i, bm->fileId, pageNum, mapped, promote);
+		pool->rearIndex++;
+		if(result != RC_OK)
+			return result;
+		if(bm->strategy == RS_CLOCK)
+			ATOMIC_STORE(pageFrame[i].hitNum, 1);
+		page->pageNum = pageNum;
+		page->data = pageFrame[i].info;
+
+		// a run of misses on consecutive pages looks like a scan, so the pages it will ask for next are read in one go
+		file->sequentialMisses = (pageNum == file->nextSequential) ? file->sequentialMisses + 1 : 1;
+		file->nextSequential = pageNum + 1;
+		if(file->sequentialMisses >= READ_AHEAD_TRIGGER && pool->readAheadPages > 0)
+			readAheadSequential(bm, pageNum + 1);
 		return RC_OK;
 	}	
-}
\ No newline at end of file
+}
+
+/*  FUNCTION NAME : pinPage
+    DESCRIPTION   : This function pins the page with page number pageNum, see pinFrame.
+                    Several threads may pin and unpin pages of the same pool. FIFO and CLOCK hits only take the latch of
+                    one page table partition and update the pin count and reference bit atomically. Misses, hits on the
+                    read-ahead mark, which start the next read-ahead, and every pin under the list based strategies,
+                    whose hits reorder shared lists, take the pool lock. A miss releases it while it reads the page,
+                    so pins of other pages go on meanwhile. */
+
+extern RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page, 
+	    const PageNumber pageNum)
+{
+	BufferPoolInfo *pool = (BufferPoolInfo *)bm->mgmtData;
+
+	// the pages of a shared pool are pinned through the pools attached to it
+	if(bm->fileId < 0)
+		return RC_FILE_HANDLE_NOT_INIT;
+	if(pool->latchedHits && pageNum >= 0)
+	{
+		// a FIFO or CLOCK hit only needs the partition latch, it takes no pool wide lock
+		PageTablePartition *partition = partitionOf(pool, bm->fileId, pageNum);
+		pthread_mutex_lock(&partition->latch);
+		int i = pageTableFind(&partition->table, bm->fileId, pageNum);
+		// pinning the read-ahead mark starts the next read-ahead, which needs the pool lock, as does waiting for a page being read
+		if(i != -1 && (pool->pageFrame[i].loading || pageNum == ATOMIC_LOAD(pool->files[bm->fileId]->readAheadMark)))
+			i = -1;
+		if(i != -1)
+		{
+			ATOMIC_ADD(pool->pageFrame[i].totalCount, 1);
+			if(bm->strategy == RS_CLOCK)
+				ATOMIC_STORE(pool->pageFrame[i].hitNum, 1);
+			ATOMIC_ADD(pool->clockPointer, 1);
+		}
+		pthread_mutex_unlock(&partition->latch);
+		if(i != -1)
+		{
+			page->pageNum = pageNum;
+			page->data = pool->pageFrame[i].info;
+			return RC_OK;
+		}
+	}
+
+	pthread_mutex_lock(&pool->lock);
+	RC result = pinFrame(bm, page, pageNum);
+	pthread_mutex_unlock(&pool->lock);
+	return result;
+}
@@ -13,7 +13,8 @@ typedef enum ReplacementStrategy {
 	RS_LRU = 1,
 	RS_CLOCK = 2,
 	RS_LFU = 3,
-	RS_LRU_K = 4
+	RS_LRU_K = 4,
+	RS_ARC = 5
 } ReplacementStrategy;
 
 // Data Types and Structures
@@ -23,6 +24,8 @@ typedef int PageNumber;
 typedef struct BM_BufferPool {
 	char *pageFile;
 	int numPages;
+	int pageSize; // bytes in every page of pageFile, set by initBufferPool
+	int fileId; // identifies pageFile among the files of a shared pool, see attachBufferPool
 	ReplacementStrategy strategy;
 	void *mgmtData; // use this one to store the bookkeeping info your buffer
 	// manager needs for a buffer pool
@@ -47,12 +50,30 @@ RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
 RC shutdownBufferPool(BM_BufferPool *const bm);
 RC forceFlushPool(BM_BufferPool *const bm);
 
+// Shared Buffer Pools
+RC initSharedBufferPool(BM_BufferPool *const bm, const int numPages, const int pageSize,
+		ReplacementStrategy strategy, void *stratData);
+RC attachBufferPool(BM_BufferPool *const bm, BM_BufferPool *const sharedPool,
+		const char *const pageFileName);
+
 // Buffer Manager Interface Access Pages
 RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC unpinPage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page, 
 		const PageNumber pageNum);
+RC prefetchPages (BM_BufferPool *const bm, const PageNumber pageNum, const int numPages);
+RC writePages (BM_BufferPool *const bm, const PageNumber pageNum, const int numPages, char **pages);
+
+// Memory Mapped Pools
+RC mapBufferPool (BM_BufferPool *const bm, const bool sequential);
+
+// Direct I/O Pools
+RC directBufferPool (BM_BufferPool *const bm);
+
+// Background Writer
+RC startBackgroundWriter (BM_BufferPool *const bm);
+RC stopBackgroundWriter (BM_BufferPool *const bm);
 
 // Statistics Interface
 PageNumber *getFrameContents (BM_BufferPool *const bm);
@@ -1,102 +1,1065 @@
+// fallocate is a GNU extension
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
 #include<stdio.h>
 #include<stdlib.h>
 #include<sys/stat.h>
 #include<sys/types.h>
+#include<fcntl.h>
 #include<unistd.h>
+#include<limits.h>
+#include<sys/uio.h>
+#include<sys/mman.h>
+#include<sys/syscall.h>
+#include<stdint.h>
+#include<errno.h>
+#include<pthread.h>
 #include<string.h>
 #include<math.h>
 
+#ifdef __x86_64__
+#include<nmmintrin.h>
+#define SM_CRC32C_SSE42
+#endif
+
+#if defined(__linux__) && !defined(SM_NO_IO_URING)
+#include<linux/io_uring.h>
+#define SM_IO_URING
+#endif
+
 #include "storage_mgr.h"
 
-FILE *pageFile;
+// most iovecs one vectored read takes, POSIX only guarantees IOV_MAX with XSI extensions enabled
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+// the first FILE_HEADER_SIZE bytes of a page file hold its FileHeader, block n of a file with pages of pageSize bytes
+// starts at BLOCK_OFFSET(pageSize, n). The header takes PAGE_SIZE bytes whatever the page size of the file,
+// so blocks stay aligned to the pages of the OS for mapping them
+#define FILE_HEADER_SIZE PAGE_SIZE
+#define BLOCK_OFFSET(pageSize, pageNum) ((off_t)(pageNum) * (pageSize) + FILE_HEADER_SIZE)
+#define PAGE_FILE_MAGIC "ADOPAGES"
+
+// files opened with openPageFileDirect transfer blocks between buffers aligned to this many bytes and the disk
+// without the OS page cache, where O_DIRECT is missing they are opened like any other file
+#define DIRECT_IO_ALIGNMENT PAGE_SIZE
+#define IS_ALIGNED(buffer) (((uintptr_t)(buffer) & (DIRECT_IO_ALIGNMENT - 1)) == 0)
+#ifndef O_DIRECT
+#define O_DIRECT 0
+#endif
+
+// flags in the header of a page file
+#define FILE_CHECKSUMS SM_PAGE_CHECKSUMS // every page ends in a PAGE_TRAILER_SIZE byte CRC32C of the rest of it
+#define FILE_COMPRESSED SM_PAGE_COMPRESSION // blocks are stored compressed wherever the page map says
+
+// reflected Castagnoli polynomial of the page checksums
+#define CRC32C_POLY 0x82F63B78
+
+// pages are checksummed in blocks of three lanes of this many bytes, sized so the checksummed part of a PAGE_SIZE
+// page is one block and the few bytes left behind it
+#define CRC32C_LANE ((PAGE_SIZE - PAGE_TRAILER_SIZE) / 24 * 8)
+
+// a compressed file is laid out in slots of SLOT_SIZE bytes, a block takes as many of them as its compressed form needs
+#define SLOT_SIZE 512
+
+// a page map block takes PAGE_SIZE bytes whatever the page size of the file. It holds the PageMapEntry of
+// MAP_ENTRIES_PER_PAGE blocks and is written back one slot at a time.
+// The header has room for MAP_PAGES page map blocks, which limits the number of blocks of a compressed file
+#define MAP_BLOCK_SLOTS (PAGE_SIZE / SLOT_SIZE)
+#define MAP_ENTRIES_PER_PAGE (PAGE_SIZE / (int)sizeof(PageMapEntry))
+#define MAP_ENTRIES_PER_SLOT (SLOT_SIZE / (int)sizeof(PageMapEntry))
+#define MAP_PAGES 960
+
+// blocks of pageSize bytes not compressing below this many bytes are stored as they are
+#define COMPRESSED_MAX_SIZE(pageSize) ((pageSize) - SLOT_SIZE)
+
+// compressed blocks stored right behind each other that readBlocks fetches with one read at most
+#define COMPRESSED_READ_PAGES 64
+
+// the block compressor looks for matches of at least MATCH_MIN bytes through a table of 2^MATCH_HASH_BITS entries,
+// each holding a position + 1 in a page of at most MAX_PAGE_SIZE bytes
+#define MATCH_MIN 4
+#define MATCH_HASH_BITS 12
+
+// a growing file gets space for as many blocks again as it has, at least EXTENT_MIN_PAGES and at most EXTENT_MAX_PAGES at once
+#define EXTENT_MIN_PAGES 16
+#define EXTENT_MAX_PAGES 16384
+
+// asynchronous requests one open page file keeps in flight at most, submitBlocks waits for completions beyond that
+#define IO_QUEUE_DEPTH 64
+
+// threads serving asynchronous requests when io_uring is not available
+#define IO_THREADS 4
+
+// address space reserved for the mapping of a page file, it grows in place so mapped pages never move.
+// Smaller reservations are tried down to the file size if this much is not available
+#define MAP_RESERVE_SIZE ((size_t)1 << 36)
+
+// Struct IOQueue runs the asynchronous requests of one page file, on an io_uring when the kernel offers one
+// and on IO_THREADS threads doing positioned reads and writes otherwise
+typedef struct IOQueue
+{
+	int fd;
+	int pageSize; // bytes in a block of the file
+	int inFlight; // submitted requests that have not completed yet
+	SM_IORequest *doneHead; // completed requests completeBlocks has not handed back yet, oldest first
+	SM_IORequest *doneTail;
+	int numDone;
+	pthread_mutex_t lock; // guards the lists and counts against the I/O threads
+	pthread_cond_t completion; // signalled by the I/O threads whenever a request completes
+	pthread_cond_t work; // signalled when a request is queued for the I/O threads or they should stop
+	SM_IORequest *queueHead; // requests waiting for an I/O thread
+	SM_IORequest *queueTail;
+	pthread_t threads[IO_THREADS];
+	int numThreads; // 0 when the io_uring serves the requests
+	int stopping;
+#ifdef SM_IO_URING
+	int ringFd; // -1 when the I/O threads serve the requests
+	void *sqRing;
+	size_t sqRingSize;
+	void *cqRing; // same mapping as sqRing if the kernel maps both rings at once
+	size_t cqRingSize;
+	struct io_uring_sqe *sqes;
+	size_t sqesSize;
+	unsigned *sqTail;
+	unsigned *sqMask;
+	unsigned *sqArray;
+	unsigned *cqHead;
+	unsigned *cqTail;
+	unsigned *cqMask;
+	struct io_uring_cqe *cqes;
+#endif
+} IOQueue;
+
+// Struct FileHeader is stored at the start of every page file
+typedef struct FileHeader
+{
+	char magic[8]; // PAGE_FILE_MAGIC, tells page files from other files
+	int totalNumPages; // blocks in use, space for more may already be allocated behind them
+	int flags; // FILE_CHECKSUMS, FILE_COMPRESSED
+	int mapPages[MAP_PAGES]; // first slot of each page map block of a compressed file, 0 behind the last one
+	int pageSize; // bytes in a block, files from before it was kept have 0 here and PAGE_SIZE byte blocks
+} FileHeader;
+
+// Struct PageMapEntry tells where a block of a compressed file is stored
+typedef struct PageMapEntry
+{
+	uint32_t slot; // first slot of the compressed block
+	uint32_t length; // bytes it takes, 0 for a block holding zeros only and the page size for one stored as it is
+} PageMapEntry;
+
+// Struct PageMap is the page map of an open compressed file, its entries are loaded by openPageFile and
+// the slots not in use are worked out from them
+typedef struct PageMap
+{
+	int mapPages[MAP_PAGES]; // copy of the header's
+	int numMapPages; // page map blocks in use
+	PageMapEntry *entries; // the entries of all page map blocks, laid out like on disk
+	unsigned char *usedSlots; // bitmap of the slots taken by the header, page map blocks and compressed blocks
+	int numSlots; // slots usedSlots has bits for, the ones behind are free
+	int firstFree; // every slot before it is in use
+	char *buffer; // compressed form of the block being written, or a few small blocks being read, one page long
+} PageMap;
+
+// Struct FileInfo is hung off SM_FileHandle.mgmtInfo while a page file is open
+typedef struct FileInfo
+{
+	int fd; // descriptor kept open from openPageFile until closePageFile
+	IOQueue *queue; // set up by the first submitBlocks, NULL until then
+	char *map; // start of the address space reserved by mapPageFile, NULL while the file is not mapped
+	size_t mapReserved; // bytes reserved
+	size_t mapLength; // bytes from the start of the file mapped so far
+	int mapAdvice; // madvise hint applied to every part of the mapping
+	int allocatedPages; // blocks the file has space for, blocks behind totalNumPages read as zeros
+	int headerPages; // page count stored in the header, behind totalNumPages while the file grows within its space
+	int flags; // copy of the flags in the header
+	int pageSize; // copy of the page size in the header
+	int direct; // opened with O_DIRECT, every transfer needs an aligned buffer
+	SM_PageHandle bounce; // aligned page unaligned buffers of a direct file are copied through, allocated on first use
+	PageMap *pageMap; // where the blocks of a compressed file are, NULL for other files
+} FileInfo;
+
+static void closeQueue (IOQueue *queue);
+
+static uint32_t crc32cTable[256]; // software CRC32C, one byte at a time
+static uint32_t crc32cShift[4][256]; // crc32cShift[k][b] is what CRC32C_LANE zero bytes turn the CRC b << 8k into
+static int crc32cHardware; // the CPU has the SSE4.2 crc32 instruction
+static pthread_once_t crc32cOnce = PTHREAD_ONCE_INIT;
+
+/* FUNCTION NAME : initCrc32c
+   DESCRIPTION   : builds the tables of the software CRC32C and of crc32cShiftLane and checks for the crc32 instruction,
+                   once per process */
+
+static void initCrc32c (void) {
+	uint32_t i, bit, n, k, basis[32];
+	for(i = 0; i < 256; i++) {
+		uint32_t crc = i;
+		for(bit = 0; bit < 8; bit++)
+			crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+		crc32cTable[i] = crc;
+	}
+	// running a CRC over zero bytes is linear in the CRC, so the shift of each bit is all it takes
+	for(bit = 0; bit < 32; bit++) {
+		uint32_t crc = (uint32_t)1 << bit;
+		for(n = 0; n < CRC32C_LANE; n++)
+			crc = crc32cTable[crc & 0xFF] ^ (crc >> 8);
+		basis[bit] = crc;
+	}
+	for(k = 0; k < 4; k++)
+		for(i = 0; i < 256; i++) {
+			crc32cShift[k][i] = 0;
+			for(bit = 0; bit < 8; bit++)
+				if(i & (1 << bit))
+					crc32cShift[k][i] ^= basis[8 * k + bit];
+		}
+#ifdef SM_CRC32C_SSE42
+	crc32cHardware = __builtin_cpu_supports("sse4.2");
+#endif
+}
+
+/* FUNCTION NAME : crc32cShiftLane
+   DESCRIPTION   : returns the CRC after running CRC32C_LANE zero bytes through crc */
+
+static uint32_t crc32cShiftLane (uint32_t crc) {
+	return crc32cShift[0][crc & 0xFF] ^ crc32cShift[1][(crc >> 8) & 0xFF] ^ crc32cShift[2][(crc >> 16) & 0xFF]
+	       ^ crc32cShift[3][crc >> 24];
+}
+
+// pages are read four or eight bytes at a time wherever they start
+typedef uint32_t unalignedInt __attribute__((aligned(1), may_alias));
+typedef uint64_t unalignedWord __attribute__((aligned(1), may_alias));
+
+#ifdef SM_CRC32C_SSE42
+
+/* FUNCTION NAME : crc32cSse42
+   DESCRIPTION   : continues a CRC32C over length bytes with the crc32 instruction, eight bytes at a time */
+
+__attribute__((target("sse4.2")))
+static uint32_t crc32cSse42 (uint32_t crc, const char *data, size_t length) {
+	uint64_t crc64 = crc;
+	for(; length >= 8; data += 8, length -= 8)
+		crc64 = _mm_crc32_u64(crc64, *(const unalignedWord *)data);
+	crc = (uint32_t)crc64;
+	for(; length > 0; data++, length--)
+		crc = _mm_crc32_u8(crc, (unsigned char)*data);
+	return crc;
+}
+
+/* FUNCTION NAME : crc32cSse42Block
+   DESCRIPTION   : continues a CRC32C over 3 * CRC32C_LANE bytes. One crc32 has to wait for the one before, so the three
+                   lanes are run side by side and their CRCs combined */
+
+__attribute__((target("sse4.2")))
+static uint32_t crc32cSse42Block (uint32_t crc, const char *data) {
+	const unalignedWord *a = (const unalignedWord *)data;
+	const unalignedWord *b = (const unalignedWord *)(data + CRC32C_LANE);
+	const unalignedWord *c = (const unalignedWord *)(data + 2 * CRC32C_LANE);
+	uint64_t crcA = crc, crcB = 0, crcC = 0;
+	int i;
+	for(i = 0; i < CRC32C_LANE / 8; i++) {
+		crcA = _mm_crc32_u64(crcA, a[i]);
+		crcB = _mm_crc32_u64(crcB, b[i]);
+		crcC = _mm_crc32_u64(crcC, c[i]);
+	}
+	crc = crc32cShiftLane((uint32_t)crcA) ^ (uint32_t)crcB;
+	return crc32cShiftLane(crc) ^ (uint32_t)crcC;
+}
+#endif
+
+/* FUNCTION NAME : crc32c
+   DESCRIPTION   : returns the CRC32C of length bytes */
+
+static uint32_t crc32c (const char *data, size_t length) {
+	uint32_t crc = 0xFFFFFFFF;
+	pthread_once(&crc32cOnce, initCrc32c);
+#ifdef SM_CRC32C_SSE42
+	if(crc32cHardware) {
+		for(; length >= 3 * CRC32C_LANE; data += 3 * CRC32C_LANE, length -= 3 * CRC32C_LANE)
+			crc = crc32cSse42Block(crc, data);
+		return ~crc32cSse42(crc, data, length);
+	}
+#endif
+	for(; length > 0; data++, length--)
+		crc = crc32cTable[(crc ^ (unsigned char)*data) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+/* FUNCTION NAME : sealPage
+   DESCRIPTION   : puts the checksum of a page about to be written into its trailer if the file has checksums */
+
+static void sealPage (FileInfo *info, SM_PageHandle memPage) {
+	if(!(info->flags & FILE_CHECKSUMS))
+		return;
+	uint32_t crc = crc32c(memPage, info->pageSize - PAGE_TRAILER_SIZE);
+	memcpy(memPage + info->pageSize - PAGE_TRAILER_SIZE, &crc, PAGE_TRAILER_SIZE);
+}
+
+/* FUNCTION NAME : checkPage
+   DESCRIPTION   : verifies the trailer of a page just read if the file has checksums. Pages the file grew by were never
+                   written and pass as long as they hold zeros only, a torn or corrupted page fails */
+
+static RC checkPage (FileInfo *info, SM_PageHandle memPage) {
+	uint32_t stored;
+	if(!(info->flags & FILE_CHECKSUMS))
+		return RC_OK;
+	memcpy(&stored, memPage + info->pageSize - PAGE_TRAILER_SIZE, PAGE_TRAILER_SIZE);
+	if(stored == crc32c(memPage, info->pageSize - PAGE_TRAILER_SIZE))
+		return RC_OK;
+	if(stored == 0 && memPage[0] == 0 && memcmp(memPage, memPage + 1, info->pageSize - 1) == 0)
+		return RC_OK;
+	return RC_PAGE_CHECKSUM_FAILED;
+}
+
+/* FUNCTION NAME : checkPages
+   DESCRIPTION   : verifies numPages pages just read, see checkPage */
+
+static RC checkPages (FileInfo *info, SM_PageHandle *memPages, int numPages) {
+	int i;
+	RC result = RC_OK;
+	for(i = 0; i < numPages && result == RC_OK; i++)
+		result = checkPage(info, memPages[i]);
+	return result;
+}
+
+/* FUNCTION NAME : emitLength
+   DESCRIPTION   : stores the part of a length a 4 bit field of a token cannot hold, as 255 valued bytes and a last smaller one */
+
+static unsigned char *emitLength (unsigned char *out, int length) {
+	if(length < 15)
+		return out;
+	for(length -= 15; length >= 255; length -= 255)
+		*out++ = 255;
+	*out++ = (unsigned char)length;
+	return out;
+}
+
+/* FUNCTION NAME : emitSequence
+   DESCRIPTION   : appends a sequence of literals followed by a match of length bytes distance bytes back, no match if length is 0.
+                   Returns 0 if it does not fit before end */
+
+static int emitSequence (unsigned char **out, unsigned char *end, const unsigned char *literals, int numLiterals,
+                         int distance, int length) {
+	unsigned char *op = *out;
+	int matchCode = length > 0 ? length - MATCH_MIN : 0;
+	if(op + 1 + numLiterals / 255 + 1 + numLiterals + 2 + matchCode / 255 + 1 > end)
+		return 0;
+	unsigned char *token = op++;
+	*token = (numLiterals < 15 ? numLiterals : 15) << 4;
+	op = emitLength(op, numLiterals);
+	memcpy(op, literals, numLiterals);
+	op += numLiterals;
+	if(length > 0) {
+		*token |= matchCode < 15 ? matchCode : 15;
+		*op++ = distance & 0xFF;
+		*op++ = distance >> 8;
+		op = emitLength(op, matchCode);
+	}
+	*out = op;
+	return 1;
+}
+
+/* FUNCTION NAME : compressPage
+   DESCRIPTION   : compresses a page into out with a byte oriented LZ77 in the style of LZ4. Every sequence is a token holding
+                   the number of literals and the match length less MATCH_MIN in 4 bits each, the literals and the 2 byte distance
+                   back to the match, the last sequence has no match. Returns the compressed size, or 0 if the page does not
+                   compress below COMPRESSED_MAX_SIZE bytes */
+
+static int compressPage (const char *page, int pageSize, char *out) {
+	const unsigned char *in = (const unsigned char *)page;
+	unsigned char *op = (unsigned char *)out, *end = op + COMPRESSED_MAX_SIZE(pageSize);
+	uint16_t table[1 << MATCH_HASH_BITS]; // position + 1 of the last MATCH_MIN bytes hashing to each entry, 0 for none
+	int ip = 0, anchor = 0, misses = 0;
+	memset(table, 0, sizeof(table));
+	while(ip + MATCH_MIN <= pageSize) {
+		uint32_t sequence = *(const unalignedInt *)(in + ip);
+		uint32_t hash = (sequence * 2654435761u) >> (32 - MATCH_HASH_BITS);
+		int ref = table[hash] - 1, length = MATCH_MIN;
+		table[hash] = ip + 1;
+		if(ref < 0 || *(const unalignedInt *)(in + ref) != sequence) {
+			// the longer nothing matches the faster it skips ahead, so incompressible pages are given up on quickly
+			ip += 1 + (misses++ >> 5);
+			continue;
+		}
+		while(ip + length + 8 <= pageSize && *(const unalignedWord *)(in + ref + length) == *(const unalignedWord *)(in + ip + length))
+			length += 8;
+		while(ip + length < pageSize && in[ref + length] == in[ip + length])
+			length++;
+		if(!emitSequence(&op, end, in + anchor, ip - anchor, ip - ref, length))
+			return 0;
+		ip += length;
+		anchor = ip;
+		misses = 0;
+	}
+	if(!emitSequence(&op, end, in + anchor, pageSize - anchor, 0, 0))
+		return 0;
+	return op - (unsigned char *)out;
+}
+
+/* FUNCTION NAME : readLength
+   DESCRIPTION   : returns a length whose 4 bit field in a token is code, reading the bytes extending it. -1 if they run past length */
+
+static int readLength (const unsigned char *in, int length, int *ip, int code) {
+	int byte;
+	if(code < 15)
+		return code;
+	do {
+		if(*ip >= length || code > MAX_PAGE_SIZE)
+			return -1;
+		byte = in[(*ip)++];
+		code += byte;
+	} while(byte == 255);
+	return code;
+}
+
+/* FUNCTION NAME : decompressPage
+   DESCRIPTION   : restores a page of pageSize bytes from the length bytes compressPage made of it, or copies it if it was
+                   stored as it is.
+                   Fails with RC_PAGE_CORRUPT unless they make up exactly one page */
+
+static RC decompressPage (const char *data, int length, char *page, int pageSize) {
+	const unsigned char *in = (const unsigned char *)data;
+	int ip = 0, op = 0;
+	if(length == pageSize) {
+		memcpy(page, data, pageSize);
+		return RC_OK;
+	}
+	while(ip < length) {
+		int token = in[ip++];
+		int numLiterals = readLength(in, length, &ip, token >> 4);
+		if(numLiterals < 0 || numLiterals > length - ip || numLiterals > pageSize - op)
+			return RC_PAGE_CORRUPT;
+		memcpy(page + op, in + ip, numLiterals);
+		ip += numLiterals;
+		op += numLiterals;
+		if(ip == length)
+			break;
+		if(length - ip < 2)
+			return RC_PAGE_CORRUPT;
+		int distance = in[ip] | in[ip + 1] << 8;
+		ip += 2;
+		int matchLength = readLength(in, length, &ip, token & 15);
+		if(matchLength < 0 || distance == 0 || distance > op || matchLength + MATCH_MIN > pageSize - op)
+			return RC_PAGE_CORRUPT;
+		// a match may overlap the bytes it produces, copying at most distance bytes at a time keeps every copy disjoint
+		for(matchLength += MATCH_MIN; matchLength > 0; ) {
+			int count = matchLength < distance ? matchLength : distance;
+			memcpy(page + op, page + op - distance, count);
+			op += count;
+			matchLength -= count;
+			distance += count;
+		}
+	}
+	return op == pageSize ? RC_OK : RC_PAGE_CORRUPT;
+}
+
+/* FUNCTION NAME : slotsOf
+   DESCRIPTION   : returns the number of slots a compressed block of length bytes takes */
+
+static int slotsOf (int length) {
+	return (length + SLOT_SIZE - 1) / SLOT_SIZE;
+}
+
+/* FUNCTION NAME : slotUsed
+   DESCRIPTION   : tells whether a slot of the compressed file is in use */
+
+static int slotUsed (PageMap *pageMap, int slot) {
+	return slot < pageMap->numSlots && (pageMap->usedSlots[slot / 8] & (1 << (slot % 8)));
+}
+
+/* FUNCTION NAME : markSlots
+   DESCRIPTION   : marks count slots from first on as used or free */
+
+static void markSlots (PageMap *pageMap, int first, int count, int used) {
+	int slot;
+	if(first + count > pageMap->numSlots) {
+		int numSlots = pageMap->numSlots > 0 ? pageMap->numSlots : 8 * MAP_BLOCK_SLOTS;
+		while(numSlots < first + count)
+			numSlots *= 2;
+		pageMap->usedSlots = (unsigned char *)realloc(pageMap->usedSlots, numSlots / 8);
+		memset(pageMap->usedSlots + pageMap->numSlots / 8, 0, (numSlots - pageMap->numSlots) / 8);
+		pageMap->numSlots = numSlots;
+	}
+	for(slot = first; slot < first + count; slot++)
+		if(used)
+			pageMap->usedSlots[slot / 8] |= 1 << (slot % 8);
+		else
+			pageMap->usedSlots[slot / 8] &= ~(1 << (slot % 8));
+	if(!used && first < pageMap->firstFree)
+		pageMap->firstFree = first;
+	while(slotUsed(pageMap, pageMap->firstFree))
+		pageMap->firstFree++;
+}
+
+/* FUNCTION NAME : allocateSlots
+   DESCRIPTION   : takes the first count free slots in a row and returns the first of them, the file grows if there are none */
+
+static int allocateSlots (PageMap *pageMap, int count) {
+	int slot, run = 0;
+	for(slot = pageMap->firstFree; run < count; slot++)
+		run = slotUsed(pageMap, slot) ? 0 : run + 1;
+	markSlots(pageMap, slot - count, count, 1);
+	return slot - count;
+}
+
+/* FUNCTION NAME : openPageMap
+   DESCRIPTION   : loads the page map of a compressed file and works out which slots are in use */
+
+static RC openPageMap (FileInfo *info, FileHeader *header) {
+	PageMap *pageMap = (PageMap *)calloc(1, sizeof(PageMap));
+	int i;
+	info->pageMap = pageMap;
+	pageMap->buffer = (char *)malloc(info->pageSize);
+	memcpy(pageMap->mapPages, header->mapPages, sizeof(pageMap->mapPages));
+	while(pageMap->numMapPages < MAP_PAGES && pageMap->mapPages[pageMap->numMapPages] != 0)
+		pageMap->numMapPages++;
+	pageMap->entries = (PageMapEntry *)malloc((size_t)(pageMap->numMapPages + 1) * PAGE_SIZE);
+	markSlots(pageMap, 0, FILE_HEADER_SIZE / SLOT_SIZE, 1);
+	for(i = 0; i < pageMap->numMapPages; i++) {
+		if(pread(info->fd, pageMap->entries + i * MAP_ENTRIES_PER_PAGE, PAGE_SIZE, (off_t)pageMap->mapPages[i] * SLOT_SIZE) < PAGE_SIZE)
+			return RC_FILE_NOT_FOUND;
+		markSlots(pageMap, pageMap->mapPages[i], MAP_BLOCK_SLOTS, 1);
+	}
+	for(i = 0; i < pageMap->numMapPages * MAP_ENTRIES_PER_PAGE; i++) {
+		if(pageMap->entries[i].length > (uint32_t)info->pageSize)
+			return RC_FILE_NOT_FOUND;
+		if(pageMap->entries[i].length > 0)
+			markSlots(pageMap, pageMap->entries[i].slot, slotsOf(pageMap->entries[i].length), 1);
+	}
+	return RC_OK;
+}
+
+/* FUNCTION NAME : closePageMap
+   DESCRIPTION   : releases the page map of a compressed file */
+
+static void closePageMap (FileInfo *info) {
+	if(info->pageMap == NULL)
+		return;
+	free(info->pageMap->buffer);
+	free(info->pageMap->entries);
+	free(info->pageMap->usedSlots);
+	free(info->pageMap);
+	info->pageMap = NULL;
+}
+
+/* FUNCTION NAME : allocateMapPages
+   DESCRIPTION   : adds the page map blocks a compressed file of numPages blocks needs, the caller stores them in the header */
+
+static RC allocateMapPages (FileInfo *info, int numPages) {
+	PageMap *pageMap = info->pageMap;
+	int needed = (numPages + MAP_ENTRIES_PER_PAGE - 1) / MAP_ENTRIES_PER_PAGE;
+	if(needed > MAP_PAGES)
+		return RC_WRITE_FAILED;
+	if(needed <= pageMap->numMapPages)
+		return RC_OK;
+	pageMap->entries = (PageMapEntry *)realloc(pageMap->entries, (size_t)needed * PAGE_SIZE);
+	while(pageMap->numMapPages < needed) {
+		PageMapEntry *entries = pageMap->entries + pageMap->numMapPages * MAP_ENTRIES_PER_PAGE;
+		int slot = allocateSlots(pageMap, MAP_BLOCK_SLOTS);
+		memset(entries, 0, PAGE_SIZE);
+		if(pwrite(info->fd, entries, PAGE_SIZE, (off_t)slot * SLOT_SIZE) < PAGE_SIZE) {
+			markSlots(pageMap, slot, MAP_BLOCK_SLOTS, 0);
+			return RC_WRITE_FAILED;
+		}
+		pageMap->mapPages[pageMap->numMapPages++] = slot;
+	}
+	return RC_OK;
+}
+
+/* FUNCTION NAME : writeMapSlot
+   DESCRIPTION   : writes the slot of the page map holding the entry of block pageNum back to the file */
+
+static RC writeMapSlot (FileInfo *info, int pageNum) {
+	PageMap *pageMap = info->pageMap;
+	int first = pageNum / MAP_ENTRIES_PER_SLOT * MAP_ENTRIES_PER_SLOT;
+	off_t offset = ((off_t)pageMap->mapPages[pageNum / MAP_ENTRIES_PER_PAGE] + pageNum % MAP_ENTRIES_PER_PAGE / MAP_ENTRIES_PER_SLOT)
+	               * SLOT_SIZE;
+	if(pwrite(info->fd, pageMap->entries + first, SLOT_SIZE, offset) < SLOT_SIZE)
+		return RC_WRITE_FAILED;
+	return RC_OK;
+}
+
+/* FUNCTION NAME : readCompressedBlocks
+   DESCRIPTION   : reads numPages consecutive blocks of a compressed file from pageNum on into memPages. Blocks stored right
+                   behind each other are fetched with one read. Fails with RC_READ_FAILED or RC_PAGE_CORRUPT */
+
+static RC readCompressedBlocks (FileInfo *info, int pageNum, int numPages, SM_PageHandle *memPages) {
+	PageMap *pageMap = info->pageMap;
+	PageMapEntry *entries = pageMap->entries + pageNum;
+	char *buffer = NULL;
+	RC result = RC_OK;
+	int first, last, i;
+	for(first = 0; first < numPages && result == RC_OK; first = last) {
+		last = first + 1;
+		if(entries[first].length == 0) {
+			memset(memPages[first], 0, info->pageSize);
+			continue;
+		}
+		off_t start = (off_t)entries[first].slot * SLOT_SIZE, end = start + entries[first].length;
+		while(last < numPages && last - first < COMPRESSED_READ_PAGES && entries[last].length > 0
+		      && entries[last].slot == entries[last - 1].slot + slotsOf(entries[last - 1].length)) {
+			end = (off_t)entries[last].slot * SLOT_SIZE + entries[last].length;
+			last++;
+		}
+		char *data = pageMap->buffer;
+		if(end - start > info->pageSize) {
+			if(buffer == NULL)
+				buffer = (char *)malloc((size_t)COMPRESSED_READ_PAGES * info->pageSize);
+			data = buffer;
+		}
+		if(pread(info->fd, data, end - start, start) < end - start)
+			result = RC_READ_FAILED;
+		for(i = first; i < last && result == RC_OK; i++)
+			result = decompressPage(data + ((off_t)entries[i].slot * SLOT_SIZE - start), entries[i].length, memPages[i],
+			                        info->pageSize);
+	}
+	free(buffer);
+	return result;
+}
+
+/* FUNCTION NAME : placeCompressedBlock
+   DESCRIPTION   : compresses a block and writes it where it fits, its old slots if they are enough and new ones otherwise.
+                   Only the entry in memory is updated. Slots the block no longer needs are added to freed, where length
+                   counts slots, for the caller to release once the page map on disk no longer points at them */
+
+static RC placeCompressedBlock (FileInfo *info, int pageNum, SM_PageHandle memPage, PageMapEntry *freed, int *numFreed) {
+	PageMap *pageMap = info->pageMap;
+	PageMapEntry *entry = pageMap->entries + pageNum;
+	char *data = memPage;
+	int length;
+	if(memPage[0] == 0 && memcmp(memPage, memPage + 1, info->pageSize - 1) == 0)
+		length = 0;
+	else if((length = compressPage(memPage, info->pageSize, pageMap->buffer)) > 0)
+		data = pageMap->buffer;
+	else
+		length = info->pageSize;
+	int slots = slotsOf(length), oldSlots = slotsOf(entry->length), slot = entry->slot;
+	if(slots > oldSlots) {
+		if(oldSlots > 0) {
+			freed[*numFreed].slot = entry->slot;
+			freed[(*numFreed)++].length = oldSlots;
+		}
+		slot = allocateSlots(pageMap, slots);
+	} else if(slots < oldSlots) {
+		freed[*numFreed].slot = entry->slot + slots;
+		freed[(*numFreed)++].length = oldSlots - slots;
+	}
+	if(length > 0 && pwrite(info->fd, data, length, (off_t)slot * SLOT_SIZE) < length) {
+		if(slots > oldSlots) {
+			markSlots(pageMap, slot, slots, 0);
+			if(oldSlots > 0)
+				(*numFreed)--;
+		} else if(slots < oldSlots)
+			(*numFreed)--;
+		return RC_WRITE_FAILED;
+	}
+	entry->slot = length > 0 ? slot : 0;
+	entry->length = length;
+	return RC_OK;
+}
+
+/* FUNCTION NAME : commitMapSlot
+   DESCRIPTION   : writes the page map slot holding the entry of block pageNum, then releases the slots the blocks it points
+                   at no longer need */
+
+static RC commitMapSlot (FileInfo *info, int pageNum, PageMapEntry *freed, int *numFreed) {
+	RC result = writeMapSlot(info, pageNum);
+	int i;
+	if(result == RC_OK)
+		for(i = 0; i < *numFreed; i++)
+			markSlots(info->pageMap, freed[i].slot, freed[i].length, 0);
+	*numFreed = 0;
+	return result;
+}
+
+/* FUNCTION NAME : writeCompressedBlocks
+   DESCRIPTION   : writes memPages[i] to block pageNums[i] of a compressed file for the numPages given blocks, the page map has
+                   to cover them already. The data goes to disk before the page map slot pointing at it, which is written
+                   once for every run of blocks whose entries share it */
+
+static RC writeCompressedBlocks (FileInfo *info, int *pageNums, int numPages, SM_PageHandle *memPages) {
+	PageMapEntry *freed = (PageMapEntry *)malloc(sizeof(PageMapEntry) * numPages);
+	int i, numFreed = 0, pending = -1;
+	RC result = RC_OK;
+	for(i = 0; i < numPages && result == RC_OK; i++) {
+		if(pending >= 0 && pageNums[i] / MAP_ENTRIES_PER_SLOT != pending / MAP_ENTRIES_PER_SLOT) {
+			result = commitMapSlot(info, pending, freed, &numFreed);
+			pending = -1;
+		}
+		if(result == RC_OK && (result = placeCompressedBlock(info, pageNums[i], memPages[i], freed, &numFreed)) == RC_OK)
+			pending = pageNums[i];
+	}
+	if(pending >= 0) {
+		RC committed = commitMapSlot(info, pending, freed, &numFreed);
+		if(result == RC_OK)
+			result = committed;
+	}
+	free(freed);
+	return result;
+}
+
+/* FUNCTION NAME : transferBlocks
+   DESCRIPTION   : reads or writes numPages consecutive blocks from pageNum on with as few vectored positioned calls as possible */
+
+static RC transferBlocks (int fd, int pageSize, int pageNum, int numPages, SM_PageHandle *memPages, int write) {
+	RC failure = write ? RC_WRITE_FAILED : RC_READ_FAILED;
+	struct iovec *iov = (struct iovec *)malloc(sizeof(struct iovec) * numPages);
+	int i, first = 0;
+	off_t offset = BLOCK_OFFSET(pageSize, pageNum);
+	for(i = 0; i < numPages; i++) {
+		iov[i].iov_base = memPages[i];
+		iov[i].iov_len = pageSize;
+	}
+	while(first < numPages) {
+		int count = numPages - first > IOV_MAX ? IOV_MAX : numPages - first;
+		ssize_t length = write ? pwritev(fd, iov + first, count, offset) : preadv(fd, iov + first, count, offset);
+		if(length <= 0) {
+			free(iov);
+			return failure;
+		}
+		offset += length;
+		// Skip the buffers transferred completely and trim the one a short transfer stopped in
+		while(length > 0) {
+			if((size_t)length >= iov[first].iov_len) {
+				length -= iov[first].iov_len;
+				first++;
+			} else {
+				iov[first].iov_base = (char *)iov[first].iov_base + length;
+				iov[first].iov_len -= length;
+				length = 0;
+			}
+		}
+	}
+	free(iov);
+	return RC_OK;
+}
+
+/* FUNCTION NAME : readHeader
+   DESCRIPTION   : reads the header of the file, the whole header page is read so it works on direct files too */
+
+static RC readHeader (int fd, FileHeader *header) {
+	void *buffer;
+	RC result = RC_OK;
+	if(posix_memalign(&buffer, DIRECT_IO_ALIGNMENT, FILE_HEADER_SIZE) != 0)
+		return RC_FILE_NOT_FOUND;
+	if(pread(fd, buffer, FILE_HEADER_SIZE, 0) < FILE_HEADER_SIZE)
+		result = RC_FILE_NOT_FOUND;
+	memcpy(header, buffer, sizeof(FileHeader));
+	if(result == RC_OK && memcmp(header->magic, PAGE_FILE_MAGIC, sizeof(header->magic)) != 0)
+		result = RC_FILE_NOT_FOUND;
+	free(buffer);
+	return result;
+}
+
+/* FUNCTION NAME : writeHeader
+   DESCRIPTION   : stores the page count, flags, page size and, for a compressed file, the page map blocks in the header of the file,
+                   as a whole aligned page like readHeader */
+
+static RC writeHeader (int fd, int totalNumPages, int flags, int pageSize, const int *mapPages) {
+	FileHeader *header;
+	RC result = RC_OK;
+	if(posix_memalign((void **)&header, DIRECT_IO_ALIGNMENT, FILE_HEADER_SIZE) != 0)
+		return RC_WRITE_FAILED;
+	memset(header, 0, FILE_HEADER_SIZE);
+	memcpy(header->magic, PAGE_FILE_MAGIC, sizeof(header->magic));
+	header->totalNumPages = totalNumPages;
+	header->flags = flags;
+	header->pageSize = pageSize;
+	if(mapPages != NULL)
+		memcpy(header->mapPages, mapPages, sizeof(header->mapPages));
+	if(pwrite(fd, header, FILE_HEADER_SIZE, 0) < FILE_HEADER_SIZE)
+		result = RC_WRITE_FAILED;
+	free(header);
+	return result;
+}
+
+/* FUNCTION NAME : directBuffer
+   DESCRIPTION   : returns the buffer a block transfer for memPage goes through, memPage itself unless the file is direct and
+                   memPage is not aligned. The caller copies between memPage and the bounce page then */
+
+static SM_PageHandle directBuffer (FileInfo *info, SM_PageHandle memPage) {
+	if(!info->direct || IS_ALIGNED(memPage))
+		return memPage;
+	if(info->bounce == NULL && posix_memalign((void **)&info->bounce, DIRECT_IO_ALIGNMENT, info->pageSize) != 0)
+		info->bounce = NULL;
+	return info->bounce;
+}
+
+/* FUNCTION NAME : alignedPages
+   DESCRIPTION   : tells whether all numPages buffers can take part in a vectored transfer on the file */
+
+static int alignedPages (FileInfo *info, SM_PageHandle *memPages, int numPages) {
+	int i;
+	if(!info->direct)
+		return 1;
+	for(i = 0; i < numPages; i++)
+		if(!IS_ALIGNED(memPages[i]))
+			return 0;
+	return 1;
+}
+
+/* FUNCTION NAME : allocateBlocks
+   DESCRIPTION   : makes sure the file has space for numPages blocks. Space is added in extents growing with the file,
+                   so a file growing page by page is only extended now and then and no block is ever zero filled by hand */
+
+static RC allocateBlocks (FileInfo *info, int numPages) {
+	if(numPages <= info->allocatedPages)
+		return RC_OK;
+	int extent = info->allocatedPages < EXTENT_MIN_PAGES ? EXTENT_MIN_PAGES : info->allocatedPages;
+	if(extent > EXTENT_MAX_PAGES)
+		extent = EXTENT_MAX_PAGES;
+	int allocated = info->allocatedPages + extent < numPages ? numPages : info->allocatedPages + extent;
+	off_t length = BLOCK_OFFSET(info->pageSize, allocated);
+	int reserved = 0;
+#ifdef __linux__
+	reserved = (fallocate(info->fd, 0, 0, length) == 0);
+#endif
+	if(!reserved) {
+		// without fallocate the file is extended sparsely, asynchronous writes may have made it longer already
+		struct stat fileInfo;
+		if(fstat(info->fd, &fileInfo) < 0)
+			return RC_WRITE_FAILED;
+		if(fileInfo.st_size < length && ftruncate(info->fd, length) != 0)
+			return RC_WRITE_FAILED;
+	}
+	info->allocatedPages = allocated;
+	return RC_OK;
+}
+
+/* FUNCTION NAME : storePageCount
+   DESCRIPTION   : writes the header if the page count in it is behind the one of the file handle */
+
+static RC storePageCount (SM_FileHandle *fHandle) {
+	FileInfo *info = (FileInfo *)fHandle->mgmtInfo;
+	RC result;
+	if(info->headerPages == fHandle->totalNumPages)
+		return RC_OK;
+	if((result = writeHeader(info->fd, fHandle->totalNumPages, info->flags, info->pageSize,
+	                         info->pageMap != NULL ? info->pageMap->mapPages : NULL)) != RC_OK)
+		return result;
+	info->headerPages = fHandle->totalNumPages;
+	return RC_OK;
+}
+
+/* FUNCTION NAME : growFile
+   DESCRIPTION   : grows the file to numPages blocks, the new ones read as zeros. The header is only written when the file
+                   needs more space or page map blocks, growing within the space it has leaves the new page count
+                   to closePageFile, so appending page by page does not write the header each time */
+
+static RC growFile (SM_FileHandle *fHandle, int numPages) {
+	FileInfo *info = (FileInfo *)fHandle->mgmtInfo;
+	int allocated = info->allocatedPages, mapPages = info->pageMap != NULL ? info->pageMap->numMapPages : 0;
+	RC result;
+	if(numPages <= fHandle->totalNumPages)
+		return RC_OK;
+	result = info->pageMap != NULL ? allocateMapPages(info, numPages) : allocateBlocks(info, numPages);
+	if(result != RC_OK)
+		return result;
+	fHandle->totalNumPages = numPages;
+	if(info->allocatedPages != allocated || (info->pageMap != NULL && info->pageMap->numMapPages != mapPages))
+		return storePageCount(fHandle);
+	return RC_OK;
+}
 
 /*  FUNCTION NAME : initStorageManager
     DESCRIPTION   : Initialize the storage manager */
 
 extern void initStorageManager (void) {
-	pageFile = NULL;
 }
 
-/* FUNCTION NAME : createPageFile
-   DESCRIPTION   : Creates a new page file in append mode and write to it */
+/* FUNCTION NAME : createFile
+   DESCRIPTION   : Creates a new page file with the given header flags and page size, its header followed by one empty page */
 
-extern RC createPageFile (char *fileName) {
+static RC createFile (char *fileName, int flags, int pageSize) {
 
-	pageFile = fopen(fileName, "w+");
-	if(pageFile == NULL) {
+	int fd = open(fileName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0) {
 		return RC_FILE_NOT_FOUND;
 	} else {
-		
-		SM_PageHandle newPage = (SM_PageHandle)calloc(PAGE_SIZE, sizeof(char));
-		if(fwrite(newPage, sizeof(char), PAGE_SIZE,pageFile) < PAGE_SIZE)
+
+		SM_PageHandle newPage = (SM_PageHandle)calloc(pageSize, sizeof(char));
+		int mapPages[MAP_PAGES] = {0};
+		// the empty page of a compressed file takes no space, the zeros in its place serve as a page map block saying so
+		mapPages[0] = BLOCK_OFFSET(pageSize, 0) / SLOT_SIZE;
+		if(writeHeader(fd, 1, flags, pageSize, (flags & FILE_COMPRESSED) ? mapPages : NULL) != RC_OK
+		   || pwrite(fd, newPage, pageSize, BLOCK_OFFSET(pageSize, 0)) < pageSize)
 			printf("write failed \n");
 		else
 			printf("write succeeded \n");
-		fclose(pageFile);
+		close(fd);
 		free(newPage);
 		return RC_OK;
 	}
 }
 
-/* FUNCTION NAME : openPageFile
-   DESCRIPTION   : Opens the created file in read mode to store informantion */ 
+/* FUNCTION NAME : createPageFile
+   DESCRIPTION   : Creates a new page file holding one empty page */
 
-extern RC openPageFile (char *fileName, SM_FileHandle *fHandle) {
-	
-	pageFile = fopen(fileName, "r");
-	if(pageFile == NULL) {
+extern RC createPageFile (char *fileName) {
+	return createFile(fileName, 0, PAGE_SIZE);
+}
+
+/* FUNCTION NAME : createChecksummedPageFile
+   DESCRIPTION   : Creates a new page file like createPageFile whose pages carry a checksum. The last PAGE_TRAILER_SIZE bytes
+                   of every page belong to the storage manager: writes fill them with a CRC32C of the rest of the page and
+                   reads fail with RC_PAGE_CHECKSUM_FAILED if it does not match, so torn and corrupted pages are noticed */
+
+extern RC createChecksummedPageFile (char *fileName) {
+	return createFile(fileName, FILE_CHECKSUMS, PAGE_SIZE);
+}
+
+/* FUNCTION NAME : createCompressedPageFile
+   DESCRIPTION   : Creates a new page file like createPageFile whose pages are stored compressed. Callers still read and write
+                   whole pages, the file keeps a page map telling where the compressed form of each one is and
+                   pages holding zeros only take no space at all. Such a file cannot be mapped or opened with O_DIRECT */
+
+extern RC createCompressedPageFile (char *fileName) {
+	return createFile(fileName, FILE_COMPRESSED, PAGE_SIZE);
+}
+
+/* FUNCTION NAME : validPageSize
+   DESCRIPTION   : tells whether a page file may have pages of pageSize bytes, a power of two from MIN_PAGE_SIZE to MAX_PAGE_SIZE */
+
+static int validPageSize (int pageSize) {
+	return pageSize >= MIN_PAGE_SIZE && pageSize <= MAX_PAGE_SIZE && (pageSize & (pageSize - 1)) == 0;
+}
+
+/* FUNCTION NAME : createPageFileWithOptions
+   DESCRIPTION   : Creates a new page file with pages of pageSize bytes, which it keeps in its header for every later open.
+                   options combines SM_PAGE_CHECKSUMS and SM_PAGE_COMPRESSION, see createChecksummedPageFile and
+                   createCompressedPageFile. Page sizes other than a power of two from MIN_PAGE_SIZE to MAX_PAGE_SIZE fail */
+
+extern RC createPageFileWithOptions (char *fileName, int pageSize, int options) {
+	if(!validPageSize(pageSize) || (options & ~(SM_PAGE_CHECKSUMS | SM_PAGE_COMPRESSION)) != 0)
+		return RC_WRITE_FAILED;
+	return createFile(fileName, options, pageSize);
+}
+
+/* FUNCTION NAME : openFile
+   DESCRIPTION   : Opens the page file with the given extra flags and keeps its descriptor in the file handle until closePageFile.
+                   The page count and size come from the header, files without one are not opened */
+
+static RC openFile (char *fileName, SM_FileHandle *fHandle, int flags) {
+
+	int fd = open(fileName, O_RDWR | flags);
+	if(fd < 0) {
 		return RC_FILE_NOT_FOUND;
-	} else { 
+	} else {
+		struct stat fileInfo;
+		FileHeader header;
+		if(fstat(fd, &fileInfo) < 0 || readHeader(fd, &header) != RC_OK) {
+			close(fd);
+			return RC_FILE_NOT_FOUND;
+		}
+		if(header.pageSize == 0)
+			header.pageSize = PAGE_SIZE;
+		if(!validPageSize(header.pageSize)) {
+			close(fd);
+			return RC_FILE_NOT_FOUND;
+		}
+		FileInfo *info = (FileInfo *)malloc(sizeof(FileInfo));
+		info->fd = fd;
+		info->queue = NULL;
+		info->map = NULL;
+		info->mapReserved = info->mapLength = 0;
+		info->allocatedPages = (fileInfo.st_size - FILE_HEADER_SIZE) / header.pageSize;
+		info->headerPages = header.totalNumPages;
+		info->flags = header.flags;
+		info->pageSize = header.pageSize;
+		info->direct = (flags & O_DIRECT) != 0;
+		info->bounce = NULL;
+		info->pageMap = NULL;
+		// compressed blocks vary in size, which O_DIRECT transfers cannot
+		if((header.flags & FILE_COMPRESSED) && ((flags & O_DIRECT) || openPageMap(info, &header) != RC_OK)) {
+			closePageMap(info);
+			free(info);
+			close(fd);
+			return RC_FILE_NOT_FOUND;
+		}
 		fHandle->fileName = fileName;
 		fHandle->curPagePos = 0;
-		struct stat fileInfo;
-		if(fstat(fileno(pageFile), &fileInfo) < 0)    
-			return RC_ERROR;
-		fHandle->totalNumPages = fileInfo.st_size/ PAGE_SIZE;
-		fclose(pageFile);
+		fHandle->totalNumPages = header.totalNumPages;
+		fHandle->pageSize = header.pageSize;
+		fHandle->mgmtInfo = info;
 		return RC_OK;
 	}
 }
 
+/* FUNCTION NAME : openPageFile
+   DESCRIPTION   : Opens the page file and keeps its descriptor in the file handle until closePageFile */
+
+extern RC openPageFile (char *fileName, SM_FileHandle *fHandle) {
+	return openFile(fileName, fHandle, 0);
+}
+
+/* FUNCTION NAME : openPageFileDirect
+   DESCRIPTION   : Opens the page file like openPageFile, but its blocks move between the caller's buffers and the disk
+                   without passing through the OS page cache. Buffers aligned to DIRECT_IO_ALIGNMENT are transferred as they are,
+                   readBlock and writeBlock copy other ones through an aligned page, readBlocks and writeBlocks then fall back
+                   to one block at a time and submitBlocks refuses them. Fails where the file system does not support O_DIRECT */
+
+extern RC openPageFileDirect (char *fileName, SM_FileHandle *fHandle) {
+	return openFile(fileName, fHandle, O_DIRECT);
+}
+
 /* FUNCTION NAME : closePageFile
-   DESCRIPTION   : closes the opened file */
+   DESCRIPTION   : closes the opened file after storing its page count in the header. The file is closed even if that fails,
+                   the error is returned then */
 
 extern RC closePageFile (SM_FileHandle *fHandle) {
-	if(pageFile != NULL)
-		pageFile = NULL;	
-	return RC_OK; 
+	FileInfo *info = (FileInfo *)fHandle->mgmtInfo;
+	RC result;
+	if(info == NULL)
+		return RC_FILE_HANDLE_NOT_INIT;
+	if(info->queue != NULL)
+		closeQueue(info->queue);
+	result = storePageCount(fHandle);
+	if(info->map != NULL)
+		munmap(info->map, info->mapReserved);
+	closePageMap(info);
+	close(info->fd);
+	free(info->bounce);
+	free(info);
+	fHandle->mgmtInfo = NULL;
+	return result;
 }
 
-/* FUNCTION NAME : destroyPageFile 
+/* FUNCTION NAME : destroyPageFile
    DESCRIPTION   : Deletes the page file  */
 
-extern RC destroyPageFile (char *fileName) {	
-	pageFile = fopen(fileName, "r");
-	
-	if(pageFile == NULL)
-		return RC_FILE_NOT_FOUND; 
-	remove(fileName);
+extern RC destroyPageFile (char *fileName) {
+	if(remove(fileName) != 0)
+		return RC_FILE_NOT_FOUND;
 	return RC_OK;
 }
 
 /* FUNCTION NAME : readBlock
-   DESCRIPTION   : this function will read the pageNum-th block of data */
+   DESCRIPTION   : this function will read the pageNum-th block of data with one positioned read.
+                   Only pages past the end of the file are RC_READ_NON_EXISTING_PAGE, a read that fails within it returns
+                   RC_READ_FAILED and a compressed block that does not decompress RC_PAGE_CORRUPT */
 
 extern RC readBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
-	if (pageNum > fHandle->totalNumPages || pageNum < 0)
+	FileInfo *info = (FileInfo *)fHandle->mgmtInfo;
+	if(info == NULL)
+		return RC_FILE_HANDLE_NOT_INIT;
+	if (pageNum >= fHandle->totalNumPages || pageNum < 0)
         	return RC_READ_NON_EXISTING_PAGE;
-	pageFile = fopen(fHandle->fileName, "r");
-	if(pageFile == NULL)
-		return RC_FILE_NOT_FOUND;
-	int read = fseek(pageFile, (pageNum * PAGE_SIZE), SEEK_SET);
-	if(read == 0) {
-		if(fread(memPage, sizeof(char), PAGE_SIZE, pageFile) < PAGE_SIZE)
-			return RC_ERROR;
+	if(info->pageMap != NULL) {
+		RC result = readCompressedBlocks(info, pageNum, 1, &memPage);
+		if(result != RC_OK)
+			return result;
 	} else {
-		return RC_READ_NON_EXISTING_PAGE; 
+		SM_PageHandle buffer = directBuffer(info, memPage);
+		if(buffer == NULL || pread(info->fd, buffer, info->pageSize, BLOCK_OFFSET(info->pageSize, pageNum)) < info->pageSize)
+			return RC_READ_FAILED;
+		if(buffer != memPage)
+			memcpy(memPage, buffer, info->pageSize);
 	}
-	fHandle->curPagePos = ftell(pageFile); 	
-	fclose(pageFile);
+	if(checkPage(info, memPage) != RC_OK)
+		return RC_PAGE_CHECKSUM_FAILED;
+	fHandle->curPagePos = pageNum;
 	return RC_OK;
 }
 
@@ -110,87 +1073,145 @@ extern int getBlockPos (SM_FileHandle *fHandle) {
 /* FUNCTION NAME : readFirstBlock
    DESCRIPTION   : reads the first block of data from page file */
 
-extern RC readFirstBlock (SM_FileHandle *fHandle, SM_PageHandle memPage) {	
-	pageFile = fopen(fHandle->fileName, "r");
-	if(pageFile == NULL)
-		return RC_FILE_NOT_FOUND;
-	
-	readBlock(0,fHandle,memPage);
-    fclose(pageFile);
-    return RC_OK;  
+extern RC readFirstBlock (SM_FileHandle *fHandle, SM_PageHandle memPage) {
+	return readBlock(0, fHandle, memPage);
 }
 
 /* FUNCTION NAME : readPreviousBlock
    DESCRIPTION   : reads the page from previous block */
 
 extern RC readPreviousBlock (SM_FileHandle *fHandle, SM_PageHandle memPage) {
-	 pageFile = fopen(fHandle->fileName,"r");
-    if(pageFile == NULL)
-        return RC_FILE_NOT_FOUND;
-    int position = getBlockPos(fHandle);
-    readBlock((position-1),fHandle,memPage);
-    fclose(pageFile);
-    return  RC_OK; 
+	return readBlock(getBlockPos(fHandle) - 1, fHandle, memPage);
 }
 
 /* FUNCTION NAME : readCurrentBlock
    DESCRIPTION   : reads the page from current block */
 
 extern RC readCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage) {
-	int currPosition = getBlockPos(fHandle);
-    readBlock(currPosition, fHandle,memPage);
-    return RC_OK; 		
+	return readBlock(getBlockPos(fHandle), fHandle, memPage);
 }
 
 /* FUNCTION NAME : readNextBlock
    DESCRIPTION   : reads the page from next block */
 
 extern RC readNextBlock (SM_FileHandle *fHandle, SM_PageHandle memPage){
-	 pageFile = fopen(fHandle->fileName,"r");
-    if(pageFile == NULL)
-        return RC_FILE_NOT_FOUND;
-    int position = getBlockPos(fHandle);
-    readBlock((position+1),fHandle,memPage);
-    fclose(pageFile);
-    return RC_OK; 
+	return readBlock(getBlockPos(fHandle) + 1, fHandle, memPage);
 }
 
 /* FUNCTION NAME : readLastBlock
    DESCRIPTION   :  read the page from last block */
 
 extern RC readLastBlock (SM_FileHandle *fHandle, SM_PageHandle memPage){
-	int lastPosition = fHandle->totalNumPages;
-    if (fHandle->mgmtInfo ==  NULL)
-        return RC_FILE_NOT_FOUND;
-    readBlock(lastPosition, fHandle,memPage);
-    return RC_OK;
+	return readBlock(fHandle->totalNumPages - 1, fHandle, memPage);
+}
+
+/* FUNCTION NAME : readBlocks
+   DESCRIPTION   : reads numPages consecutive blocks starting at pageNum into memPages[0..numPages-1]
+                   with as few vectored positioned reads as possible */
+
+extern RC readBlocks (int pageNum, int numPages, SM_FileHandle *fHandle, SM_PageHandle *memPages) {
+	FileInfo *info = (FileInfo *)fHandle->mgmtInfo;
+	if(info == NULL)
+		return RC_FILE_HANDLE_NOT_INIT;
+	if (pageNum < 0 || numPages < 1 || pageNum + numPages > fHandle->totalNumPages)
+        	return RC_READ_NON_EXISTING_PAGE;
+
+	RC result = RC_OK;
+	int i;
+	if(info->pageMap != NULL || alignedPages(info, memPages, numPages)) {
+		if(info->pageMap != NULL)
+			result = readCompressedBlocks(info, pageNum, numPages, memPages);
+		else
+			result = transferBlocks(info->fd, info->pageSize, pageNum, numPages, memPages, 0);
+		if(result == RC_OK)
+			result = checkPages(info, memPages, numPages);
+	} else
+		for(i = 0; i < numPages && result == RC_OK; i++)
+			result = readBlock(pageNum + i, fHandle, memPages[i]);
+	if(result != RC_OK)
+		return result;
+	fHandle->curPagePos = pageNum + numPages - 1;
+	return RC_OK;
 }
 
-/* FUNCTION NAME : writeBlock 
-   DESCRIPTION   : Writes the pageNum-th block of data */
+/* FUNCTION NAME : writeBlock
+   DESCRIPTION   : Writes the whole pageNum-th block of data, zero bytes included, with one positioned write.
+                   Writing right behind the last block appends it */
 
 extern RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
+	FileInfo *info = (FileInfo *)fHandle->mgmtInfo;
+	if(info == NULL)
+		return RC_FILE_HANDLE_NOT_INIT;
 	if (pageNum > fHandle->totalNumPages || pageNum < 0)
         	return RC_WRITE_FAILED;
-	pageFile = fopen(fHandle->fileName, "r+");
-	if(pageFile == NULL)
-		return RC_FILE_NOT_FOUND;
-	int startPosition = pageNum * PAGE_SIZE;
-	if(pageNum == 0) { 
-		fseek(pageFile, startPosition, SEEK_SET);	
-		int i;
-		for(i = 0; i < PAGE_SIZE; i++) 
-		{
-			if(feof(pageFile)) 
-				 appendEmptyBlock(fHandle);
-			fputc(memPage[i], pageFile);
+	RC result;
+	if(info->pageMap != NULL) {
+		// the page map has to cover the block before it can be stored
+		sealPage(info, memPage);
+		if((result = growFile(fHandle, pageNum + 1)) != RC_OK || (result = writeCompressedBlocks(info, &pageNum, 1, &memPage)) != RC_OK)
+			return result;
+		fHandle->curPagePos = pageNum;
+		return RC_OK;
+	}
+	if((result = allocateBlocks(info, pageNum + 1)) != RC_OK)
+		return result;
+	SM_PageHandle buffer = directBuffer(info, memPage);
+	if(buffer == NULL)
+		return RC_WRITE_FAILED;
+	sealPage(info, memPage);
+	if(buffer != memPage)
+		memcpy(buffer, memPage, info->pageSize);
+	if(pwrite(info->fd, buffer, info->pageSize, BLOCK_OFFSET(info->pageSize, pageNum)) < info->pageSize)
+		return RC_WRITE_FAILED;
+	fHandle->curPagePos = pageNum;
+	return growFile(fHandle, pageNum + 1);
+}
+
+/* FUNCTION NAME : writeBlocks
+   DESCRIPTION   : writes memPages[i] to block pageNums[i] for the numPages given blocks. Entries whose blocks follow each other
+                   are gathered into one vectored positioned write, so callers passing the blocks in order issue the fewest calls.
+                   Like writeBlock a block may lie at most right behind the end of the file as it grows with the earlier writes. */
+
+extern RC writeBlocks (int *pageNums, int numPages, SM_FileHandle *fHandle, SM_PageHandle *memPages) {
+	FileInfo *info = (FileInfo *)fHandle->mgmtInfo;
+	int i, first, last;
+	if(info == NULL)
+		return RC_FILE_HANDLE_NOT_INIT;
+	if(info->pageMap != NULL) {
+		for(i = 0; i < numPages; i++) {
+			if(pageNums[i] < 0 || pageNums[i] > fHandle->totalNumPages)
+				return RC_WRITE_FAILED;
+			sealPage(info, memPages[i]);
+			RC result = growFile(fHandle, pageNums[i] + 1);
+			if(result != RC_OK)
+				return result;
 		}
-		fHandle->curPagePos = ftell(pageFile); 
-		fclose(pageFile);	
-	} else {	
-		fHandle->curPagePos = startPosition;
-		fclose(pageFile);
-		writeCurrentBlock(fHandle, memPage);
+		RC result = writeCompressedBlocks(info, pageNums, numPages, memPages);
+		if(result == RC_OK && numPages > 0)
+			fHandle->curPagePos = pageNums[numPages - 1];
+		return result;
+	}
+	if(!alignedPages(info, memPages, numPages)) {
+		RC result = RC_OK;
+		for(first = 0; first < numPages && result == RC_OK; first++)
+			result = writeBlock(pageNums[first], fHandle, memPages[first]);
+		return result;
+	}
+	for(first = 0; first < numPages; first = last) {
+		for(last = first + 1; last < numPages && pageNums[last] == pageNums[last - 1] + 1; last++)
+			;
+		if(pageNums[first] < 0 || pageNums[first] > fHandle->totalNumPages)
+			return RC_WRITE_FAILED;
+		for(i = first; i < last; i++)
+			sealPage(info, memPages[i]);
+		RC result = allocateBlocks(info, pageNums[last - 1] + 1);
+		if(result == RC_OK)
+			result = transferBlocks(info->fd, info->pageSize, pageNums[first], last - first, memPages + first, 1);
+		if(result == RC_OK)
+			result = growFile(fHandle, pageNums[last - 1] + 1);
+		if(result != RC_OK)
+			return result;
+		fHandle->curPagePos = pageNums[last - 1];
 	}
 	return RC_OK;
 }
@@ -200,43 +1221,453 @@ extern RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage
 
 
 extern RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage) {
-	pageFile = fopen(fHandle->fileName, "r+");
-	if(pageFile == NULL)
-		return RC_FILE_NOT_FOUND;
-	appendEmptyBlock(fHandle);
-	fseek(pageFile, fHandle->curPagePos, SEEK_SET);
-	fwrite(memPage, sizeof(char), strlen(memPage), pageFile);
-	fHandle->curPagePos = ftell(pageFile);   	
-	fclose(pageFile);
-	return RC_OK;
+	return writeBlock(fHandle->curPagePos, fHandle, memPage);
 }
 
 /* FUNCTION NAME : appendEmptyBlock
-   DESCRIPTION   : write an empty page to the file by appending at the end */
+   DESCRIPTION   : adds an empty page at the end of the file, it only touches the disk when the allocated space runs out */
 
 extern RC appendEmptyBlock (SM_FileHandle *fHandle) {
-	SM_PageHandle emptyBlock = (SM_PageHandle)calloc(PAGE_SIZE, sizeof(char));
-	int isSeekSuccess = fseek(pageFile, 0, SEEK_END);
-	if( isSeekSuccess == 0 ) {
-		fwrite(emptyBlock, sizeof(char), PAGE_SIZE, pageFile);
-	} else {
-		free(emptyBlock);
-		return RC_WRITE_FAILED;
-	}
-	free(emptyBlock);
-	fHandle->totalNumPages++;
-	return RC_OK;
+	FileInfo *info = (FileInfo *)fHandle->mgmtInfo;
+	if(info == NULL)
+		return RC_FILE_HANDLE_NOT_INIT;
+	return growFile(fHandle, fHandle->totalNumPages + 1);
 }
 
 /* FUNCTION NAME : ensureCapacity
-   DESCRIPTION   : if the file has less number of pages than totalNumPages then increase the size */
+   DESCRIPTION   : if the file has less number of pages than numberOfPages then increase the size in one step */
 
 extern RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle) {
-	pageFile = fopen(fHandle->fileName, "a");
-	if(pageFile == NULL)
-		return RC_FILE_NOT_FOUND;
-	while(numberOfPages > fHandle->totalNumPages)
-		appendEmptyBlock(fHandle);
-	fclose(pageFile);
+	if(fHandle->mgmtInfo == NULL)
+		return RC_FILE_HANDLE_NOT_INIT;
+	return growFile(fHandle, numberOfPages);
+}
+
+/* FUNCTION NAME : finishRequest
+   DESCRIPTION   : records the outcome of a request and moves it to the completed requests, the caller holds queue->lock */
+
+static void finishRequest (IOQueue *queue, SM_IORequest *request, RC result) {
+	request->result = result;
+	free(request->iov);
+	request->iov = NULL;
+	request->next = NULL;
+	if(queue->doneTail == NULL)
+		queue->doneHead = request;
+	else
+		queue->doneTail->next = request;
+	queue->doneTail = request;
+	queue->numDone++;
+	queue->inFlight--;
+}
+
+/* FUNCTION NAME : ioThread
+   DESCRIPTION   : serves queued requests one after the other until the queue is closed */
+
+static void *ioThread (void *arg) {
+	IOQueue *queue = (IOQueue *)arg;
+	pthread_mutex_lock(&queue->lock);
+	while(1) {
+		while(queue->queueHead == NULL && !queue->stopping)
+			pthread_cond_wait(&queue->work, &queue->lock);
+		SM_IORequest *request = queue->queueHead;
+		if(request == NULL)
+			break;
+		queue->queueHead = request->next;
+		if(queue->queueHead == NULL)
+			queue->queueTail = NULL;
+		pthread_mutex_unlock(&queue->lock);
+		RC result = transferBlocks(queue->fd, queue->pageSize, request->pageNum, request->numPages, request->memPages, request->write);
+		pthread_mutex_lock(&queue->lock);
+		finishRequest(queue, request, result);
+		pthread_cond_broadcast(&queue->completion);
+	}
+	pthread_mutex_unlock(&queue->lock);
+	return NULL;
+}
+
+#ifdef SM_IO_URING
+
+/* FUNCTION NAME : ringEnter
+   DESCRIPTION   : hands toSubmit new entries to the kernel and, if wait is set, waits for at least one completion */
+
+static void ringEnter (IOQueue *queue, unsigned toSubmit, int wait) {
+	while(syscall(__NR_io_uring_enter, queue->ringFd, toSubmit, wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0) < 0
+	      && errno == EINTR)
+		;
+}
+
+/* FUNCTION NAME : ringReap
+   DESCRIPTION   : moves the requests the kernel has completed to the completed requests */
+
+static void ringReap (IOQueue *queue) {
+	unsigned head = *queue->cqHead;
+	unsigned tail = __atomic_load_n(queue->cqTail, __ATOMIC_ACQUIRE);
+	while(head != tail) {
+		struct io_uring_cqe *cqe = &queue->cqes[head & *queue->cqMask];
+		SM_IORequest *request = (SM_IORequest *)(uintptr_t)cqe->user_data;
+		// a regular file only transfers less than asked for at its end, which the bounds checks rule out for reads
+		if(cqe->res == request->numPages * queue->pageSize)
+			finishRequest(queue, request, RC_OK);
+		else
+			finishRequest(queue, request, request->write ? RC_WRITE_FAILED : RC_READ_FAILED);
+		head++;
+	}
+	__atomic_store_n(queue->cqHead, head, __ATOMIC_RELEASE);
+}
+
+/* FUNCTION NAME : ringOpen
+   DESCRIPTION   : sets up an io_uring of IO_QUEUE_DEPTH entries and maps its rings, returns 0 if the kernel refuses */
+
+static int ringOpen (IOQueue *queue) {
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	queue->ringFd = syscall(__NR_io_uring_setup, IO_QUEUE_DEPTH, &params);
+	if(queue->ringFd < 0)
+		return 0;
+
+	int singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	queue->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	queue->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	if(singleMap) {
+		if(queue->cqRingSize > queue->sqRingSize)
+			queue->sqRingSize = queue->cqRingSize;
+		queue->cqRingSize = queue->sqRingSize;
+	}
+	queue->sqRing = mmap(NULL, queue->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, queue->ringFd, IORING_OFF_SQ_RING);
+	queue->cqRing = singleMap ? queue->sqRing :
+		mmap(NULL, queue->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, queue->ringFd, IORING_OFF_CQ_RING);
+	queue->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+	queue->sqes = mmap(NULL, queue->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, queue->ringFd, IORING_OFF_SQES);
+	if(queue->sqRing == MAP_FAILED || queue->cqRing == MAP_FAILED || queue->sqes == MAP_FAILED) {
+		if(queue->sqes != MAP_FAILED)
+			munmap(queue->sqes, queue->sqesSize);
+		if(queue->cqRing != MAP_FAILED && !singleMap)
+			munmap(queue->cqRing, queue->cqRingSize);
+		if(queue->sqRing != MAP_FAILED)
+			munmap(queue->sqRing, queue->sqRingSize);
+		close(queue->ringFd);
+		queue->ringFd = -1;
+		return 0;
+	}
+
+	char *sq = (char *)queue->sqRing, *cq = (char *)queue->cqRing;
+	queue->sqTail = (unsigned *)(sq + params.sq_off.tail);
+	queue->sqMask = (unsigned *)(sq + params.sq_off.ring_mask);
+	queue->sqArray = (unsigned *)(sq + params.sq_off.array);
+	queue->cqHead = (unsigned *)(cq + params.cq_off.head);
+	queue->cqTail = (unsigned *)(cq + params.cq_off.tail);
+	queue->cqMask = (unsigned *)(cq + params.cq_off.ring_mask);
+	queue->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+	return 1;
+}
+
+/* FUNCTION NAME : ringSubmit
+   DESCRIPTION   : puts one request on the submission ring, ringEnter hands it to the kernel */
+
+static void ringSubmit (IOQueue *queue, SM_IORequest *request) {
+	struct iovec *iov = (struct iovec *)malloc(sizeof(struct iovec) * request->numPages);
+	unsigned tail = *queue->sqTail, index = tail & *queue->sqMask;
+	struct io_uring_sqe *sqe = &queue->sqes[index];
+	int i;
+	for(i = 0; i < request->numPages; i++) {
+		iov[i].iov_base = request->memPages[i];
+		iov[i].iov_len = queue->pageSize;
+	}
+	request->iov = iov;
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = request->write ? IORING_OP_WRITEV : IORING_OP_READV;
+	sqe->fd = queue->fd;
+	sqe->addr = (uintptr_t)iov;
+	sqe->len = request->numPages;
+	sqe->off = (uint64_t)BLOCK_OFFSET(queue->pageSize, request->pageNum);
+	sqe->user_data = (uintptr_t)request;
+	queue->sqArray[index] = index;
+	__atomic_store_n(queue->sqTail, tail + 1, __ATOMIC_RELEASE);
+}
+
+#endif
+
+/* FUNCTION NAME : openQueue
+   DESCRIPTION   : sets up the asynchronous request queue of an open page file */
+
+static IOQueue *openQueue (int fd, int pageSize) {
+	IOQueue *queue = (IOQueue *)calloc(1, sizeof(IOQueue));
+	int i;
+	queue->fd = fd;
+	queue->pageSize = pageSize;
+	pthread_mutex_init(&queue->lock, NULL);
+	pthread_cond_init(&queue->completion, NULL);
+	pthread_cond_init(&queue->work, NULL);
+#ifdef SM_IO_URING
+	if(ringOpen(queue))
+		return queue;
+#endif
+	for(i = 0; i < IO_THREADS; i++)
+		if(pthread_create(&queue->threads[queue->numThreads], NULL, ioThread, queue) == 0)
+			queue->numThreads++;
+	return queue;
+}
+
+/* FUNCTION NAME : waitForCompletion
+   DESCRIPTION   : waits until at least one more request has completed, the caller holds queue->lock and has requests in flight */
+
+static void waitForCompletion (IOQueue *queue) {
+#ifdef SM_IO_URING
+	if(queue->ringFd >= 0) {
+		int done = queue->numDone;
+		ringReap(queue);
+		while(queue->numDone == done) {
+			ringEnter(queue, 0, 1);
+			ringReap(queue);
+		}
+		return;
+	}
+#endif
+	pthread_cond_wait(&queue->completion, &queue->lock);
+}
+
+/* FUNCTION NAME : closeQueue
+   DESCRIPTION   : waits for the requests in flight, then releases the queue. Completed requests not handed back are dropped */
+
+static void closeQueue (IOQueue *queue) {
+	int i;
+	pthread_mutex_lock(&queue->lock);
+	while(queue->inFlight > 0)
+		waitForCompletion(queue);
+	queue->stopping = 1;
+	pthread_cond_broadcast(&queue->work);
+	pthread_mutex_unlock(&queue->lock);
+	for(i = 0; i < queue->numThreads; i++)
+		pthread_join(queue->threads[i], NULL);
+#ifdef SM_IO_URING
+	if(queue->ringFd >= 0) {
+		munmap(queue->sqes, queue->sqesSize);
+		if(queue->cqRing != queue->sqRing)
+			munmap(queue->cqRing, queue->cqRingSize);
+		munmap(queue->sqRing, queue->sqRingSize);
+		close(queue->ringFd);
+	}
+#endif
+	pthread_mutex_destroy(&queue->lock);
+	pthread_cond_destroy(&queue->completion);
+	pthread_cond_destroy(&queue->work);
+	free(queue);
+}
+
+/* FUNCTION NAME : submitBlocks
+   DESCRIPTION   : starts the given reads and writes and returns without waiting for them, completeBlocks hands them back once done.
+                   Reads have to lie within the file, writes past its end grow it. Nothing is submitted if one request is invalid.
+                   At most IO_QUEUE_DEPTH requests are in flight, beyond that it waits for earlier ones to complete.
+                   Calls on one file handle must not overlap, like every other call. */
+
+extern RC submitBlocks (SM_FileHandle *fHandle, SM_IORequest **requests, int numRequests) {
+	FileInfo *info = (FileInfo *)fHandle->mgmtInfo;
+	int i, j;
+	if(info == NULL)
+		return RC_FILE_HANDLE_NOT_INIT;
+	for(i = 0; i < numRequests; i++) {
+		SM_IORequest *request = requests[i];
+		if(request->pageNum < 0 || request->numPages < 1)
+			return request->write ? RC_WRITE_FAILED : RC_READ_NON_EXISTING_PAGE;
+		if(!request->write && request->pageNum + request->numPages > fHandle->totalNumPages)
+			return RC_READ_NON_EXISTING_PAGE;
+		if(!alignedPages(info, request->memPages, request->numPages))
+			return request->write ? RC_WRITE_FAILED : RC_READ_NON_EXISTING_PAGE;
+	}
+	for(i = 0; i < numRequests; i++)
+		if(requests[i]->write)
+			for(j = 0; j < requests[i]->numPages; j++)
+				sealPage(info, requests[i]->memPages[j]);
+	if(info->queue == NULL)
+		info->queue = openQueue(info->fd, info->pageSize);
+
+	IOQueue *queue = info->queue;
+	pthread_mutex_lock(&queue->lock);
+	if(info->pageMap != NULL) {
+		// only the caller may touch the page map of a compressed file, so its requests are served right here
+		// and merely handed back by completeBlocks
+		for(i = 0; i < numRequests; i++) {
+			SM_IORequest *request = requests[i];
+			RC result;
+			if(request->write) {
+				int *pageNums = (int *)malloc(sizeof(int) * request->numPages);
+				for(j = 0; j < request->numPages; j++)
+					pageNums[j] = request->pageNum + j;
+				if((result = growFile(fHandle, request->pageNum + request->numPages)) == RC_OK)
+					result = writeCompressedBlocks(info, pageNums, request->numPages, request->memPages);
+				free(pageNums);
+			} else
+				result = readCompressedBlocks(info, request->pageNum, request->numPages, request->memPages);
+			request->iov = NULL;
+			queue->inFlight++;
+			finishRequest(queue, request, result);
+		}
+		pthread_mutex_unlock(&queue->lock);
+		return RC_OK;
+	}
+#ifdef SM_IO_URING
+	if(queue->ringFd >= 0) {
+		unsigned toSubmit = 0;
+		for(i = 0; i < numRequests; i++) {
+			if(queue->inFlight >= IO_QUEUE_DEPTH) {
+				// the entries put on the ring so far go to the kernel before waiting for room
+				ringEnter(queue, toSubmit, 0);
+				toSubmit = 0;
+				while(queue->inFlight >= IO_QUEUE_DEPTH)
+					waitForCompletion(queue);
+			}
+			ringSubmit(queue, requests[i]);
+			toSubmit++;
+			queue->inFlight++;
+		}
+		if(toSubmit > 0)
+			ringEnter(queue, toSubmit, 0);
+		pthread_mutex_unlock(&queue->lock);
+		return RC_OK;
+	}
+#endif
+	for(i = 0; i < numRequests; i++) {
+		SM_IORequest *request = requests[i];
+		while(queue->inFlight >= IO_QUEUE_DEPTH)
+			waitForCompletion(queue);
+		request->iov = NULL;
+		request->next = NULL;
+		if(queue->queueTail == NULL)
+			queue->queueHead = request;
+		else
+			queue->queueTail->next = request;
+		queue->queueTail = request;
+		queue->inFlight++;
+		pthread_cond_signal(&queue->work);
+	}
+	pthread_mutex_unlock(&queue->lock);
 	return RC_OK;
-}
\ No newline at end of file
+}
+
+/* FUNCTION NAME : completeBlocks
+   DESCRIPTION   : waits until at least minRequests submitted requests have completed, or all of them if fewer are in flight,
+                   and hands back up to maxRequests completed ones in completion order. Their result tells whether they succeeded.
+                   The file handle counts the pages a write added once the write is handed back. */
+
+extern RC completeBlocks (SM_FileHandle *fHandle, SM_IORequest **completed, int minRequests, int maxRequests, int *numCompleted) {
+	FileInfo *info = (FileInfo *)fHandle->mgmtInfo;
+	*numCompleted = 0;
+	if(info == NULL)
+		return RC_FILE_HANDLE_NOT_INIT;
+	IOQueue *queue = info->queue;
+	if(queue == NULL)
+		return RC_OK;
+
+	pthread_mutex_lock(&queue->lock);
+	if(minRequests > maxRequests)
+		minRequests = maxRequests;
+	if(minRequests > queue->numDone + queue->inFlight)
+		minRequests = queue->numDone + queue->inFlight;
+#ifdef SM_IO_URING
+	if(queue->ringFd >= 0)
+		ringReap(queue);
+#endif
+	while(queue->numDone < minRequests)
+		waitForCompletion(queue);
+	while(*numCompleted < maxRequests && queue->doneHead != NULL) {
+		SM_IORequest *request = queue->doneHead;
+		queue->doneHead = request->next;
+		if(queue->doneHead == NULL)
+			queue->doneTail = NULL;
+		queue->numDone--;
+		request->next = NULL;
+		if(request->write && request->result == RC_OK)
+			growFile(fHandle, request->pageNum + request->numPages);
+		if(!request->write && request->result == RC_OK)
+			request->result = checkPages(info, request->memPages, request->numPages);
+		completed[(*numCompleted)++] = request;
+	}
+	pthread_mutex_unlock(&queue->lock);
+	return RC_OK;
+}
+
+/* FUNCTION NAME : extendMapping
+   DESCRIPTION   : maps the part of the header and the first numPages blocks not mapped yet right behind what is mapped already */
+
+static RC extendMapping (FileInfo *info, int numPages) {
+	size_t length = (size_t)BLOCK_OFFSET(info->pageSize, numPages);
+	if(length <= info->mapLength)
+		return RC_OK;
+	if(length > info->mapReserved)
+		return RC_READ_NON_EXISTING_PAGE;
+	if(mmap(info->map + info->mapLength, length - info->mapLength, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+	        info->fd, (off_t)info->mapLength) == MAP_FAILED)
+		return RC_READ_NON_EXISTING_PAGE;
+	madvise(info->map + info->mapLength, length - info->mapLength, info->mapAdvice);
+	info->mapLength = length;
+	return RC_OK;
+}
+
+/* FUNCTION NAME : mapPageFile
+   DESCRIPTION   : maps the page file into memory so getMappedBlock can hand out its blocks without copying them.
+                   sequential tells the kernel to read ahead aggressively, otherwise it expects random access.
+                   The mapping grows with the file and is released by closePageFile. */
+
+extern RC mapPageFile (SM_FileHandle *fHandle, int sequential) {
+	FileInfo *info = (FileInfo *)fHandle->mgmtInfo;
+	size_t reserve, needed;
+	if(info == NULL)
+		return RC_FILE_HANDLE_NOT_INIT;
+	needed = (size_t)BLOCK_OFFSET(info->pageSize, fHandle->totalNumPages);
+	// a mapping is served from the page cache a direct file keeps out of, writes through it would leave checksums stale
+	// and compressed blocks are not where the mapping would have them
+	if(info->direct || (info->flags & (FILE_CHECKSUMS | FILE_COMPRESSED)))
+		return RC_READ_NON_EXISTING_PAGE;
+	info->mapAdvice = sequential ? MADV_SEQUENTIAL : MADV_RANDOM;
+	if(info->map != NULL) {
+		madvise(info->map, info->mapLength, info->mapAdvice);
+		return RC_OK;
+	}
+
+	// only address space is reserved here, extendMapping maps the file over it
+	for(reserve = MAP_RESERVE_SIZE; reserve >= needed && reserve >= PAGE_SIZE; reserve /= 2) {
+		void *map = mmap(NULL, reserve, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if(map != MAP_FAILED) {
+			info->map = (char *)map;
+			info->mapReserved = reserve;
+			info->mapLength = 0;
+			return extendMapping(info, fHandle->totalNumPages);
+		}
+	}
+	return RC_READ_NON_EXISTING_PAGE;
+}
+
+/* FUNCTION NAME : getMappedBlock
+   DESCRIPTION   : returns the address of the pageNum-th block in the mapping of the page file, NULL if it does not exist.
+                   Blocks added since the file was mapped are mapped on first use. Writes to the block go to the file. */
+
+extern SM_PageHandle getMappedBlock (int pageNum, SM_FileHandle *fHandle) {
+	FileInfo *info = (FileInfo *)fHandle->mgmtInfo;
+	if(info == NULL || info->map == NULL || pageNum < 0 || pageNum >= fHandle->totalNumPages)
+		return NULL;
+	if((size_t)BLOCK_OFFSET(info->pageSize, pageNum + 1) > info->mapLength && extendMapping(info, fHandle->totalNumPages) != RC_OK)
+		return NULL;
+	return info->map + BLOCK_OFFSET(info->pageSize, pageNum);
+}
+
+/* FUNCTION NAME : prefetchMappedBlocks
+   DESCRIPTION   : asks the kernel to start reading numPages mapped blocks from pageNum on */
+
+extern RC prefetchMappedBlocks (int pageNum, int numPages, SM_FileHandle *fHandle) {
+	if(pageNum < 0 || numPages < 1 || getMappedBlock(pageNum + numPages - 1, fHandle) == NULL)
+		return RC_READ_NON_EXISTING_PAGE;
+	madvise(getMappedBlock(pageNum, fHandle), (size_t)numPages * fHandle->pageSize, MADV_WILLNEED);
+	return RC_OK;
+}
+
+/* FUNCTION NAME : flushMappedBlocks
+   DESCRIPTION   : writes numPages mapped blocks from pageNum on to disk and waits until they are there,
+                   the header too if the file has grown since it was last written */
+
+extern RC flushMappedBlocks (int pageNum, int numPages, SM_FileHandle *fHandle) {
+	if(pageNum < 0 || numPages < 1 || getMappedBlock(pageNum + numPages - 1, fHandle) == NULL)
+		return RC_WRITE_FAILED;
+	if(msync(getMappedBlock(pageNum, fHandle), (size_t)numPages * fHandle->pageSize, MS_SYNC) != 0)
+		return RC_WRITE_FAILED;
+	return storePageCount(fHandle);
+}
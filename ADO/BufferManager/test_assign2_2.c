@@ -7,6 +7,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/resource.h>
 
 // var to store the current test's name
 char *testName;
@@ -35,6 +39,33 @@ static void testLRU_K (void);
 
 static void testError (void);
 
+static void testMultiplePools (void);
+
+static void testLFU (void);
+
+static void testLRU_KScan (void);
+
+static void testARC (void);
+
+static void testBackgroundWriter (void);
+
+static void testConcurrentPins (void);
+
+static void testConcurrentAttach (void);
+
+static void testReadAhead (void);
+static void testMappedPool (void);
+static void testDirectPool (void);
+static void testChecksummedPool (void);
+static void testCompressedPool (void);
+static void testLargePagePool (void);
+static void testSharedPool (void);
+static void testWritePages (void);
+static void testFailedWriteBack (void);
+static void limitFileSize (rlim_t bytes);
+static void corruptPage (char *fileName, char *content, int offset);
+static void *concurrentPinWorker (void *arg);
+
 void testReadPage()
 {
   BM_BufferPool *bm = MAKE_POOL();
@@ -231,9 +262,8 @@ testError (void)
     CHECK(pinPage(bm, h, 0));
     CHECK(pinPage(bm, h, 1));
     CHECK(pinPage(bm, h, 2));
-    CHECK(pinPage(bm,h,3));
     
-    // ASSERT_ERROR(pinPage(bm, h, 3), "try to pin page when pool is full of pinned pages with fix-count > 0");
+    ASSERT_ERROR(pinPage(bm, h, 3), "try to pin page when pool is full of pinned pages with fix-count > 0");
     
     // CHECK(shutdownBufferPool(bm));
     
@@ -264,14 +294,995 @@ testError (void)
     free(h);
     TEST_DONE();
 }
+// test that two pools on different page files keep their own state
+void
+testMultiplePools (void)
+{
+    int i;
+    BM_BufferPool *bm1 = MAKE_POOL();
+    BM_BufferPool *bm2 = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    testName = "Testing multiple buffer pools";
+    
+    CHECK(createPageFile("testbuffer.bin"));
+    CHECK(createPageFile("testbuffer2.bin"));
+    CHECK(initBufferPool(bm1, "testbuffer.bin", 3, RS_FIFO, NULL));
+    CHECK(initBufferPool(bm2, "testbuffer2.bin", 4, RS_CLOCK, NULL));
+    
+    // interleave requests so that each pool would see the other one's counters if they were shared
+    for (i = 0; i < 5; i++)
+    {
+        CHECK(pinPage(bm1, h, i));
+        if (i == 0)
+            CHECK(markDirty(bm1, h));
+        CHECK(unpinPage(bm1, h));
+        if (i < 2)
+        {
+            CHECK(pinPage(bm2, h, i));
+            CHECK(unpinPage(bm2, h));
+        }
+    }
+    
+    ASSERT_EQUALS_POOL("[3 0],[4 0],[2 0]", bm1, "check content of first pool");
+    ASSERT_EQUALS_POOL("[0 0],[1 0],[-1 0],[-1 0]", bm2, "check content of second pool");
+    ASSERT_EQUALS_INT(1, getNumWriteIO(bm1), "check number of write I/Os of first pool");
+    ASSERT_EQUALS_INT(5, getNumReadIO(bm1), "check number of read I/Os of first pool");
+    ASSERT_EQUALS_INT(0, getNumWriteIO(bm2), "check number of write I/Os of second pool");
+    ASSERT_EQUALS_INT(2, getNumReadIO(bm2), "check number of read I/Os of second pool");
+    
+    CHECK(shutdownBufferPool(bm1));
+    CHECK(shutdownBufferPool(bm2));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    CHECK(destroyPageFile("testbuffer2.bin"));
+    
+    free(bm1);
+    free(bm2);
+    free(h);
+    TEST_DONE();
+}
+
+// test two files sharing the frames of one pool
+void
+testSharedPool (void)
+{
+    BM_BufferPool *shared = MAKE_POOL();
+    BM_BufferPool *bm1 = MAKE_POOL();
+    BM_BufferPool *bm2 = MAKE_POOL();
+    BM_BufferPool *bm3 = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    int i;
+    testName = "Testing a shared buffer pool";
+    
+    CHECK(createPageFile("testbuffer.bin"));
+    CHECK(createPageFile("testbuffer2.bin"));
+    CHECK(createPageFileWithOptions("testbuffer3.bin", 4 * PAGE_SIZE, 0));
+    CHECK(initSharedBufferPool(shared, 4, PAGE_SIZE, RS_LRU, NULL));
+    CHECK(attachBufferPool(bm1, shared, "testbuffer.bin"));
+    CHECK(attachBufferPool(bm2, shared, "testbuffer2.bin"));
+    ASSERT_ERROR(attachBufferPool(bm3, shared, "testbuffer3.bin"), "attaching a file with another page size");
+    ASSERT_ERROR(attachBufferPool(bm3, bm1, "testbuffer3.bin"), "attaching to a pool that is not shared");
+    ASSERT_ERROR(pinPage(shared, h, 0), "pinning a page of the shared pool itself");
+    
+    // page 0 of each file is cached in its own frame
+    CHECK(pinPage(bm1, h, 0));
+    sprintf(h->data, "%s-%i", "File1", 0);
+    CHECK(markDirty(bm1, h));
+    CHECK(unpinPage(bm1, h));
+    CHECK(pinPage(bm2, h, 0));
+    sprintf(h->data, "%s-%i", "File2", 0);
+    CHECK(markDirty(bm2, h));
+    CHECK(unpinPage(bm2, h));
+    
+    // the first file takes the frames it needs, evicting its least recently used page
+    for (i = 1; i < 4; i++)
+    {
+        CHECK(pinPage(bm1, h, i));
+        CHECK(unpinPage(bm1, h));
+    }
+    ASSERT_EQUALS_POOL("[3 0],[-1 0],[1 0],[2 0]", bm1, "check the frames of the first file");
+    ASSERT_EQUALS_POOL("[-1 0],[0x0],[-1 0],[-1 0]", bm2, "check the frames of the second file");
+    ASSERT_EQUALS_POOL("[3 0],[0x0],[1 0],[2 0]", shared, "check the frames of the shared pool");
+    ASSERT_EQUALS_INT(4, getNumReadIO(bm1), "check number of read I/Os of the first file");
+    ASSERT_EQUALS_INT(1, getNumWriteIO(bm1), "check number of write I/Os of the first file");
+    ASSERT_EQUALS_INT(1, getNumReadIO(bm2), "check number of read I/Os of the second file");
+    ASSERT_EQUALS_INT(0, getNumWriteIO(bm2), "check number of write I/Os of the second file");
+    ASSERT_EQUALS_INT(5, getNumReadIO(shared), "check number of read I/Os of the shared pool");
+    ASSERT_ERROR(shutdownBufferPool(shared), "shutting down a shared pool with files attached");
+    
+    // detaching a file writes back its pages and frees its frames
+    CHECK(shutdownBufferPool(bm2));
+    ASSERT_EQUALS_POOL("[3 0],[-1 0],[1 0],[2 0]", shared, "check the frames of the shared pool after detaching");
+    ASSERT_EQUALS_INT(2, getNumWriteIO(shared), "check number of write I/Os of the shared pool");
+    CHECK(attachBufferPool(bm2, shared, "testbuffer2.bin"));
+    CHECK(pinPage(bm2, h, 0));
+    ASSERT_EQUALS_STRING("File2-0", h->data, "reading page content of the second file");
+    CHECK(unpinPage(bm2, h));
+    CHECK(pinPage(bm1, h, 0));
+    ASSERT_EQUALS_STRING("File1-0", h->data, "reading page content of the first file");
+    CHECK(unpinPage(bm1, h));
+    
+    CHECK(shutdownBufferPool(bm1));
+    CHECK(shutdownBufferPool(bm2));
+    CHECK(shutdownBufferPool(shared));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    CHECK(destroyPageFile("testbuffer2.bin"));
+    CHECK(destroyPageFile("testbuffer3.bin"));
+    
+    free(shared);
+    free(bm1);
+    free(bm2);
+    free(bm3);
+    free(h);
+    TEST_DONE();
+}
+
+// test the LFU page replacement strategy
+void
+testLFU (void)
+{
+    // expected results
+    const char *poolContents[] = {
+        // page 2 is used least often and goes first, then the newly read pages replace each other
+        "[0 0],[1 0],[3 0]",
+        "[0 0],[1 0],[4 0]",
+        // once page 4 is used more often than page 1, page 1 is the victim
+        "[0 0],[5 0],[4 0]"
+    };
+    const int useCounts[] = {3, 2, 1};
+    
+    int i, j;
+    int snapshot = 0;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    testName = "Testing LFU page replacement";
+    
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 100);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LFU, NULL));
+    
+    for(i = 0; i < 3; i++)
+        for(j = 0; j < useCounts[i]; j++)
+        {
+            CHECK(pinPage(bm, h, i));
+            CHECK(unpinPage(bm, h));
+        }
+    
+    for(i = 3; i < 5; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(unpinPage(bm, h));
+        ASSERT_EQUALS_POOL(poolContents[snapshot++], bm, "check pool content using pages");
+    }
+    
+    for(j = 0; j < 2; j++)
+    {
+        CHECK(pinPage(bm, h, 4));
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(pinPage(bm, h, 5));
+    CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_POOL(poolContents[snapshot++], bm, "check pool content using pages");
+    
+    ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+    ASSERT_EQUALS_INT(6, getNumReadIO(bm), "check number of read I/Os");
+    
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// test that LRU_K with K = 2 keeps pages used twice while a scan streams through the pool
+void
+testLRU_KScan (void)
+{
+    // expected results
+    const char *poolContents[] = {
+        "[0 0],[1 0],[3 0]",
+        "[0 0],[1 0],[4 0]",
+        "[0 0],[1 0],[5 0]",
+        "[0 0],[1 0],[6 0]"
+    };
+    // requests are far enough apart that the second use of a page is not a correlated reference
+    const int useRequests[] = {0, 1, 2, 0, 1};
+    
+    int i;
+    int k = 2;
+    int snapshot = 0;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    testName = "Testing LRU_K page replacement during a scan";
+    
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 100);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU_K, &k));
+    
+    for(i = 0; i < 5; i++)
+    {
+        CHECK(pinPage(bm, h, useRequests[i]));
+        CHECK(unpinPage(bm, h));
+    }
+    
+    // pages read once by the scan replace each other instead of pages 0 and 1
+    for(i = 3; i < 7; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(unpinPage(bm, h));
+        ASSERT_EQUALS_POOL(poolContents[snapshot++], bm, "check pool content during scan");
+    }
+    
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// test the ARC page replacement strategy
+void
+testARC (void)
+{
+    // expected results
+    const char *poolContents[] = {
+        // pages used once are evicted before pages 0 and 1, which were used twice
+        "[0 0],[1 0],[3 0]",
+        "[0 0],[1 0],[4 0]",
+        // asking for page 2 again, which was evicted from the pages used once, makes room for it among those by evicting page 0
+        "[2 0],[1 0],[4 0]"
+    };
+    const int requests[] = {0, 1, 0, 1, 2, 3, 4, 2};
+    
+    int i;
+    int snapshot = 0;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    testName = "Testing ARC page replacement";
+    
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 100);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_ARC, NULL));
+    
+    for(i = 0; i < 8; i++)
+    {
+        CHECK(pinPage(bm, h, requests[i]));
+        CHECK(unpinPage(bm, h));
+        if(i >= 5)
+            ASSERT_EQUALS_POOL(poolContents[snapshot++], bm, "check pool content using pages");
+    }
+    
+    ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+    ASSERT_EQUALS_INT(6, getNumReadIO(bm), "check number of read I/Os");
+    
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// test that the background writer cleans the coldest unpinned dirty pages without a flush
+void
+testBackgroundWriter (void)
+{
+    int i, waited;
+    bool *dirtyFlags;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    SM_FileHandle fh;
+    SM_PageHandle ph = (SM_PageHandle) malloc(PAGE_SIZE);
+    testName = "Testing background writer";
+    
+    CHECK(createPageFile("testbuffer.bin"));
+    CHECK(initBufferPool(bm, "testbuffer.bin", 8, RS_LRU, NULL));
+    CHECK(startBackgroundWriter(bm));
+    
+    for (i = 0; i < 4; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        sprintf(h->data, "%s-%i", "Page", h->pageNum);
+        CHECK(markDirty(bm, h));
+        CHECK(unpinPage(bm, h));
+    }
+    
+    // the writer keeps the next quarter of the victims clean, with 8 frames these are the least recently used pages 0 and 1
+    for (waited = 0; waited < 2000; waited++)
+    {
+        dirtyFlags = getDirtyFlags(bm);
+        int done = !dirtyFlags[0] && !dirtyFlags[1];
+        free(dirtyFlags);
+        if (done)
+            break;
+        usleep(1000);
+    }
+    ASSERT_TRUE(waited < 2000, "background writer cleaned the coldest dirty pages");
+    CHECK(stopBackgroundWriter(bm));
+    ASSERT_EQUALS_POOL("[0 0],[1 0],[2x0],[3x0],[-1 0],[-1 0],[-1 0],[-1 0]", bm, "only the coldest pages are cleaned");
+    ASSERT_EQUALS_INT(2, getNumWriteIO(bm), "check number of write I/Os");
+    
+    // the pages are on disk before the pool flushes anything
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    for (i = 0; i < 2; i++)
+    {
+        char expected[PAGE_SIZE];
+        sprintf(expected, "%s-%i", "Page", i);
+        CHECK(readBlock(i, &fh, ph));
+        ASSERT_EQUALS_STRING(expected, ph, "page written by the background writer");
+    }
+    CHECK(closePageFile(&fh));
+    
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    
+    free(ph);
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// each thread of testConcurrentPins pins random pages and checks that a pinned page holds its own content
+#define CONCURRENT_THREADS 4
+#define CONCURRENT_PAGES 64
+#define CONCURRENT_PINS 2000
+#define CONCURRENT_ATTACHES 64
+
+static BM_BufferPool *concurrentPool;
+
+void *
+concurrentPinWorker (void *arg)
+{
+    unsigned int seed = *(unsigned int *) arg;
+    int i, errors = 0;
+    char expected[PAGE_SIZE];
+    BM_PageHandle h;
+    
+    for (i = 0; i < CONCURRENT_PINS; i++)
+    {
+        int pageNum = rand_r(&seed) % CONCURRENT_PAGES;
+        sprintf(expected, "%s-%i", "Page", pageNum);
+        if (pinPage(concurrentPool, &h, pageNum) != RC_OK || h.pageNum != pageNum || strcmp(h.data, expected) != 0)
+            errors++;
+        if (unpinPage(concurrentPool, &h) != RC_OK)
+            errors++;
+    }
+    *(unsigned int *) arg = errors;
+    return NULL;
+}
+
+// test that threads sharing a pool never see a page that was evicted while they had it pinned, nor a page
+// another thread is still reading, and that a page read by two threads at once is cached once
+void
+testConcurrentPins (void)
+{
+    const ReplacementStrategy strategies[] = {RS_CLOCK, RS_LRU, RS_ARC};
+    int i, j, s, errors = 0;
+    int *fixCounts;
+    PageNumber *frameContents;
+    pthread_t threads[CONCURRENT_THREADS];
+    unsigned int results[CONCURRENT_THREADS];
+    BM_BufferPool *bm = MAKE_POOL();
+    testName = "Testing concurrent pins";
+    
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, CONCURRENT_PAGES);
+    for (s = 0; s < 3; s++)
+    {
+        CHECK(initBufferPool(bm, "testbuffer.bin", 8, strategies[s], NULL));
+        concurrentPool = bm;
+        
+        for (i = 0; i < CONCURRENT_THREADS; i++)
+        {
+            results[i] = i + 1;
+            pthread_create(&threads[i], NULL, concurrentPinWorker, &results[i]);
+        }
+        for (i = 0; i < CONCURRENT_THREADS; i++)
+        {
+            pthread_join(threads[i], NULL);
+            errors += results[i];
+        }
+        ASSERT_EQUALS_INT(0, errors, "every pinned page held its own content");
+        
+        fixCounts = getFixCounts(bm);
+        for (i = 0; i < 8; i++)
+            errors += fixCounts[i];
+        free(fixCounts);
+        ASSERT_EQUALS_INT(0, errors, "all pages are unpinned");
+        
+        frameContents = getFrameContents(bm);
+        for (i = 0; i < 8; i++)
+            for (j = i + 1; j < 8; j++)
+                if (frameContents[i] != NO_PAGE && frameContents[i] == frameContents[j])
+                    errors++;
+        free(frameContents);
+        ASSERT_EQUALS_INT(0, errors, "no page is cached twice");
+        
+        CHECK(shutdownBufferPool(bm));
+    }
+    CHECK(destroyPageFile("testbuffer.bin"));
+    
+    free(bm);
+    TEST_DONE();
+}
+
+// test that files attached to and detached from a shared pool do not disturb threads pinning the pages of another file
+void
+testConcurrentAttach (void)
+{
+    int i, errors = 0;
+    pthread_t threads[CONCURRENT_THREADS];
+    unsigned int results[CONCURRENT_THREADS];
+    BM_BufferPool *shared = MAKE_POOL();
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_BufferPool *others = (BM_BufferPool *) malloc(sizeof(BM_BufferPool) * CONCURRENT_ATTACHES);
+    testName = "Testing attaching files while pinning";
+    
+    CHECK(createPageFile("testbuffer.bin"));
+    CHECK(createPageFile("testbuffer2.bin"));
+    createDummyPages(bm, CONCURRENT_PAGES);
+    CHECK(initSharedBufferPool(shared, 8, PAGE_SIZE, RS_CLOCK, NULL));
+    CHECK(attachBufferPool(bm, shared, "testbuffer.bin"));
+    concurrentPool = bm;
+    
+    for (i = 0; i < CONCURRENT_THREADS; i++)
+    {
+        results[i] = i + 1;
+        pthread_create(&threads[i], NULL, concurrentPinWorker, &results[i]);
+    }
+    for (i = 0; i < CONCURRENT_ATTACHES; i++)
+        CHECK(attachBufferPool(&others[i], shared, "testbuffer2.bin"));
+    for (i = 0; i < CONCURRENT_ATTACHES; i++)
+        CHECK(shutdownBufferPool(&others[i]));
+    for (i = 0; i < CONCURRENT_THREADS; i++)
+    {
+        pthread_join(threads[i], NULL);
+        errors += results[i];
+    }
+    ASSERT_EQUALS_INT(0, errors, "every pinned page held its own content");
+    
+    CHECK(shutdownBufferPool(bm));
+    CHECK(shutdownBufferPool(shared));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    CHECK(destroyPageFile("testbuffer2.bin"));
+    
+    free(others);
+    free(bm);
+    free(shared);
+    TEST_DONE();
+}
+
+// test that sequential misses and prefetchPages read the following pages ahead in the background without pinning them
+void
+testReadAhead (void)
+{
+    // expected results
+    const char *poolContents[] = {
+        // two misses on consecutive pages read the next 16/4 pages ahead
+        "[0 0],[1 0],[2 0],[3 0],[4 0],[5 0],[-1 0],[-1 0],[-1 0],[-1 0],[-1 0],[-1 0],[-1 0],[-1 0],[-1 0],[-1 0]",
+        // pinning the first page of each read-ahead starts reading the next pages ahead, here 6 to 9 and 10 to 13
+        "[0 0],[1 0],[2 0],[3 0],[4 0],[5 0],[6 0],[7 0],[8 0],[9 0],[10 0],[11 0],[12 0],[13 0],[-1 0],[-1 0]",
+        // the hint fills the two free frames and takes the least recently used one
+        "[52 0],[1 0],[2 0],[3 0],[4 0],[5 0],[6 0],[7 0],[8 0],[9 0],[10 0],[11 0],[12 0],[13 0],[50 0],[51 0]"
+    };
+    
+    int i;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    testName = "Testing read-ahead";
+    
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 100);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 16, RS_LRU, NULL));
+    
+    for (i = 0; i < 7; i++)
+    {
+        char expected[PAGE_SIZE];
+        CHECK(pinPage(bm, h, i));
+        sprintf(expected, "%s-%i", "Page", i);
+        ASSERT_EQUALS_STRING(expected, h->data, "reading back dummy page content");
+        CHECK(unpinPage(bm, h));
+        if (i == 1)
+        {
+            ASSERT_EQUALS_POOL(poolContents[0], bm, "check pool content after two sequential misses");
+            ASSERT_EQUALS_INT(6, getNumReadIO(bm), "check number of read I/Os");
+        }
+    }
+    ASSERT_EQUALS_POOL(poolContents[1], bm, "check pool content after reading ahead again");
+    ASSERT_EQUALS_INT(14, getNumReadIO(bm), "check number of read I/Os");
+    
+    // an explicit hint loads the pages unpinned, the pin that follows is a hit
+    CHECK(prefetchPages(bm, 50, 3));
+    ASSERT_EQUALS_POOL(poolContents[2], bm, "check pool content after prefetching");
+    CHECK(pinPage(bm, h, 51));
+    ASSERT_EQUALS_STRING("Page-51", h->data, "reading back prefetched page content");
+    CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_INT(17, getNumReadIO(bm), "check number of read I/Os");
+    ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+    CHECK(shutdownBufferPool(bm));
+    
+    // CLOCK hits take the latched path, pinning the first page read ahead still starts the next read-ahead
+    CHECK(initBufferPool(bm, "testbuffer.bin", 16, RS_CLOCK, NULL));
+    for (i = 0; i < 7; i++)
+    {
+        char expected[PAGE_SIZE];
+        CHECK(pinPage(bm, h, i));
+        sprintf(expected, "%s-%i", "Page", i);
+        ASSERT_EQUALS_STRING(expected, h->data, "reading back dummy page content");
+        CHECK(unpinPage(bm, h));
+        // looking at the pool waits for the read-ahead, so pinning its first page is a hit
+        if (i == 1)
+            ASSERT_EQUALS_POOL(poolContents[0], bm, "check pool content after two sequential misses under CLOCK");
+    }
+    ASSERT_EQUALS_POOL(poolContents[1], bm, "check pool content after reading ahead again under CLOCK");
+    ASSERT_EQUALS_INT(14, getNumReadIO(bm), "check number of read I/Os under CLOCK");
+    
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// test serving pages from a memory mapping of the page file
+void
+testMappedPool (void)
+{
+    int i;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    SM_FileHandle fh;
+    SM_PageHandle ph = (SM_PageHandle) malloc(PAGE_SIZE);
+    testName = "Testing memory mapped pool";
+    
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 20);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+    CHECK(mapBufferPool(bm, FALSE));
+    
+    for (i = 0; i < 20; i += 3)
+    {
+        char expected[PAGE_SIZE];
+        CHECK(pinPage(bm, h, i));
+        sprintf(expected, "%s-%i", "Page", i);
+        ASSERT_EQUALS_STRING(expected, h->data, "reading mapped page content");
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_POOL("[18 0],[12 0],[15 0]", bm, "check pool content after random pins");
+    
+    // the page is changed in place and synced when forced
+    CHECK(pinPage(bm, h, 4));
+    sprintf(h->data, "%s-%i", "Mapped", 4);
+    CHECK(markDirty(bm, h));
+    CHECK(unpinPage(bm, h));
+    CHECK(forceFlushPool(bm));
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    CHECK(readBlock(4, &fh, ph));
+    ASSERT_EQUALS_STRING("Mapped-4", ph, "reading back page written through the mapping");
+    
+    // pinning past the end of the file grows it, forcing the page stores the new page count
+    CHECK(pinPage(bm, h, 25));
+    ASSERT_EQUALS_STRING("", h->data, "new page is zero filled");
+    CHECK(markDirty(bm, h));
+    CHECK(unpinPage(bm, h));
+    CHECK(forceFlushPool(bm));
+    CHECK(closePageFile(&fh));
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    ASSERT_EQUALS_INT(26, fh.totalNumPages, "file grew to hold the new page");
+    CHECK(closePageFile(&fh));
+    
+    // the pool cannot be remapped once it holds pages
+    ASSERT_ERROR(mapBufferPool(bm, TRUE), "mapping a pool that holds pages");
+    ASSERT_ERROR(startBackgroundWriter(bm), "background writer on a mapped pool");
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    
+    free(ph);
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// test a pool reading and writing its page file with direct I/O
+void
+testDirectPool (void)
+{
+    int i;
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    SM_FileHandle fh;
+    SM_PageHandle ph = (SM_PageHandle) malloc(PAGE_SIZE);
+    testName = "Testing direct I/O pool";
+    
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 20);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+    CHECK(directBufferPool(bm));
+    ASSERT_ERROR(mapBufferPool(bm, FALSE), "mapping a direct pool");
+    
+    for (i = 0; i < 20; i++)
+    {
+        char expected[PAGE_SIZE];
+        CHECK(pinPage(bm, h, i));
+        sprintf(expected, "%s-%i", "Page", i);
+        ASSERT_EQUALS_STRING(expected, h->data, "reading page content with direct I/O");
+        if (i % 5 == 0)
+        {
+            sprintf(h->data, "%s-%i", "Direct", i);
+            CHECK(markDirty(bm, h));
+        }
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_INT(4, getNumWriteIO(bm), "check number of write I/Os");
+    ASSERT_ERROR(directBufferPool(bm), "reopening a pool that holds pages");
+    CHECK(shutdownBufferPool(bm));
+    
+    // the evicted and flushed pages reached the file
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    for (i = 0; i < 20; i += 5)
+    {
+        char expected[PAGE_SIZE];
+        CHECK(readBlock(i, &fh, ph));
+        sprintf(expected, "%s-%i", "Direct", i);
+        ASSERT_EQUALS_STRING(expected, ph, "reading back page written with direct I/O");
+    }
+    CHECK(closePageFile(&fh));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    
+    free(ph);
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// flip one byte offset bytes behind the first place content is stored in the file
+void
+corruptPage (char *fileName, char *content, int offset)
+{
+    FILE *file = fopen(fileName, "r+b");
+    long size, i;
+    char *data;
+    
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    data = (char *) malloc(size);
+    fseek(file, 0, SEEK_SET);
+    if (fread(data, 1, size, file) == (size_t) size)
+        for (i = 0; i + (long) strlen(content) < size; i++)
+            if (memcmp(data + i, content, strlen(content)) == 0)
+            {
+                fseek(file, i + strlen(content) + offset, SEEK_SET);
+                fputc(data[i + strlen(content) + offset] ^ 1, file);
+                break;
+            }
+    fclose(file);
+    free(data);
+}
+
+// test a pool over a page file whose pages carry checksums
+void
+testChecksummedPool (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    testName = "Testing checksummed pages";
+    
+    CHECK(createChecksummedPageFile("testbuffer.bin"));
+    createDummyPages(bm, 10);
+    corruptPage("testbuffer.bin", "Page-4", 0);
+    
+    // the damaged page is not cached, its frame stays free
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+    CHECK(pinPage(bm, h, 3));
+    CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_INT(RC_PAGE_CHECKSUM_FAILED, pinPage(bm, h, 4), "pinning a corrupted page");
+    ASSERT_EQUALS_POOL("[3 0],[-1 0],[-1 0]", bm, "check pool content after the failed pin");
+    CHECK(pinPage(bm, h, 5));
+    ASSERT_EQUALS_STRING("Page-5", h->data, "reading page content");
+    CHECK(unpinPage(bm, h));
+    CHECK(shutdownBufferPool(bm));
+    
+    // a read-ahead over the damaged page caches none of its pages, the others are read again when pinned
+    CHECK(initBufferPool(bm, "testbuffer.bin", 16, RS_LRU, NULL));
+    CHECK(pinPage(bm, h, 0));
+    CHECK(unpinPage(bm, h));
+    CHECK(pinPage(bm, h, 1));
+    CHECK(unpinPage(bm, h));
+    CHECK(pinPage(bm, h, 3));
+    ASSERT_EQUALS_STRING("Page-3", h->data, "reading page content after the failed read-ahead");
+    CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_INT(RC_PAGE_CHECKSUM_FAILED, pinPage(bm, h, 4), "pinning a corrupted page");
+    CHECK(shutdownBufferPool(bm));
+
+    // ARC reuses the frame of the failed pin before it evicts a page
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_ARC, NULL));
+    CHECK(pinPage(bm, h, 0));
+    CHECK(unpinPage(bm, h));
+    CHECK(pinPage(bm, h, 1));
+    CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_INT(RC_PAGE_CHECKSUM_FAILED, pinPage(bm, h, 4), "pinning a corrupted page");
+    CHECK(pinPage(bm, h, 5));
+    CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_POOL("[0 0],[1 0],[5 0]", bm, "check pool content after the failed pin");
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// pages of a compressed file pass through the pool like any other
+void
+testCompressedPool (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    char expected[64];
+    int i;
+    testName = "Testing compressed pages";
+    
+    CHECK(createCompressedPageFile("testbuffer.bin"));
+    createDummyPages(bm, 100);
+    
+    // pages are read ahead and flushed in runs
+    CHECK(initBufferPool(bm, "testbuffer.bin", 16, RS_LRU, NULL));
+    ASSERT_TRUE((mapBufferPool(bm, 0) != RC_OK), "mapping a compressed file should return an error.");
+    for (i = 0; i < 100; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        sprintf(expected, "%s-%i", "Page", i);
+        ASSERT_EQUALS_STRING(expected, h->data, "reading page content");
+        sprintf(h->data, "%s-%i", "Compressed", i);
+        CHECK(markDirty(bm, h));
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(forceFlushPool(bm));
+    CHECK(shutdownBufferPool(bm));
+    
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+    for (i = 99; i >= 0; i--)
+    {
+        CHECK(pinPage(bm, h, i));
+        sprintf(expected, "%s-%i", "Compressed", i);
+        ASSERT_EQUALS_STRING(expected, h->data, "reading page content after reopening");
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    
+    // a page that does not decompress is an error, not an empty page a write would put over the data
+    CHECK(createCompressedPageFile("testbuffer.bin"));
+    createDummyPages(bm, 10);
+    // "Page-4" and a '\0' are stored as they are, the distance of the match of zeros behind them becomes 0
+    corruptPage("testbuffer.bin", "Page-4", 1);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+    ASSERT_EQUALS_INT(RC_PAGE_CORRUPT, pinPage(bm, h, 4), "pinning a corrupted compressed page");
+    ASSERT_EQUALS_POOL("[-1 0],[-1 0],[-1 0]", bm, "check pool content after the failed pin");
+    CHECK(pinPage(bm, h, 5));
+    ASSERT_EQUALS_STRING("Page-5", h->data, "reading page content");
+    CHECK(unpinPage(bm, h));
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// a pool takes the page size of its file, frames hold whole 16KB pages
+void
+testLargePagePool (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    int pageSize = 16384;
+    char expected[64];
+    int i;
+    testName = "Testing pools over larger pages";
+    
+    CHECK(createPageFileWithOptions("testbuffer.bin", pageSize, 0));
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+    ASSERT_EQUALS_INT(pageSize, bm->pageSize, "pool page size is the one of its file");
+    for (i = 0; i < 20; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        sprintf(h->data, "%s-%i", "Page", i);
+        sprintf(h->data + pageSize - 32, "%s-%i", "End", i);
+        CHECK(markDirty(bm, h));
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(shutdownBufferPool(bm));
+    
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+    for (i = 19; i >= 0; i--)
+    {
+        CHECK(pinPage(bm, h, i));
+        sprintf(expected, "%s-%i", "Page", i);
+        ASSERT_EQUALS_STRING(expected, h->data, "reading page content");
+        sprintf(expected, "%s-%i", "End", i);
+        ASSERT_EQUALS_STRING(expected, h->data + pageSize - 32, "reading the end of the page");
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+void
+testWritePages (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    char *pages[10], expected[64];
+    PageNumber *frames;
+    int i;
+    testName = "Testing pages written around the frames";
+    
+    CHECK(createPageFile("testbuffer.bin"));
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+    CHECK(pinPage(bm, h, 0));
+    sprintf(h->data, "%s-%i", "Page", 0);
+    CHECK(markDirty(bm, h));
+    for (i = 0; i < 10; i++)
+    {
+        pages[i] = calloc(PAGE_SIZE, 1);
+        sprintf(pages[i], "%s-%i", "Bulk", i);
+    }
+    ASSERT_ERROR(writePages(bm, 0, 10, pages), "a pinned page is not overwritten");
+    CHECK(unpinPage(bm, h));
+    CHECK(writePages(bm, 0, 10, pages));
+    ASSERT_EQUALS_INT(10, getNumWriteIO(bm), "the pages were written at once");
+    frames = getFrameContents(bm);
+    ASSERT_TRUE(frames[0] == 0 && frames[1] == NO_PAGE && frames[2] == NO_PAGE, "the pages took no frame");
+    free(frames);
+    CHECK(writePages(bm, 14, 1, pages + 9));
+    CHECK(pinPage(bm, h, 0));
+    ASSERT_EQUALS_STRING("Bulk-0", h->data, "the cached page took the new contents");
+    CHECK(unpinPage(bm, h));
+    CHECK(shutdownBufferPool(bm));
+    
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+    CHECK(pinPage(bm, h, 14));
+    ASSERT_EQUALS_STRING("Bulk-9", h->data, "the file grew to the page");
+    CHECK(unpinPage(bm, h));
+    CHECK(pinPage(bm, h, 12));
+    ASSERT_EQUALS_STRING("", h->data, "the pages in between are empty");
+    CHECK(unpinPage(bm, h));
+    for (i = 9; i >= 0; i--)
+    {
+        CHECK(pinPage(bm, h, i));
+        sprintf(expected, "%s-%i", "Bulk", i);
+        ASSERT_EQUALS_STRING(expected, h->data, "reading page content");
+        CHECK(unpinPage(bm, h));
+        free(pages[i]);
+    }
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// makes writes that would take a file past the given size fail, RLIM_INFINITY lifts the limit again
+void
+limitFileSize (rlim_t bytes)
+{
+    struct rlimit limit;
+    getrlimit(RLIMIT_FSIZE, &limit);
+    limit.rlim_cur = (bytes == RLIM_INFINITY) ? limit.rlim_max : bytes;
+    setrlimit(RLIMIT_FSIZE, &limit);
+}
+
+// test that a page that cannot be written back stays dirty in its frame and the error reaches the caller
+void
+testFailedWriteBack (void)
+{
+    ReplacementStrategy strategies[] = { RS_FIFO, RS_LRU, RS_CLOCK, RS_LFU, RS_LRU_K, RS_ARC };
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    int s, i;
+    testName = "Testing failed write backs";
+    
+    // the file size limit makes growing the file fail with EFBIG instead of killing the process
+    signal(SIGXFSZ, SIG_IGN);
+    for (s = 0; s < 6; s++)
+    {
+        CHECK(createPageFile("testbuffer.bin"));
+        CHECK(initBufferPool(bm, "testbuffer.bin", 3, strategies[s], NULL));
+        // pages far past the end of the file are only written once the file may grow that far
+        for (i = 100; i < 103; i++)
+        {
+            CHECK(pinPage(bm, h, i));
+            sprintf(h->data, "%s-%i", "Page", h->pageNum);
+            CHECK(markDirty(bm, h));
+            CHECK(unpinPage(bm, h));
+        }
+        limitFileSize(64 * PAGE_SIZE);
+        h->pageNum = 100;
+        ASSERT_ERROR(forcePage(bm, h), "forcing a page that cannot be written");
+        ASSERT_ERROR(pinPage(bm, h, 0), "evicting a page that cannot be written");
+        ASSERT_ERROR(forceFlushPool(bm), "flushing pages that cannot be written");
+        ASSERT_ERROR(shutdownBufferPool(bm), "shutting down with pages that cannot be written");
+        ASSERT_EQUALS_POOL("[100x0],[101x0],[102x0]", bm, "the pages stay dirty in their frames");
+        ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+        
+        limitFileSize(RLIM_INFINITY);
+        CHECK(pinPage(bm, h, 0));
+        CHECK(unpinPage(bm, h));
+        CHECK(shutdownBufferPool(bm));
+        CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+        for (i = 100; i < 103; i++)
+        {
+            char expected[PAGE_SIZE];
+            CHECK(pinPage(bm, h, i));
+            sprintf(expected, "%s-%i", "Page", i);
+            ASSERT_EQUALS_STRING(expected, h->data, "the page was written once the file could grow");
+            CHECK(unpinPage(bm, h));
+        }
+        CHECK(shutdownBufferPool(bm));
+        CHECK(destroyPageFile("testbuffer.bin"));
+    }
+    
+    // the background writer leaves the pages it cannot write dirty and writes them once it can
+    CHECK(createPageFile("testbuffer.bin"));
+    CHECK(initBufferPool(bm, "testbuffer.bin", 8, RS_LRU, NULL));
+    for (i = 100; i < 104; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        sprintf(h->data, "%s-%i", "Page", h->pageNum);
+        CHECK(markDirty(bm, h));
+        CHECK(unpinPage(bm, h));
+    }
+    limitFileSize(64 * PAGE_SIZE);
+    CHECK(startBackgroundWriter(bm));
+    usleep(50000);
+    ASSERT_EQUALS_POOL("[100x0],[101x0],[102x0],[103x0],[-1 0],[-1 0],[-1 0],[-1 0]", bm, "the writer left the pages dirty");
+    ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+    limitFileSize(RLIM_INFINITY);
+    for (i = 0; i < 2000 && getNumWriteIO(bm) < 2; i++)
+        usleep(1000);
+    CHECK(stopBackgroundWriter(bm));
+    ASSERT_EQUALS_POOL("[100 0],[101 0],[102x0],[103x0],[-1 0],[-1 0],[-1 0],[-1 0]", bm, "the writer cleaned the coldest pages once it could");
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    signal(SIGXFSZ, SIG_DFL);
+    
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
 int
 main (void)
 {
     initStorageManager();
     testName = "";
-   // testLRU_K();
+    testLRU_K();
+    testLFU();
+    testLRU_KScan();
+    testARC();
+    testBackgroundWriter();
+    testConcurrentPins();
+    testConcurrentAttach();
+    testReadAhead();
+    testMappedPool();
+    testDirectPool();
+    testChecksummedPool();
+    testCompressedPool();
+    testLargePagePool();
+    testWritePages();
+    testFailedWriteBack();
    // testReadPage();
    testClock();
     testError();
+    testMultiplePools();
+    testSharedPool();
     return 0;
 }
\ No newline at end of file
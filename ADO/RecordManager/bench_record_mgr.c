@@ -0,0 +1,230 @@
+#include "record_mgr.h"
+#include "buffer_mgr.h"
+#include "storage_mgr.h"
+#include "dberror.h"
+#include "tables.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* benchmark table */
+#define BENCHTABLE "benchtable"
+
+/* inserts after random deletes: the table is filled with BASE_ROWS rows, DELETE_PERCENT of them are deleted at random and
+   NUM_INSERTS rows are inserted, first into the holes the deletes left, then onto new pages. The inserts are timed in
+   windows of INSERT_WINDOW rows; with the free-space map the cost per insert should stay flat across the windows */
+#define BASE_ROWS 1000000
+#define DELETE_PERCENT 50
+#define NUM_INSERTS 10000000
+#define INSERT_WINDOW 1000000
+
+/* bulk load: BULK_ROWS rows go into an empty table once by insertRecord, one row per call like the loop of test_assign3_1.c,
+   and once by insertRecords, BULK_BATCH_ROWS rows per call */
+#define BULK_ROWS 2000000
+#define BULK_BATCH_ROWS 100000
+
+/* frames of the buffer pool the record manager caches the table in */
+#define POOL_SIZE 1000
+
+/* prototypes for benchmark functions */
+static void benchInsertAfterDeletes(void);
+static void benchBulkInsert(void);
+
+/* helpers */
+static double elapsedNs(struct timespec *start, struct timespec *end);
+static Schema *benchSchema(void);
+static void fillRecord(Record *record, Schema *schema, int key);
+
+/* main function running all benchmarks */
+int
+main (void)
+{
+  benchInsertAfterDeletes();
+  benchBulkInsert();
+
+  return 0;
+}
+
+static double
+elapsedNs(struct timespec *start, struct timespec *end)
+{
+  return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+/* the schema of the test tables: an int key, a 4 byte string and an int */
+static Schema *
+benchSchema(void)
+{
+  char *names[] = { "a", "b", "c" };
+  DataType dt[] = { DT_INT, DT_STRING, DT_INT };
+  int sizes[] = { 0, 4, 0 };
+  int keys[] = { 0 };
+  char **cpNames = (char **) malloc(sizeof(char *) * 3);
+  DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 3);
+  int *cpSizes = (int *) malloc(sizeof(int) * 3);
+  int *cpKeys = (int *) malloc(sizeof(int));
+  int i;
+
+  for (i = 0; i < 3; i++)
+    {
+      cpNames[i] = (char *) malloc(2);
+      strcpy(cpNames[i], names[i]);
+    }
+  memcpy(cpDt, dt, sizeof(dt));
+  memcpy(cpSizes, sizes, sizeof(sizes));
+  memcpy(cpKeys, keys, sizeof(keys));
+  return createSchema(3, cpNames, cpDt, cpSizes, 1, cpKeys);
+}
+
+/* set the attributes of "record" the way the rows with key "key" look */
+static void
+fillRecord(Record *record, Schema *schema, int key)
+{
+  Value *value;
+
+  MAKE_VALUE(value, DT_INT, key);
+  CHECK(setAttr(record, schema, 0, value));
+  freeVal(value);
+  MAKE_STRING_VALUE(value, "abcd");
+  CHECK(setAttr(record, schema, 1, value));
+  freeVal(value);
+  MAKE_VALUE(value, DT_INT, key % 7);
+  CHECK(setAttr(record, schema, 2, value));
+  freeVal(value);
+}
+
+/* insert NUM_INSERTS rows into a table whose pages random deletes left half empty */
+void
+benchInsertAfterDeletes(void)
+{
+  BM_BufferPool *pool = MAKE_POOL();
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  Schema *schema = benchSchema();
+  Record *record;
+  RID *rids = (RID *) malloc(sizeof(RID) * BASE_ROWS);
+  struct timespec start, end, windowStart;
+  int i, j, numDeletes = 0, reads, writes;
+
+  printf("insert after delete benchmark (%i rows, %i%% deleted at random, %i inserts)\n", BASE_ROWS, DELETE_PERCENT, NUM_INSERTS);
+
+  CHECK(initSharedBufferPool(pool, POOL_SIZE, PAGE_SIZE, RS_LRU, NULL));
+  CHECK(initRecordManager(pool));
+  CHECK(createTable(BENCHTABLE, schema));
+  CHECK(openTable(table, BENCHTABLE));
+  CHECK(createRecord(&record, schema));
+
+  for (i = 0; i < BASE_ROWS; i++)
+    {
+      fillRecord(record, schema, i);
+      CHECK(insertRecord(table, record));
+      rids[i] = record->id;
+    }
+  srand(42);
+  for (i = 0; i < BASE_ROWS; i++)
+    if (rand() % 100 < DELETE_PERCENT)
+      {
+        CHECK(deleteRecord(table, rids[i]));
+        numDeletes++;
+      }
+  printf("%i rows on %i pages, %i deleted\n", BASE_ROWS, rids[BASE_ROWS - 1].page + 1, numDeletes);
+
+  printf("%12s %14s %14s %10s %10s\n", "inserts", "ns/insert", "inserts/s", "reads", "writes");
+  reads = getNumReadIO(pool);
+  writes = getNumWriteIO(pool);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < NUM_INSERTS; i += INSERT_WINDOW)
+    {
+      clock_gettime(CLOCK_MONOTONIC, &windowStart);
+      for (j = i; j < i + INSERT_WINDOW && j < NUM_INSERTS; j++)
+        {
+          fillRecord(record, schema, BASE_ROWS + j);
+          CHECK(insertRecord(table, record));
+        }
+      clock_gettime(CLOCK_MONOTONIC, &end);
+
+      double ns = elapsedNs(&windowStart, &end) / (j - i);
+      printf("%12i %14.1f %14.0f %10i %10i\n", j, ns, 1e9 / ns, getNumReadIO(pool) - reads, getNumWriteIO(pool) - writes);
+      reads = getNumReadIO(pool);
+      writes = getNumWriteIO(pool);
+    }
+  printf("%i rows on %i pages after %.2f s\n", getNumTuples(table), record->id.page + 1, elapsedNs(&start, &end) / 1e9);
+
+  CHECK(closeTable(table));
+  CHECK(deleteTable(BENCHTABLE));
+  CHECK(shutdownRecordManager());
+  CHECK(shutdownBufferPool(pool));
+  free(pool);
+
+  freeRecord(record);
+  freeSchema(schema);
+  free(rids);
+  free(table);
+}
+
+/* load BULK_ROWS rows into an empty table row by row and in batches */
+void
+benchBulkInsert(void)
+{
+  BM_BufferPool *pool = MAKE_POOL();
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  Schema *schema = benchSchema();
+  Record **records = (Record **) malloc(sizeof(Record *) * BULK_BATCH_ROWS);
+  struct timespec start, end;
+  double ns[2];
+  int i, j, bulk;
+
+  printf("bulk load benchmark (%i rows, %i rows per insertRecords call)\n", BULK_ROWS, BULK_BATCH_ROWS);
+  printf("%14s %14s %14s %10s\n", "", "ns/row", "rows/s", "writes");
+
+  CHECK(initSharedBufferPool(pool, POOL_SIZE, PAGE_SIZE, RS_LRU, NULL));
+  CHECK(initRecordManager(pool));
+  for (i = 0; i < BULK_BATCH_ROWS; i++)
+    CHECK(createRecord(&records[i], schema));
+
+  for (bulk = 0; bulk < 2; bulk++)
+    {
+      int writes = getNumWriteIO(pool);
+      double elapsed = 0;
+
+      CHECK(createTable(BENCHTABLE, schema));
+      CHECK(openTable(table, BENCHTABLE));
+      // only the inserts and the final flush are timed, not filling the records in
+      for (i = 0; i < BULK_ROWS; i += BULK_BATCH_ROWS)
+        {
+          for (j = 0; j < BULK_BATCH_ROWS; j++)
+            fillRecord(records[j], schema, i + j);
+          clock_gettime(CLOCK_MONOTONIC, &start);
+          if (bulk)
+            {
+              CHECK(insertRecords(table, records, BULK_BATCH_ROWS));
+            }
+          else
+            for (j = 0; j < BULK_BATCH_ROWS; j++)
+              CHECK(insertRecord(table, records[j]));
+          clock_gettime(CLOCK_MONOTONIC, &end);
+          elapsed += elapsedNs(&start, &end);
+        }
+      // every page has to reach the disk for the two to compare
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      CHECK(forceFlushPool(pool));
+      clock_gettime(CLOCK_MONOTONIC, &end);
+      elapsed += elapsedNs(&start, &end);
+
+      ns[bulk] = elapsed / BULK_ROWS;
+      printf("%14s %14.1f %14.0f %10i\n", bulk ? "insertRecords" : "insertRecord", ns[bulk], 1e9 / ns[bulk], getNumWriteIO(pool) - writes);
+      CHECK(closeTable(table));
+      CHECK(deleteTable(BENCHTABLE));
+    }
+  printf("speedup %.1fx\n", ns[0] / ns[1]);
+  CHECK(shutdownRecordManager());
+  CHECK(shutdownBufferPool(pool));
+  free(pool);
+
+  for (i = 0; i < BULK_BATCH_ROWS; i++)
+    freeRecord(records[i]);
+  freeSchema(schema);
+  free(records);
+  free(table);
+}
@@ -14,6 +14,9 @@ typedef int RC;
 #define RC_FILE_HANDLE_NOT_INIT 2
 #define RC_WRITE_FAILED 3
 #define RC_READ_NON_EXISTING_PAGE 4
+#define RC_PAGE_CHECKSUM_FAILED 5
+#define RC_PAGE_CORRUPT 6
+#define RC_READ_FAILED 7
 #define RC_ERROR 400 
 #define RC_PINNED_PAGES_IN_BUFFER 500 
 #define RC_NON_EXISTING_PAGE 600
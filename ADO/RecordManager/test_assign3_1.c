@@ -2,6 +2,7 @@
 #include "dberror.h"
 #include "expr.h"
 #include "record_mgr.h"
+#include "storage_mgr.h"
 #include "tables.h"
 #include "test_helper.h"
 
@@ -55,6 +56,13 @@ static void testScans (void);
 static void testScansTwo (void);
 static void testInsertManyRecords(void);
 static void testMultipleScans(void);
+static void testLargePages(void);
+static void testReuseFreedSlots(void);
+static void testVariableLengthRecords(void);
+static void testBulkInsert(void);
+static void testTableStats(void);
+static void testGrowLastSlot(void);
+static void testShutdownWithOpenTable(void);
 
 // struct for test records
 typedef struct TestRecord {
@@ -84,6 +92,13 @@ main (void)
 	testScans();
 	testScansTwo();
 	testMultipleScans();
+	testLargePages();
+	testReuseFreedSlots();
+	testVariableLengthRecords();
+	testBulkInsert();
+	testTableStats();
+	testGrowLastSlot();
+	testShutdownWithOpenTable();
 
 	return 0;
 }
@@ -674,3 +689,476 @@ testRecord(Schema *schema, int a, char *b, int c)
 
 	return result;
 }
+
+// ************************************************************
+void
+testLargePages(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	TestRecord inserts[1000];
+	int numInserts = 1000, pageSize = 16384, i;
+	Record *r;
+	RID *rids;
+	Schema *schema;
+	testName = "test a table on 16KB pages holding four times the records per page";
+	schema = testSchema();
+	rids = (RID *) malloc(sizeof(RID) * numInserts);
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTableWithPageSize("test_table_t", schema, pageSize));
+	TEST_CHECK(openTable(table, "test_table_t"));
+	for(i = 0; i < numInserts; i++)
+	{
+		inserts[i].a = i;
+		inserts[i].b = "abcd";
+		inserts[i].c = i % 7;
+		r = fromTestRecord(schema, inserts[i]);
+		TEST_CHECK(insertRecord(table, r));
+		rids[i] = r->id;
+	}
+	ASSERT_EQUALS_INT(3, rids[numInserts - 1].page, "two 16KB pages hold the 1000 records");
+	for(i = 0; i < numInserts; i++)
+	{
+		TEST_CHECK(getRecord(table, rids[i], r));
+		ASSERT_EQUALS_RECORDS(fromTestRecord(schema, inserts[i]), r, schema, "compare records");
+	}
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_t"));
+	TEST_CHECK(shutdownRecordManager());
+
+	free(rids);
+	freeRecord(r);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testReuseFreedSlots(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numInserts = 2000, numDeletes = 0, i;
+	Record *r, *found;
+	RID *rids;
+	Schema *schema;
+	testName = "test inserts fill the slots deleted records freed";
+	schema = testSchema();
+	rids = (RID *) malloc(sizeof(RID) * numInserts);
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_u", schema));
+	TEST_CHECK(openTable(table, "test_table_u"));
+	TEST_CHECK(createRecord(&found, schema));
+	for(i = 0; i < numInserts; i++)
+	{
+		r = testRecord(schema, i, "abcd", i % 5);
+		TEST_CHECK(insertRecord(table, r));
+		rids[i] = r->id;
+		freeRecord(r);
+	}
+	ASSERT_TRUE(rids[numInserts - 1].page > 1, "the records span several pages");
+
+	// free every third slot, the freed slots are reused in page and slot order
+	for(i = 0; i < numInserts; i += 3, numDeletes++)
+		TEST_CHECK(deleteRecord(table, rids[i]));
+	ASSERT_EQUALS_INT(numInserts - numDeletes, getNumTuples(table), "deletes lower the tuple count");
+	ASSERT_TRUE(getRecord(table, rids[0], found) == RC_RM_NO_TUPLE_WITH_GIVEN_RID, "a deleted record is gone");
+	ASSERT_TRUE(deleteRecord(table, rids[0]) == RC_RM_NO_TUPLE_WITH_GIVEN_RID, "a record is deleted once");
+	ASSERT_TRUE(rids[0].page == 2, "page 1 holds the free-space map");
+	found->id.page = 1;
+	found->id.slot = 0;
+	ASSERT_TRUE(getRecord(table, found->id, found) == RC_RM_NO_TUPLE_WITH_GIVEN_RID, "the free-space map holds no records");
+	for(i = 0; i < numInserts; i += 3)
+	{
+		r = testRecord(schema, numInserts + i, "wxyz", 0);
+		TEST_CHECK(insertRecord(table, r));
+		ASSERT_TRUE(r->id.page == rids[i].page && r->id.slot == rids[i].slot, "the insert took the freed slot");
+		TEST_CHECK(getRecord(table, rids[i], found));
+		ASSERT_EQUALS_RECORDS(r, found, schema, "compare records");
+		freeRecord(r);
+	}
+	ASSERT_EQUALS_INT(numInserts, getNumTuples(table), "every slot is in use again");
+
+	// a new record only goes to a fresh page once the table is full
+	r = testRecord(schema, -1, "full", 0);
+	TEST_CHECK(insertRecord(table, r));
+	ASSERT_TRUE(r->id.page > rids[numInserts - 1].page || (r->id.page == rids[numInserts - 1].page && r->id.slot > rids[numInserts - 1].slot), "the table was full");
+	freeRecord(r);
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_u"));
+	TEST_CHECK(shutdownRecordManager());
+
+	free(rids);
+	freeRecord(found);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testVariableLengthRecords(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	int numInserts = 400, numDeletes = 9, numFound = 0, foundMoved = 0, i;
+	char longString[101];
+	Record *r, *found;
+	RID *rids;
+	Schema *schema;
+	Expr *sel, *left, *right;
+	RC rc;
+	testName = "test records store only the characters of their strings";
+	schema = testSchema();
+	schema->typeLength[1] = 100;
+	memset(longString, 'v', 100);
+	longString[100] = '\0';
+	rids = (RID *) malloc(sizeof(RID) * numInserts);
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_v", schema));
+	TEST_CHECK(openTable(table, "test_table_v"));
+	TEST_CHECK(createRecord(&found, schema));
+	for(i = 0; i < numInserts; i++)
+	{
+		r = testRecord(schema, i, "x", i % 3);
+		TEST_CHECK(insertRecord(table, r));
+		rids[i] = r->id;
+		freeRecord(r);
+	}
+	// 105 bytes wide, a 4KB page would hold 39 of them
+	ASSERT_EQUALS_INT(2, rids[199].page, "a 4KB page holds 200 records with short strings");
+
+	// a record growing on a full page moves and leaves a forwarding pointer
+	r = testRecord(schema, 0, longString, 0);
+	r->id = rids[0];
+	TEST_CHECK(updateRecord(table, r));
+	TEST_CHECK(getRecord(table, rids[0], found));
+	ASSERT_EQUALS_RECORDS(r, found, schema, "the moved record is found by its id");
+	freeRecord(r);
+
+	// once deletes free enough bytes a record grows in place, the page is compacted
+	for(i = 2; i < 2 + numDeletes; i++)
+		TEST_CHECK(deleteRecord(table, rids[i]));
+	r = testRecord(schema, 11, longString, 2);
+	r->id = rids[11];
+	TEST_CHECK(updateRecord(table, r));
+	TEST_CHECK(getRecord(table, rids[11], found));
+	ASSERT_EQUALS_RECORDS(r, found, schema, "the record grew in place");
+	freeRecord(r);
+	r = testRecord(schema, 1, "y", 1);
+	r->id = rids[1];
+	TEST_CHECK(updateRecord(table, r));
+	TEST_CHECK(getRecord(table, rids[1], found));
+	ASSERT_EQUALS_RECORDS(r, found, schema, "the record was updated in place");
+	freeRecord(r);
+
+	// a scan meets every record once, the moved one by the id of its home slot
+	MAKE_CONS(left, stringToValue("i1000000"));
+	MAKE_ATTRREF(right, 0);
+	MAKE_BINOP_EXPR(sel, right, left, OP_COMP_SMALLER);
+	TEST_CHECK(startScan(table, sc, sel));
+	while((rc = next(sc, found)) == RC_OK)
+	{
+		numFound++;
+		if(found->id.page == rids[0].page && found->id.slot == rids[0].slot)
+		{
+			r = testRecord(schema, 0, longString, 0);
+			ASSERT_EQUALS_RECORDS(r, found, schema, "the scan found the moved record");
+			freeRecord(r);
+			foundMoved++;
+		}
+	}
+	ASSERT_TRUE(rc == RC_RM_NO_MORE_TUPLES, "the scan ended");
+	TEST_CHECK(closeScan(sc));
+	ASSERT_EQUALS_INT(numInserts - numDeletes, numFound, "the scan found every record");
+	ASSERT_EQUALS_INT(1, foundMoved, "the scan found the moved record once");
+
+	// a record shrinking back fits its home slot again, deleting it drops both
+	r = testRecord(schema, 0, "z", 0);
+	r->id = rids[0];
+	TEST_CHECK(updateRecord(table, r));
+	TEST_CHECK(getRecord(table, rids[0], found));
+	ASSERT_EQUALS_RECORDS(r, found, schema, "the record came home");
+	freeRecord(r);
+	TEST_CHECK(deleteRecord(table, rids[0]));
+	ASSERT_TRUE(getRecord(table, rids[0], found) == RC_RM_NO_TUPLE_WITH_GIVEN_RID, "the record is gone");
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_v"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeExpr(sel);
+	free(rids);
+	freeRecord(found);
+	free(sc);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testBulkInsert(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	int numInserts = 100, numDeletes = 0, numBulk = 20000, numFound = 0, i;
+	Record *r, *found, **bulk;
+	RID *rids;
+	Schema *schema;
+	Expr *sel, *left, *right;
+	RC rc;
+	testName = "test inserting many records at once";
+	schema = testSchema();
+	rids = (RID *) malloc(sizeof(RID) * numInserts);
+	bulk = (Record **) malloc(sizeof(Record *) * numBulk);
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_w", schema));
+	TEST_CHECK(openTable(table, "test_table_w"));
+	TEST_CHECK(createRecord(&found, schema));
+	for(i = 0; i < numInserts; i++)
+	{
+		r = testRecord(schema, -i, "abcd", 0);
+		TEST_CHECK(insertRecord(table, r));
+		rids[i] = r->id;
+		freeRecord(r);
+	}
+	for(i = 0; i < numInserts; i += 4, numDeletes++)
+		TEST_CHECK(deleteRecord(table, rids[i]));
+
+	// the bulk insert fills the freed slots first, then new pages
+	for(i = 0; i < numBulk; i++)
+		bulk[i] = testRecord(schema, i, "wxyz", i % 5);
+	TEST_CHECK(insertRecords(table, bulk, numBulk));
+	ASSERT_TRUE(bulk[0]->id.page == rids[0].page && bulk[0]->id.slot == rids[0].slot, "the first record took a freed slot");
+	ASSERT_TRUE(bulk[numBulk - 1]->id.page > rids[numInserts - 1].page, "the last record went to a new page");
+	ASSERT_EQUALS_INT(numInserts - numDeletes + numBulk, getNumTuples(table), "the tuple count grew once");
+	for(i = 0; i < numBulk; i++)
+	{
+		TEST_CHECK(getRecord(table, bulk[i]->id, found));
+		ASSERT_EQUALS_RECORDS(bulk[i], found, schema, "compare records");
+	}
+
+	// a scan meets every record
+	MAKE_CONS(left, stringToValue("i1000000"));
+	MAKE_ATTRREF(right, 0);
+	MAKE_BINOP_EXPR(sel, right, left, OP_COMP_SMALLER);
+	TEST_CHECK(startScan(table, sc, sel));
+	while((rc = next(sc, found)) == RC_OK)
+		numFound++;
+	ASSERT_TRUE(rc == RC_RM_NO_MORE_TUPLES, "the scan ended");
+	TEST_CHECK(closeScan(sc));
+	ASSERT_EQUALS_INT(numInserts - numDeletes + numBulk, numFound, "the scan found every record");
+
+	// single inserts go on after the bulk loaded pages
+	r = testRecord(schema, numBulk, "last", 0);
+	TEST_CHECK(insertRecord(table, r));
+	ASSERT_TRUE(r->id.page >= bulk[numBulk - 1]->id.page, "the insert took no bulk loaded slot");
+	freeRecord(r);
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_w"));
+	TEST_CHECK(shutdownRecordManager());
+
+	for(i = 0; i < numBulk; i++)
+		freeRecord(bulk[i]);
+	freeExpr(sel);
+	free(bulk);
+	free(rids);
+	freeRecord(found);
+	free(sc);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testTableStats(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	RM_TableStats stats, closed;
+	SM_FileHandle fh;
+	SM_PageHandle ph;
+	int numInserts = 1000, numDeletes = 0, numFound = 0, i;
+	Record *r, *found;
+	RID *rids;
+	Schema *schema;
+	Expr *sel, *left, *right;
+	RC rc;
+	testName = "test the header page keeps the statistics of a table";
+	schema = testSchema();
+	rids = (RID *) malloc(sizeof(RID) * numInserts);
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_x", schema));
+	TEST_CHECK(openTable(table, "test_table_x"));
+	TEST_CHECK(getTableStats(table, &stats));
+	ASSERT_EQUALS_INT(0, stats.numTuples, "a new table is empty");
+	ASSERT_EQUALS_INT(2, stats.numPages, "a new table has its header and FSM page");
+	TEST_CHECK(createRecord(&found, schema));
+	for(i = 0; i < numInserts; i++)
+	{
+		r = testRecord(schema, i, "abcd", i % 5);
+		TEST_CHECK(insertRecord(table, r));
+		rids[i] = r->id;
+		freeRecord(r);
+	}
+	for(i = 0; i < numInserts; i += 5, numDeletes++)
+		TEST_CHECK(deleteRecord(table, rids[i]));
+	TEST_CHECK(getTableStats(table, &stats));
+	ASSERT_EQUALS_INT(numInserts - numDeletes, stats.numTuples, "the statistics count the records");
+	ASSERT_EQUALS_INT(rids[numInserts - 1].page + 1, stats.numPages, "the statistics count the pages");
+	ASSERT_TRUE(stats.deadSlots > 0 && stats.deadSlots <= numDeletes, "the deletes left dead slots");
+
+	// a scan leaves the statistics alone
+	MAKE_CONS(left, stringToValue("i1000000"));
+	MAKE_ATTRREF(right, 0);
+	MAKE_BINOP_EXPR(sel, right, left, OP_COMP_SMALLER);
+	TEST_CHECK(startScan(table, sc, sel));
+	while((rc = next(sc, found)) == RC_OK)
+		numFound++;
+	ASSERT_TRUE(rc == RC_RM_NO_MORE_TUPLES, "the scan ended");
+	TEST_CHECK(closeScan(sc));
+	ASSERT_EQUALS_INT(numInserts - numDeletes, numFound, "the scan found every record");
+	ASSERT_EQUALS_INT(numInserts - numDeletes, getNumTuples(table), "the scan kept the tuple count");
+
+	// a checkpoint brings the header page on disk up to date while the table is open
+	TEST_CHECK(checkpointTable(table));
+	TEST_CHECK(openPageFile("test_table_x", &fh));
+	ph = (SM_PageHandle) malloc(fh.pageSize);
+	TEST_CHECK(readBlock(0, &fh, ph));
+	ASSERT_EQUALS_INT(numInserts - numDeletes, *(int *)ph, "the header page holds the tuple count");
+	TEST_CHECK(closePageFile(&fh));
+	free(ph);
+
+	// the statistics outlive the table being closed, and the record manager being shut down
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_x"));
+	TEST_CHECK(getTableStats(table, &closed));
+	ASSERT_TRUE(stats.numTuples == closed.numTuples && stats.numPages == closed.numPages && stats.deadSlots == closed.deadSlots, "a reopened table has its statistics");
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(shutdownRecordManager());
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(openTable(table, "test_table_x"));
+	ASSERT_EQUALS_INT(numInserts - numDeletes, getNumTuples(table), "the tuple count was read from the header page");
+	TEST_CHECK(getRecord(table, rids[1], found));
+	ASSERT_EQUALS_INT(1, *(int *)(found->data + 1), "the records are still there");
+
+	// inserts take the dead slots again
+	for(i = 0; i < numDeletes; i++)
+	{
+		r = testRecord(schema, numInserts + i, "wxyz", 0);
+		TEST_CHECK(insertRecord(table, r));
+		freeRecord(r);
+	}
+	TEST_CHECK(getTableStats(table, &stats));
+	ASSERT_EQUALS_INT(numInserts, stats.numTuples, "the inserts are counted");
+	ASSERT_EQUALS_INT(0, stats.deadSlots, "no dead slot is left");
+	ASSERT_EQUALS_INT(closed.numPages, stats.numPages, "the inserts took no new page");
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_x"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeExpr(sel);
+	free(rids);
+	freeRecord(found);
+	free(sc);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testGrowLastSlot(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numInserts = 3000, numDeletes = 5, pageSize = 16384, last = 0, length, i;
+	char longString[101];
+	Record *r, *found;
+	RID *rids;
+	Schema *schema;
+	testName = "test growing the last slot of a page after deleting the slots in front of it";
+	schema = testSchema();
+	schema->typeLength[1] = 100;
+	rids = (RID *) malloc(sizeof(RID) * numInserts);
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTableWithPageSize("test_table_y", schema, pageSize));
+	TEST_CHECK(openTable(table, "test_table_y"));
+	TEST_CHECK(createRecord(&found, schema));
+	for(i = 0; i < numInserts; i++)
+	{
+		r = testRecord(schema, i, "x", i % 3);
+		TEST_CHECK(insertRecord(table, r));
+		rids[i] = r->id;
+		if(r->id.page == rids[0].page)
+			last = i;
+		freeRecord(r);
+	}
+	ASSERT_TRUE(rids[last + 1].page != rids[0].page, "the first page is full");
+
+	// the slots in front of the last one are free, it grows from a short string to ever longer ones until it has to move.
+	// The FSM entry of a 16KB page is coarse enough to offer the page itself the moved record, the page stays intact
+	for(i = last - numDeletes; i < last; i++)
+		TEST_CHECK(deleteRecord(table, rids[i]));
+	for(length = 1; length <= 100; length++)
+	{
+		r = testRecord(schema, last, "x", 0);
+		r->id = rids[last];
+		TEST_CHECK(updateRecord(table, r));
+		freeRecord(r);
+		memset(longString, 'v', length);
+		longString[length] = '\0';
+		r = testRecord(schema, last, longString, 0);
+		r->id = rids[last];
+		TEST_CHECK(updateRecord(table, r));
+		TEST_CHECK(getRecord(table, rids[last], found));
+		ASSERT_EQUALS_RECORDS(r, found, schema, "the grown record is found by its id");
+		freeRecord(r);
+		for(i = 0; i < last - numDeletes; i++)
+		{
+			r = testRecord(schema, i, "x", i % 3);
+			TEST_CHECK(getRecord(table, rids[i], found));
+			ASSERT_EQUALS_RECORDS(r, found, schema, "the other records of the page are intact");
+			freeRecord(r);
+		}
+	}
+	ASSERT_EQUALS_INT(numInserts - numDeletes, getNumTuples(table), "the updates kept the tuple count");
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_y"));
+	TEST_CHECK(shutdownRecordManager());
+
+	free(rids);
+	freeRecord(found);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testShutdownWithOpenTable(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	Record *r, *found;
+	Schema *schema;
+	testName = "test the record manager only shuts down once its tables are closed";
+	schema = testSchema();
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_z", schema));
+	TEST_CHECK(openTable(table, "test_table_z"));
+	TEST_CHECK(createRecord(&found, schema));
+	r = testRecord(schema, 1, "aaaa", 3);
+	TEST_CHECK(insertRecord(table, r));
+
+	// the shared pool is kept while the table is attached, the table stays usable
+	ASSERT_TRUE(shutdownRecordManager() != RC_OK, "shutting down with an open table fails");
+	TEST_CHECK(getRecord(table, r->id, found));
+	ASSERT_EQUALS_RECORDS(r, found, schema, "the open table still reads its records");
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_z"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeRecord(r);
+	freeRecord(found);
+	free(table);
+	TEST_DONE();
+}
@@ -10,18 +10,46 @@ typedef struct SM_FileHandle {
 	char *fileName;
 	int totalNumPages;
 	int curPagePos;
+	int pageSize; // bytes in every block of the file, PAGE_SIZE unless it was created with another size
 	void *mgmtInfo;
 } SM_FileHandle;
 
 typedef char* SM_PageHandle;
 
+// page sizes createPageFileWithOptions accepts, powers of two in between
+#define MIN_PAGE_SIZE PAGE_SIZE
+#define MAX_PAGE_SIZE 65536
+
+// options of createPageFileWithOptions
+#define SM_PAGE_CHECKSUMS 1 // see createChecksummedPageFile
+#define SM_PAGE_COMPRESSION 2 // see createCompressedPageFile
+
+// bytes at the end of every page of a checksummed page file that hold its checksum, see createChecksummedPageFile
+#define PAGE_TRAILER_SIZE 4
+
+// SM_IORequest describes one asynchronous transfer of consecutive blocks, it belongs to the caller and
+// has to stay in place from submitBlocks until completeBlocks hands it back
+typedef struct SM_IORequest {
+	int pageNum; // first block of the transfer
+	int numPages; // number of consecutive blocks
+	SM_PageHandle *memPages; // memPages[i] is read from or written to block pageNum + i
+	int write; // 1 writes memPages to the file, 0 reads the blocks into memPages
+	RC result; // outcome, set once the request completed
+	struct SM_IORequest *next; // used by the storage manager while the request is in flight
+	void *iov;
+} SM_IORequest;
+
 /************************************************************
  *                    interface                             *
  ************************************************************/
 /* manipulating page files */
 extern void initStorageManager (void);
 extern RC createPageFile (char *fileName);
+extern RC createChecksummedPageFile (char *fileName);
+extern RC createCompressedPageFile (char *fileName);
+extern RC createPageFileWithOptions (char *fileName, int pageSize, int options);
 extern RC openPageFile (char *fileName, SM_FileHandle *fHandle);
+extern RC openPageFileDirect (char *fileName, SM_FileHandle *fHandle);
 extern RC closePageFile (SM_FileHandle *fHandle);
 extern RC destroyPageFile (char *fileName);
 
@@ -33,11 +61,23 @@ extern RC readPreviousBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readNextBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readLastBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC readBlocks (int pageNum, int numPages, SM_FileHandle *fHandle, SM_PageHandle *memPages);
 
 /* writing blocks to a page file */
 extern RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC writeBlocks (int *pageNums, int numPages, SM_FileHandle *fHandle, SM_PageHandle *memPages);
 extern RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC appendEmptyBlock (SM_FileHandle *fHandle);
 extern RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle);
 
+/* asynchronous block I/O */
+extern RC submitBlocks (SM_FileHandle *fHandle, SM_IORequest **requests, int numRequests);
+extern RC completeBlocks (SM_FileHandle *fHandle, SM_IORequest **completed, int minRequests, int maxRequests, int *numCompleted);
+
+/* memory mapped page files */
+extern RC mapPageFile (SM_FileHandle *fHandle, int sequential);
+extern SM_PageHandle getMappedBlock (int pageNum, SM_FileHandle *fHandle);
+extern RC prefetchMappedBlocks (int pageNum, int numPages, SM_FileHandle *fHandle);
+extern RC flushMappedBlocks (int pageNum, int numPages, SM_FileHandle *fHandle);
+
 #endif
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/stat.h>
 
 #include "storage_mgr.h"
 #include "dberror.h"
@@ -16,6 +17,16 @@ char *testName;
 /* prototypes for test functions */
 static void testCreateOpenClose(void);
 static void testSinglePageContent(void);
+static void testAsyncBlocks(void);
+static void testWriteBlocks(void);
+static void testFileGrowth(void);
+static void testBinaryPages(void);
+static void testDirectBlocks(void);
+static void testChecksums(void);
+static void corruptPage(char *fileName, char *content);
+static void testCompressedPages(void);
+static void fillPage(SM_PageHandle page, int pageNum, int kind);
+static void testPageSizes(void);
 
 /* main function running all tests */
 int
@@ -27,6 +38,14 @@ main (void)
 
   testCreateOpenClose();
   testSinglePageContent();
+  testAsyncBlocks();
+  testWriteBlocks();
+  testFileGrowth();
+  testBinaryPages();
+  testDirectBlocks();
+  testChecksums();
+  testCompressedPages();
+  testPageSizes();
 
   return 0;
 }
@@ -92,8 +111,9 @@ testSinglePageContent(void)
     ASSERT_TRUE((ph[i] == (i % 10) + '0'), "character in page read from disk is the one we expected.");
   printf("reading first block\n");
 
-  // TEST_CHECK(appendEmptyBlock (&fh));
-  // printf("append empty block \n");
+  // writing no longer grows the file, the next block has to be added before it can be read
+  TEST_CHECK(appendEmptyBlock (&fh));
+  printf("append empty block \n");
 
   //Write the current block to page
   for (i=0; i < PAGE_SIZE; i++)
@@ -130,3 +150,544 @@ testSinglePageContent(void)
   
   TEST_DONE();
 }
+
+/* Write and read back pages with asynchronous requests that are in flight together */
+void
+testAsyncBlocks(void)
+{
+  SM_FileHandle fh;
+  SM_IORequest requests[9], readRequest, *submitted[9], *completed[9];
+  SM_PageHandle pages[16], readPages[16];
+  int i, j, numCompleted, total;
+
+  testName = "test asynchronous block I/O";
+
+  for (i = 0; i < 16; i++)
+    {
+      pages[i] = (SM_PageHandle) malloc(PAGE_SIZE);
+      readPages[i] = (SM_PageHandle) malloc(PAGE_SIZE);
+      for (j = 0; j < PAGE_SIZE; j++)
+        pages[i][j] = (i + j) % 26 + 'a';
+    }
+
+  TEST_CHECK(createPageFile (TESTPF));
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+
+  // one request writes pages 0 to 7, eight more write pages 8 to 15 one by one
+  requests[0].pageNum = 0;
+  requests[0].numPages = 8;
+  requests[0].memPages = pages;
+  requests[0].write = 1;
+  submitted[0] = &requests[0];
+  for (i = 1; i < 9; i++)
+    {
+      requests[i].pageNum = 7 + i;
+      requests[i].numPages = 1;
+      requests[i].memPages = &pages[7 + i];
+      requests[i].write = 1;
+      submitted[i] = &requests[i];
+    }
+  TEST_CHECK(submitBlocks (&fh, submitted, 9));
+  for (total = 0; total < 9; total += numCompleted)
+    {
+      TEST_CHECK(completeBlocks (&fh, completed, 1, 9, &numCompleted));
+      for (i = 0; i < numCompleted; i++)
+        TEST_CHECK(completed[i]->result);
+    }
+  ASSERT_TRUE((fh.totalNumPages == 16), "expect the writes to grow the file to 16 pages");
+
+  // reading past the end is refused before anything is submitted
+  readRequest.pageNum = 8;
+  readRequest.numPages = 9;
+  readRequest.memPages = readPages;
+  readRequest.write = 0;
+  submitted[0] = &readRequest;
+  ASSERT_TRUE((submitBlocks (&fh, submitted, 1) == RC_READ_NON_EXISTING_PAGE), "reading past the end of the file should return an error.");
+
+  readRequest.pageNum = 0;
+  readRequest.numPages = 16;
+  TEST_CHECK(submitBlocks (&fh, submitted, 1));
+  TEST_CHECK(completeBlocks (&fh, completed, 1, 1, &numCompleted));
+  ASSERT_TRUE((numCompleted == 1 && completed[0] == &readRequest), "the read is handed back");
+  TEST_CHECK(readRequest.result);
+  for (i = 0; i < 16; i++)
+    ASSERT_TRUE((memcmp(readPages[i], pages[i], PAGE_SIZE) == 0), "page read back is the one written");
+
+  // the synchronous vectored read sees the same pages
+  TEST_CHECK(readBlocks (4, 8, &fh, readPages));
+  for (i = 0; i < 8; i++)
+    ASSERT_TRUE((memcmp(readPages[i], pages[4 + i], PAGE_SIZE) == 0), "page read with readBlocks is the one written");
+  ASSERT_TRUE((fh.curPagePos == 11), "readBlocks leaves the position on the last page read");
+
+  TEST_CHECK(closePageFile (&fh));
+  TEST_CHECK(destroyPageFile (TESTPF));
+
+  for (i = 0; i < 16; i++)
+    {
+      free(pages[i]);
+      free(readPages[i]);
+    }
+
+  TEST_DONE();
+}
+
+/* write scattered pages with one call and read them back */
+void
+testWriteBlocks(void)
+{
+  SM_FileHandle fh;
+  SM_PageHandle pages[10], readPages[6];
+  int firstPages[] = { 0, 1, 2, 3, 4, 5 };
+  int laterPages[] = { 4, 5, 1, 2 };
+  int expected[] = { 0, 8, 9, 3, 6, 7 };
+  int i, j;
+
+  testName = "test vectored block writes";
+
+  for (i = 0; i < 10; i++)
+    {
+      pages[i] = (SM_PageHandle) malloc(PAGE_SIZE);
+      for (j = 0; j < PAGE_SIZE; j++)
+        pages[i][j] = (i * 7 + j) % 26 + 'a';
+    }
+  for (i = 0; i < 6; i++)
+    readPages[i] = (SM_PageHandle) malloc(PAGE_SIZE);
+
+  TEST_CHECK(createPageFile (TESTPF));
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+
+  // six neighbouring pages go out with one write and grow the file
+  TEST_CHECK(writeBlocks (firstPages, 6, &fh, pages));
+  ASSERT_TRUE((fh.totalNumPages == 6), "expect the write to grow the file to 6 pages");
+
+  // two runs of two pages each overwrite pages 4, 5, 1 and 2
+  TEST_CHECK(writeBlocks (laterPages, 4, &fh, pages + 6));
+  ASSERT_TRUE((fh.curPagePos == 2), "writeBlocks leaves the position on the last page written");
+  TEST_CHECK(readBlocks (0, 6, &fh, readPages));
+  for (i = 0; i < 6; i++)
+    ASSERT_TRUE((memcmp(readPages[i], pages[expected[i]], PAGE_SIZE) == 0), "page read back is the one written last");
+
+  // a page may only be written right behind the end of the file
+  firstPages[0] = 7;
+  ASSERT_TRUE((writeBlocks (firstPages, 1, &fh, pages) == RC_WRITE_FAILED), "writing past the end of the file should return an error.");
+  ASSERT_TRUE((fh.totalNumPages == 6), "a refused write leaves the file as it is");
+
+  TEST_CHECK(closePageFile (&fh));
+  TEST_CHECK(destroyPageFile (TESTPF));
+
+  for (i = 0; i < 10; i++)
+    free(pages[i]);
+  for (i = 0; i < 6; i++)
+    free(readPages[i]);
+
+  TEST_DONE();
+}
+
+/* grow a file in one step and check the page count survives reopening it */
+void
+testFileGrowth(void)
+{
+  SM_FileHandle fh;
+  SM_PageHandle ph;
+  int i;
+
+  testName = "test file growth";
+
+  ph = (SM_PageHandle) malloc(PAGE_SIZE);
+
+  TEST_CHECK(createPageFile (TESTPF));
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  TEST_CHECK(ensureCapacity (100000, &fh));
+  ASSERT_TRUE((fh.totalNumPages == 100000), "expect 100000 pages after growing the file");
+
+  // overwriting a page leaves the page count alone
+  memset(ph, 'x', PAGE_SIZE);
+  TEST_CHECK(writeBlock (5, &fh, ph));
+  TEST_CHECK(appendEmptyBlock (&fh));
+  ASSERT_TRUE((fh.totalNumPages == 100001), "expect one more page after appending");
+  TEST_CHECK(closePageFile (&fh));
+
+  // the page count comes from the header, not from the space allocated for the file
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  ASSERT_TRUE((fh.totalNumPages == 100001), "expect the page count to be kept in the file");
+  TEST_CHECK(readLastBlock (&fh, ph));
+  for (i=0; i < PAGE_SIZE; i++)
+    ASSERT_TRUE((ph[i] == 0), "expected zero byte in appended page");
+  ASSERT_TRUE((readBlock (100001, &fh, ph) == RC_READ_NON_EXISTING_PAGE), "reading behind the last page should return an error.");
+  TEST_CHECK(readBlock (5, &fh, ph));
+  ASSERT_TRUE((ph[0] == 'x' && ph[PAGE_SIZE - 1] == 'x'), "overwritten page read back");
+
+  // appending within the space the file already has leaves the header to closePageFile
+  for (i=100001; i < 100010; i++)
+    TEST_CHECK(writeBlock (i, &fh, ph));
+  ASSERT_TRUE((fh.totalNumPages == 100010), "expect the appended pages to count");
+  SM_FileHandle other;
+  TEST_CHECK(openPageFile (TESTPF, &other));
+  ASSERT_TRUE((other.totalNumPages == 100001), "expect the header to be written on close only");
+  TEST_CHECK(closePageFile (&other));
+  TEST_CHECK(closePageFile (&fh));
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  ASSERT_TRUE((fh.totalNumPages == 100010), "expect the page count to be stored on close");
+  TEST_CHECK(readBlock (100009, &fh, ph));
+  ASSERT_TRUE((ph[0] == 'x'), "appended page read back");
+  TEST_CHECK(closePageFile (&fh));
+  TEST_CHECK(destroyPageFile (TESTPF));
+
+  free(ph);
+  TEST_DONE();
+}
+
+/* pages holding zero bytes are written in full */
+void
+testBinaryPages(void)
+{
+  SM_FileHandle fh;
+  SM_PageHandle ph, readPage;
+  int i, pageNum;
+
+  testName = "test binary page content";
+
+  ph = (SM_PageHandle) malloc(PAGE_SIZE);
+  readPage = (SM_PageHandle) malloc(PAGE_SIZE);
+
+  TEST_CHECK(createPageFile (TESTPF));
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+
+  // every other byte is zero, the first one included
+  for (pageNum = 0; pageNum < 3; pageNum++)
+    {
+      for (i=0; i < PAGE_SIZE; i++)
+        ph[i] = (i % 2) ? (char)(i + pageNum) : 0;
+      if (pageNum == 1)
+        {
+          TEST_CHECK(appendEmptyBlock (&fh));
+          TEST_CHECK(readNextBlock (&fh, readPage));
+          TEST_CHECK(writeCurrentBlock (&fh, ph));
+        }
+      else
+        TEST_CHECK(writeBlock (pageNum, &fh, ph));
+    }
+  ASSERT_TRUE((fh.totalNumPages == 3), "expect the writes to grow the file to 3 pages");
+
+  for (pageNum = 0; pageNum < 3; pageNum++)
+    {
+      TEST_CHECK(readBlock (pageNum, &fh, readPage));
+      for (i=0; i < PAGE_SIZE; i++)
+        ASSERT_TRUE((readPage[i] == ((i % 2) ? (char)(i + pageNum) : 0)), "byte read back is the one written");
+    }
+
+  TEST_CHECK(closePageFile (&fh));
+  TEST_CHECK(destroyPageFile (TESTPF));
+
+  free(ph);
+  free(readPage);
+  TEST_DONE();
+}
+
+/* read and write a file opened for direct I/O with aligned and unaligned buffers */
+void
+testDirectBlocks(void)
+{
+  SM_FileHandle fh;
+  SM_IORequest request, *submitted[1];
+  SM_PageHandle pages[4], readPages[4];
+  char *unaligned = (char *) malloc(PAGE_SIZE + 1);
+  int pageNums[] = { 1, 2, 3 };
+  int i, j;
+
+  testName = "test direct block I/O";
+
+  for (i = 0; i < 4; i++)
+    {
+      pages[i] = (SM_PageHandle) malloc(PAGE_SIZE);
+      if (posix_memalign((void **) &readPages[i], PAGE_SIZE, PAGE_SIZE) != 0)
+        readPages[i] = NULL;
+      for (j = 0; j < PAGE_SIZE; j++)
+        pages[i][j] = (i + j) % 26 + 'a';
+    }
+
+  TEST_CHECK(createPageFile (TESTPF));
+  TEST_CHECK(openPageFileDirect (TESTPF, &fh));
+
+  // buffers of any alignment are written, the unaligned ones one block at a time
+  TEST_CHECK(writeBlock (0, &fh, pages[0]));
+  TEST_CHECK(writeBlocks (pageNums, 3, &fh, pages + 1));
+  ASSERT_TRUE((fh.totalNumPages == 4), "expect the writes to grow the file to 4 pages");
+
+  TEST_CHECK(readBlocks (0, 4, &fh, readPages));
+  for (i = 0; i < 4; i++)
+    ASSERT_TRUE((memcmp(readPages[i], pages[i], PAGE_SIZE) == 0), "page read into an aligned buffer is the one written");
+  TEST_CHECK(readBlock (2, &fh, unaligned + 1));
+  ASSERT_TRUE((memcmp(unaligned + 1, pages[2], PAGE_SIZE) == 0), "page read into an unaligned buffer is the one written");
+
+  // asynchronous transfers need aligned buffers
+  request.pageNum = 0;
+  request.numPages = 1;
+  request.memPages = pages;
+  request.write = 1;
+  submitted[0] = &request;
+  if (((size_t) pages[0] & (PAGE_SIZE - 1)) != 0)
+    ASSERT_TRUE((submitBlocks (&fh, submitted, 1) == RC_WRITE_FAILED), "asynchronous write of an unaligned buffer should return an error.");
+
+  TEST_CHECK(closePageFile (&fh));
+  TEST_CHECK(destroyPageFile (TESTPF));
+
+  for (i = 0; i < 4; i++)
+    {
+      free(pages[i]);
+      free(readPages[i]);
+    }
+  free(unaligned);
+
+  TEST_DONE();
+}
+
+/* flip one byte right behind the first place content is stored in the file, like a torn or bit rotten write would */
+void
+corruptPage(char *fileName, char *content)
+{
+  FILE *file = fopen(fileName, "r+b");
+  long size, i;
+  char *data;
+
+  fseek(file, 0, SEEK_END);
+  size = ftell(file);
+  data = (char *) malloc(size);
+  fseek(file, 0, SEEK_SET);
+  if (fread(data, 1, size, file) == (size_t) size)
+    for (i = 0; i + (long) strlen(content) < size; i++)
+      if (memcmp(data + i, content, strlen(content)) == 0)
+        {
+          fseek(file, i + strlen(content), SEEK_SET);
+          fputc(data[i + strlen(content)] ^ 1, file);
+          break;
+        }
+  fclose(file);
+  free(data);
+}
+
+/* pages of a checksummed file are verified when they are read */
+void
+testChecksums(void)
+{
+  SM_FileHandle fh;
+  SM_IORequest request, *submitted[1], *completed[1];
+  SM_PageHandle pages[2];
+  int i, numCompleted;
+
+  testName = "test page checksums";
+
+  for (i = 0; i < 2; i++)
+    {
+      pages[i] = (SM_PageHandle) calloc(PAGE_SIZE, 1);
+      sprintf(pages[i], "Checksummed-%i", i);
+    }
+
+  TEST_CHECK(createChecksummedPageFile (TESTPF));
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  ASSERT_TRUE((mapPageFile (&fh, 0) != RC_OK), "mapping a checksummed file should return an error.");
+  TEST_CHECK(writeBlock (0, &fh, pages[0]));
+  TEST_CHECK(writeBlock (1, &fh, pages[1]));
+  TEST_CHECK(appendEmptyBlock (&fh));
+  TEST_CHECK(readBlocks (0, 2, &fh, pages));
+  ASSERT_TRUE((strcmp(pages[1], "Checksummed-1") == 0), "page read back is the one written");
+  TEST_CHECK(readBlock (2, &fh, pages[1]));
+  TEST_CHECK(closePageFile (&fh));
+
+  // the damage is noticed by every way of reading the page, the file keeps its checksums when reopened
+  corruptPage(TESTPF, "Checksummed-1");
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  TEST_CHECK(readBlock (0, &fh, pages[0]));
+  ASSERT_TRUE((readBlock (1, &fh, pages[1]) == RC_PAGE_CHECKSUM_FAILED), "reading a corrupted page should return an error.");
+  ASSERT_TRUE((readBlocks (0, 2, &fh, pages) == RC_PAGE_CHECKSUM_FAILED), "reading a corrupted page should return an error.");
+
+  request.pageNum = 1;
+  request.numPages = 1;
+  request.memPages = pages;
+  request.write = 0;
+  submitted[0] = &request;
+  TEST_CHECK(submitBlocks (&fh, submitted, 1));
+  TEST_CHECK(completeBlocks (&fh, completed, 1, 1, &numCompleted));
+  ASSERT_TRUE((request.result == RC_PAGE_CHECKSUM_FAILED), "reading a corrupted page asynchronously should return an error.");
+
+  // writing the page again repairs it
+  memset(pages[1], 0, PAGE_SIZE);
+  sprintf(pages[1], "Checksummed-%i", 1);
+  TEST_CHECK(writeBlock (1, &fh, pages[1]));
+  TEST_CHECK(readBlock (1, &fh, pages[1]));
+
+  TEST_CHECK(closePageFile (&fh));
+  TEST_CHECK(destroyPageFile (TESTPF));
+
+  for (i = 0; i < 2; i++)
+    free(pages[i]);
+
+  TEST_DONE();
+}
+
+/* fill a page with padded rows (kind 0), zeros (kind 1) or bytes that do not compress (kind 2) */
+void
+fillPage(SM_PageHandle page, int pageNum, int kind)
+{
+  unsigned int seed = pageNum * 2654435761u + 1;
+  int i;
+
+  memset(page, kind == 0 ? ' ' : 0, PAGE_SIZE);
+  for (i = 0; kind == 0 && i + 64 <= PAGE_SIZE; i += 64)
+    sprintf(page + i, "%d|row %d|", pageNum, i / 64);
+  for (i = 0; kind == 2 && i < PAGE_SIZE; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      page[i] = (char) (seed >> 16);
+    }
+}
+
+/* pages of a compressed file read back as written, wherever the page map put them */
+void
+testCompressedPages(void)
+{
+  SM_FileHandle fh;
+  SM_IORequest request, *submitted[1], *completed[1];
+  SM_PageHandle pages[700], page = (SM_PageHandle) malloc(PAGE_SIZE);
+  int pageNums[700];
+  struct stat fileInfo;
+  int i, numCompleted;
+
+  testName = "test compressed pages";
+
+  for (i = 0; i < 700; i++)
+    {
+      pages[i] = (SM_PageHandle) malloc(PAGE_SIZE);
+      pageNums[i] = i;
+      fillPage(pages[i], i, i % 3);
+    }
+
+  TEST_CHECK(createCompressedPageFile (TESTPF));
+  ASSERT_TRUE((openPageFileDirect (TESTPF, &fh) != RC_OK), "opening a compressed file for direct I/O should return an error.");
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  ASSERT_TRUE((mapPageFile (&fh, 0) != RC_OK), "mapping a compressed file should return an error.");
+  TEST_CHECK(readFirstBlock (&fh, page));
+  ASSERT_TRUE((page[0] == 0 && memcmp(page, page + 1, PAGE_SIZE - 1) == 0), "the first page of a new file is empty");
+
+  // more pages than one page map block has entries for
+  TEST_CHECK(writeBlocks (pageNums, 700, &fh, pages));
+  ASSERT_TRUE((fh.totalNumPages == 700), "expect the writes to grow the file to 700 pages");
+  TEST_CHECK(closePageFile (&fh));
+  stat(TESTPF, &fileInfo);
+  ASSERT_TRUE((fileInfo.st_size < 700 / 2 * PAGE_SIZE), "the file takes less than half the space of its pages");
+
+  // pages change size, the ones growing move
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  TEST_CHECK(readBlocks (0, 700, &fh, pages));
+  for (i = 0; i < 700; i++)
+    {
+      fillPage(page, i, i % 3);
+      ASSERT_TRUE((memcmp(pages[i], page, PAGE_SIZE) == 0), "page read back is the one written");
+    }
+  fillPage(pages[3], 3, 2);
+  fillPage(pages[5], 5, 1);
+  fillPage(pages[7], 7, 0);
+  TEST_CHECK(writeBlock (3, &fh, pages[3]));
+  TEST_CHECK(writeBlock (5, &fh, pages[5]));
+  TEST_CHECK(writeBlock (7, &fh, pages[7]));
+  TEST_CHECK(appendEmptyBlock (&fh));
+  TEST_CHECK(readLastBlock (&fh, page));
+  ASSERT_TRUE((page[0] == 0 && memcmp(page, page + 1, PAGE_SIZE - 1) == 0), "an appended page is empty");
+
+  request.pageNum = 2;
+  request.numPages = 4;
+  request.memPages = pages + 2;
+  request.write = 0;
+  submitted[0] = &request;
+  TEST_CHECK(submitBlocks (&fh, submitted, 1));
+  TEST_CHECK(completeBlocks (&fh, completed, 1, 1, &numCompleted));
+  ASSERT_TRUE((numCompleted == 1 && request.result == RC_OK), "asynchronous read of compressed pages completes");
+  fillPage(page, 3, 2);
+  ASSERT_TRUE((memcmp(pages[3], page, PAGE_SIZE) == 0), "page read asynchronously is the one written");
+  TEST_CHECK(closePageFile (&fh));
+
+  // the page map is kept in the file
+  TEST_CHECK(openPageFile (TESTPF, &fh));
+  ASSERT_TRUE((fh.totalNumPages == 701), "the page count is kept in the file");
+  for (i = 0; i < 700; i++)
+    {
+      TEST_CHECK(readBlock (i, &fh, pages[i]));
+      fillPage(page, i, i == 3 ? 2 : i == 5 ? 1 : i == 7 ? 0 : i % 3);
+      ASSERT_TRUE((memcmp(pages[i], page, PAGE_SIZE) == 0), "page read after reopening is the one written");
+    }
+  TEST_CHECK(closePageFile (&fh));
+  TEST_CHECK(destroyPageFile (TESTPF));
+
+  for (i = 0; i < 700; i++)
+    free(pages[i]);
+  free(page);
+
+  TEST_DONE();
+}
+
+/* files created with a larger page size keep it, with and without checksums and compression */
+void
+testPageSizes(void)
+{
+  SM_FileHandle fh;
+  SM_IORequest request, *submitted[1], *completed[1];
+  SM_PageHandle pages[4], mapped;
+  int pageSize = 16384, options, i, numCompleted;
+
+  testName = "test page sizes";
+
+  ASSERT_TRUE((createPageFileWithOptions (TESTPF, 5000, 0) != RC_OK), "a page size that is not a power of two should return an error.");
+  ASSERT_TRUE((createPageFileWithOptions (TESTPF, MAX_PAGE_SIZE * 2, 0) != RC_OK), "a page size above MAX_PAGE_SIZE should return an error.");
+  ASSERT_TRUE((createPageFileWithOptions (TESTPF, PAGE_SIZE, 4) != RC_OK), "an unknown option should return an error.");
+
+  for (i = 0; i < 4; i++)
+    pages[i] = (SM_PageHandle) malloc(pageSize);
+
+  for (options = 0; options <= (SM_PAGE_CHECKSUMS | SM_PAGE_COMPRESSION); options++)
+    {
+      TEST_CHECK(createPageFileWithOptions (TESTPF, pageSize, options));
+      TEST_CHECK(openPageFile (TESTPF, &fh));
+      ASSERT_TRUE((fh.pageSize == pageSize && fh.totalNumPages == 1), "a new file has one page of the size it was created with");
+      TEST_CHECK(readFirstBlock (&fh, pages[0]));
+      ASSERT_TRUE((pages[0][0] == 0 && memcmp(pages[0], pages[0] + 1, pageSize - 1) == 0), "the first page of a new file is empty");
+
+      // the last bytes of every page tell the pages apart
+      for (i = 0; i < 4; i++)
+        {
+          memset(pages[i], 'a' + i, pageSize);
+          sprintf(pages[i] + pageSize - 16, "page %d end", i);
+          TEST_CHECK(writeBlock (i, &fh, pages[i]));
+        }
+      TEST_CHECK(closePageFile (&fh));
+
+      TEST_CHECK(openPageFile (TESTPF, &fh));
+      ASSERT_TRUE((fh.pageSize == pageSize && fh.totalNumPages == 4), "the page size is kept in the file");
+      TEST_CHECK(readBlocks (0, 4, &fh, pages));
+      for (i = 0; i < 4; i++)
+        ASSERT_TRUE((pages[i][0] == 'a' + i && atoi(pages[i] + pageSize - 11) == i), "page read back is the one written");
+
+      memset(pages[2], 0, pageSize);
+      request.pageNum = 1;
+      request.numPages = 2;
+      request.memPages = pages + 1;
+      request.write = 0;
+      submitted[0] = &request;
+      TEST_CHECK(submitBlocks (&fh, submitted, 1));
+      TEST_CHECK(completeBlocks (&fh, completed, 1, 1, &numCompleted));
+      ASSERT_TRUE((numCompleted == 1 && request.result == RC_OK && pages[2][pageSize - 16] == 'p'), "asynchronous read returns whole pages");
+
+      if (options == 0)
+        {
+          TEST_CHECK(mapPageFile (&fh, 1));
+          mapped = getMappedBlock (3, &fh);
+          ASSERT_TRUE((mapped != NULL && mapped[0] == 'd' && atoi(mapped + pageSize - 11) == 3), "mapped page starts at its page size offset");
+        }
+      TEST_CHECK(closePageFile (&fh));
+      TEST_CHECK(destroyPageFile (TESTPF));
+    }
+
+  for (i = 0; i < 4; i++)
+    free(pages[i]);
+
+  TEST_DONE();
+}